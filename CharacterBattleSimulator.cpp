@@ -0,0 +1,298 @@
+#include "CharacterBattleSimulator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace CharacterSimulation
+{
+
+// Decorrelates neighbouring fight indices (SplitMix64)
+static uint64_t MixSeed(uint64_t Value)
+{
+Value += 0x9e3779b97f4a7c15ull;
+Value = (Value ^ (Value >> 30)) * 0xbf58476d1ce4e5b9ull;
+Value = (Value ^ (Value >> 27)) * 0x94d049bb133111ebull;
+return Value ^ (Value >> 31);
+}
+
+// Strongest damage ability that is ready and affordable at its worst case cost
+static FAbility* ChooseAbility(FCharacter& Character)
+{
+FAbility* Best = nullptr;
+float BestPower = 0.f;
+
+for (FAbility& Ability : Character.Abilities)
+{
+if (!Ability.bDealsDamage || Ability.IsOnCooldown())
+{
+continue;
+}
+
+if (Ability.CostPool != ECostPool::Null && Character.GetAttribute(static_cast<EAttribute>(Ability.CostPool)).CurrentValue < Ability.CostMax)
+{
+continue;
+}
+
+const float MeanPower = (Ability.PowerMin + Ability.PowerMax) * 0.5f;
+
+if (MeanPower > BestPower)
+{
+Best = &Ability;
+BestPower = MeanPower;
+}
+}
+
+return Best;
+}
+
+struct FBattleHit
+{
+uint32_t Attacker = 0;
+uint32_t Target = 0;
+float Power = 0.f;
+float Protection = 0.f;
+};
+
+FBattleOutcome SimulateBattle(const FBattleConfig& Config, uint64_t FightIndex)
+{
+FBattleOutcome Outcome;
+FRandom Random(MixSeed(Config.Seed ^ MixSeed(FightIndex)));
+
+// Reused per thread, assignment keeps the capacity of every nested vector
+thread_local std::vector<FBattleFighter> Fighters;
+thread_local std::vector<uint32_t> Targets;
+thread_local std::vector<FBattleHit> Hits;
+Fighters = Config.Fighters;
+
+int32_t NumAlive[2] = {};
+
+for (const FBattleFighter& Fighter : Fighters)
+{
+NumAlive[Fighter.Team] += Fighter.Character.bDead ? 0 : 1;
+}
+
+while (NumAlive[0] > 0 && NumAlive[1] > 0 && Outcome.Duration < Config.MaxDuration)
+{
+Outcome.Duration += Config.TimeStep;
+
+for (FBattleFighter& Fighter : Fighters)
+{
+if (!Fighter.Character.bDead)
+{
+TickCharacter(Fighter.Character, Config.TimeStep);
+}
+}
+
+// Every fighter alive at the start of the step attacks, and the hits land together afterwards, so the fighter
+// order gives no initiative and a fighter killed in this step still gets its attack in
+Hits.clear();
+
+for (uint32_t Index = 0; Index < Fighters.size(); ++Index)
+{
+FBattleFighter& Attacker = Fighters[Index];
+
+if (Attacker.Character.bDead)
+{
+continue;
+}
+
+FAbility* Ability = ChooseAbility(Attacker.Character);
+
+if (!Ability)
+{
+continue;
+}
+
+// Random living enemy
+Targets.clear();
+
+for (uint32_t Other = 0; Other < Fighters.size(); ++Other)
+{
+if (Fighters[Other].Team != Attacker.Team && !Fighters[Other].Character.bDead)
+{
+Targets.push_back(Other);
+}
+}
+
+if (Targets.empty())
+{
+continue;
+}
+
+FBattleHit& Hit = Hits.emplace_back();
+Hit.Attacker = Index;
+Hit.Target = Targets[Random.NextUInt() % Targets.size()];
+
+if (Ability->CostPool != ECostPool::Null)
+{
+Attacker.Character.GetAttribute(static_cast<EAttribute>(Ability->CostPool)).CurrentValue -= RollAbilityCost(*Ability, Random);
+}
+
+Ability->CooldownTimer = RollAbilityCooldownTime(*Ability, Random);
+Hit.Power = RollAbilityPower(*Ability, Random);
+Hit.Protection = RollProtection(Fighters[Hit.Target].Protection, Random);
+}
+
+for (const FBattleHit& Hit : Hits)
+{
+FAttribute& TargetHealth = Fighters[Hit.Target].Character.GetAttribute(EAttribute::Health);
+
+// Further hits on a target killed in this step only count the damage it still had health for
+const FDamageResult Result = ApplyDamage(TargetHealth, Hit.Power, Hit.Protection);
+Outcome.TeamDamage[Fighters[Hit.Attacker].Team] += TargetHealth.CurrentValue - Result.NewHealth;
+TargetHealth.CurrentValue = Result.NewHealth;
+}
+
+for (FBattleFighter& Fighter : Fighters)
+{
+if (!Fighter.Character.bDead && Fighter.Character.GetAttribute(EAttribute::Health).CurrentValue <= 0.0f)
+{
+Fighter.Character.bDead = true;
+--NumAlive[Fighter.Team];
+}
+}
+}
+
+if (NumAlive[0] == 0 || NumAlive[1] == 0)
+{
+// Both teams can fall in the same step, that is a draw
+Outcome.WinningTeam = NumAlive[0] > 0 ? 0 : NumAlive[1] > 0 ? 1 : -1;
+}
+
+return Outcome;
+}
+
+static FBattleDistribution MakeDistribution(std::vector<float>& Samples)
+{
+FBattleDistribution Distribution;
+
+if (Samples.empty())
+{
+return Distribution;
+}
+
+std::sort(Samples.begin(), Samples.end());
+
+double Sum = 0.0;
+
+for (const float Sample : Samples)
+{
+Sum += Sample;
+}
+
+const auto Percentile = [&Samples](double Fraction)
+{
+return Samples[static_cast<size_t>(Fraction * static_cast<double>(Samples.size() - 1))];
+};
+
+Distribution.Mean = Sum / static_cast<double>(Samples.size());
+Distribution.Min = Samples.front();
+Distribution.P5 = Percentile(0.05);
+Distribution.P50 = Percentile(0.5);
+Distribution.P95 = Percentile(0.95);
+Distribution.Max = Samples.back();
+return Distribution;
+}
+
+FBattleReport RunBattles(const FBattleConfig& Config, uint64_t NumFights, uint32_t NumThreads)
+{
+const auto StartTime = std::chrono::steady_clock::now();
+
+NumThreads = NumThreads > 0 ? NumThreads : std::max(1u, std::thread::hardware_concurrency());
+
+// Each worker folds its outcomes into its own tallies as they arrive. Counts and sorted samples do not depend on
+// which worker played which fight, so the report does not depend on scheduling.
+struct FWorkerTally
+{
+uint64_t Wins[2] = {};
+uint64_t Draws = 0;
+std::vector<float> TimeToKill;
+std::vector<float> TeamDps[2];
+};
+
+std::vector<FWorkerTally> Tallies(NumThreads);
+std::atomic<uint64_t> NextChunk{ 0 };
+const uint64_t ChunkSize = 256;
+
+const auto Worker = [&](FWorkerTally& Tally)
+{
+for (;;)
+{
+const uint64_t Begin = NextChunk.fetch_add(1, std::memory_order_relaxed) * ChunkSize;
+
+if (Begin >= NumFights)
+{
+return;
+}
+
+const uint64_t End = std::min(Begin + ChunkSize, NumFights);
+
+for (uint64_t FightIndex = Begin; FightIndex < End; ++FightIndex)
+{
+const FBattleOutcome Outcome = SimulateBattle(Config, FightIndex);
+
+if (Outcome.WinningTeam < 0)
+{
+++Tally.Draws;
+}
+else
+{
+++Tally.Wins[Outcome.WinningTeam];
+Tally.TimeToKill.push_back(Outcome.Duration);
+}
+
+if (Outcome.Duration > 0.f)
+{
+Tally.TeamDps[0].push_back(Outcome.TeamDamage[0] / Outcome.Duration);
+Tally.TeamDps[1].push_back(Outcome.TeamDamage[1] / Outcome.Duration);
+}
+}
+}
+};
+
+std::vector<std::thread> Threads;
+
+for (uint32_t Index = 1; Index < NumThreads; ++Index)
+{
+Threads.emplace_back(Worker, std::ref(Tallies[Index]));
+}
+
+Worker(Tallies[0]);
+
+for (std::thread& Thread : Threads)
+{
+Thread.join();
+}
+
+FBattleReport Report;
+Report.NumFights = NumFights;
+
+std::vector<float> TimeToKill;
+std::vector<float> TeamDps[2];
+TimeToKill.reserve(NumFights);
+TeamDps[0].reserve(NumFights);
+TeamDps[1].reserve(NumFights);
+
+for (const FWorkerTally& Tally : Tallies)
+{
+Report.Wins[0] += Tally.Wins[0];
+Report.Wins[1] += Tally.Wins[1];
+Report.Draws += Tally.Draws;
+TimeToKill.insert(TimeToKill.end(), Tally.TimeToKill.begin(), Tally.TimeToKill.end());
+TeamDps[0].insert(TeamDps[0].end(), Tally.TeamDps[0].begin(), Tally.TeamDps[0].end());
+TeamDps[1].insert(TeamDps[1].end(), Tally.TeamDps[1].begin(), Tally.TeamDps[1].end());
+}
+
+Report.TimeToKill = MakeDistribution(TimeToKill);
+Report.TeamDps[0] = MakeDistribution(TeamDps[0]);
+Report.TeamDps[1] = MakeDistribution(TeamDps[1]);
+
+Report.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+Report.FightsPerSecond = Report.Seconds > 0.0 ? static_cast<double>(NumFights) / Report.Seconds : 0.0;
+return Report;
+}
+
+}
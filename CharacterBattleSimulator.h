@@ -0,0 +1,84 @@
+// ============================================================================
+// CharacterBattleSimulator.h
+// ============================================================================
+// Headless Monte Carlo battles on top of CharacterSimulationCore:
+//
+// - 1v1 and NvM fights between two teams
+// - Real regeneration, ability, protection and damage rules
+// - Attacks within a step land together; only damage abilities are cast
+// - Deterministic per-fight seeds, independent of the thread count
+// - Win rate, time to kill and DPS distributions
+//
+// Standard library only. UCharacterBattleSimulatorCommandlet runs it with the
+// character defaults; any other binary can fill FBattleConfig itself.
+// ============================================================================
+
+#pragma once
+
+#include "CharacterSimulationCore.h"
+
+namespace CharacterSimulation
+{
+
+struct FBattleFighter
+{
+FCharacter Character;
+FProtection Protection;
+
+// 0 or 1
+int32_t Team = 0;
+};
+
+struct FBattleConfig
+{
+std::vector<FBattleFighter> Fighters;
+
+float TimeStep = 0.1f;
+
+// Fights still running after this many seconds are draws
+float MaxDuration = 120.f;
+
+uint64_t Seed = 1;
+};
+
+struct FBattleOutcome
+{
+// -1 for a draw
+int32_t WinningTeam = -1;
+float Duration = 0.f;
+float TeamDamage[2] = {};
+};
+
+struct FBattleDistribution
+{
+double Mean = 0.0;
+float Min = 0.f;
+float P5 = 0.f;
+float P50 = 0.f;
+float P95 = 0.f;
+float Max = 0.f;
+};
+
+struct FBattleReport
+{
+uint64_t NumFights = 0;
+uint64_t Wins[2] = {};
+uint64_t Draws = 0;
+
+// Fight duration of decided fights
+FBattleDistribution TimeToKill;
+
+// Damage per second of each team over the whole fight
+FBattleDistribution TeamDps[2];
+
+double Seconds = 0.0;
+double FightsPerSecond = 0.0;
+};
+
+// Plays one fight. The same config and index always give the same outcome.
+FBattleOutcome SimulateBattle(const FBattleConfig& Config, uint64_t FightIndex);
+
+// Plays NumFights fights on NumThreads threads, 0 uses every hardware thread
+FBattleReport RunBattles(const FBattleConfig& Config, uint64_t NumFights, uint32_t NumThreads = 0);
+
+}
@@ -8,6 +8,9 @@ struct FInformationData
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterDeltaEncoder;
+
 protected:
 // Title of the information
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -51,12 +54,16 @@ FString& GetTitle()
 return Title; 
 }
 
+const FString& GetTitle() const { return Title; }
+
 // Getters and Setters
 FString& GetDescription()  
 {
 return Description;
 }
 
+const FString& GetDescription() const { return Description; }
+
 // Setters with event broadcasting
 void SetTitle(const FString& NewTitle) 
 {
@@ -114,11 +121,36 @@ Capacity		UMETA(DisplayName = "Capacity"),
 Regeneration	UMETA(DisplayName = "Regeneration")
 };
 
+// Converts a primary attribute type to its character attribute type
+inline ECharacterAttributeType ToCharacterAttributeType(EPrimaryAttributeType Type)
+{
+if (Type == EPrimaryAttributeType::Null || Type == EPrimaryAttributeType::Max)
+{
+return ECharacterAttributeType::Null;
+}
+
+return static_cast<ECharacterAttributeType>(static_cast<uint8>(Type));
+}
+
+// Converts a secondary attribute type to its character attribute type
+inline ECharacterAttributeType ToCharacterAttributeType(ESecondaryAttributeType Type)
+{
+if (Type == ESecondaryAttributeType::Null)
+{
+return ECharacterAttributeType::Null;
+}
+
+return static_cast<ECharacterAttributeType>(static_cast<uint8>(Type) + static_cast<uint8>(EPrimaryAttributeType::Shield));
+}
+
 USTRUCT(BlueprintType)
 struct FAttributeModule
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterDeltaEncoder;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
 float MinimumValue;
@@ -196,6 +228,9 @@ struct FCharacterAttribute
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCompactCharacterAttribute;
+
 protected:
 // Primary Attributes
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -264,50 +299,224 @@ FAttributeModule& GetIntegrityAttributeModule()		{ return Integrity; }
 FAttributeModule& GetCapacityAttributeModule()		{ return Capacity; }
 FAttributeModule& GetRegenerationAttributeModule()	{ return Regeneration; }
 
-FAttributeModule& GetPrimaryAttributeModuleByType(EPrimaryAttributeType Type)
+const FAttributeModule& GetHealthAttributeModule() const		{ return Health; }
+const FAttributeModule& GetStaminaAttributeModule() const		{ return Stamina; }
+const FAttributeModule& GetEnergyAttributeModule() const		{ return Energy; }
+const FAttributeModule& GetShieldAttributeModule() const		{ return Shield; }
+const FAttributeModule& GetOutputAttributeModule() const		{ return Output; }
+const FAttributeModule& GetActuationAttributeModule() const		{ return Actuation; }
+const FAttributeModule& GetIntegrityAttributeModule() const		{ return Integrity; }
+const FAttributeModule& GetCapacityAttributeModule() const		{ return Capacity; }
+const FAttributeModule& GetRegenerationAttributeModule() const	{ return Regeneration; }
+
+// Returns the attribute module for any attribute type, or nullptr for Null
+FAttributeModule* FindAttributeModuleByType(ECharacterAttributeType Type)
 {
 switch (Type)
 {
-case EPrimaryAttributeType::Health:
-return Health;
-case EPrimaryAttributeType::Stamina:
-return Stamina;
-case EPrimaryAttributeType::Energy:
-return Energy;
-case EPrimaryAttributeType::Shield:
-return Shield;
-default:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetPrimaryAttributeModuleByType: Invalid Primary Attribute Type selected."));
-#endif
-checkNoEntry(); 
-return *(new FAttributeModule());
+case ECharacterAttributeType::Health:		return &Health;
+case ECharacterAttributeType::Stamina:		return &Stamina;
+case ECharacterAttributeType::Energy:		return &Energy;
+case ECharacterAttributeType::Shield:		return &Shield;
+case ECharacterAttributeType::Output:		return &Output;
+case ECharacterAttributeType::Actuation:	return &Actuation;
+case ECharacterAttributeType::Integrity:	return &Integrity;
+case ECharacterAttributeType::Capacity:		return &Capacity;
+case ECharacterAttributeType::Regeneration:	return &Regeneration;
+default:									return nullptr;
+}
 }
+
+const FAttributeModule* FindAttributeModuleByType(ECharacterAttributeType Type) const
+{
+return const_cast<FCharacterAttribute*>(this)->FindAttributeModuleByType(Type);
 }
-FAttributeModule& GetSecondaryAttributeModuleByType(ESecondaryAttributeType Type)
+
+// Returns the primary attribute module, or nullptr for Null
+FAttributeModule* FindPrimaryAttributeModuleByType(EPrimaryAttributeType Type)
 {
 switch (Type)
 {
-case ESecondaryAttributeType::Output:
-return Output;
-case ESecondaryAttributeType::Actuation:
-return Actuation;
-case ESecondaryAttributeType::Integrity:
-return Integrity;
-case ESecondaryAttributeType::Capacity:
-return Capacity;
-case ESecondaryAttributeType::Regeneration:
-return Regeneration;
-default:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetSecondaryAttributeModuleByType: Invalid Secondary Attribute Type selected."));
-#endif
-checkNoEntry();
-return *(new FAttributeModule());
+case EPrimaryAttributeType::Health:		return &Health;
+case EPrimaryAttributeType::Stamina:	return &Stamina;
+case EPrimaryAttributeType::Energy:		return &Energy;
+case EPrimaryAttributeType::Shield:		return &Shield;
+default:								return nullptr;
+}
+}
+
+const FAttributeModule* FindPrimaryAttributeModuleByType(EPrimaryAttributeType Type) const
+{
+return const_cast<FCharacterAttribute*>(this)->FindPrimaryAttributeModuleByType(Type);
+}
+
+// Returns the secondary attribute module, or nullptr for Null
+FAttributeModule* FindSecondaryAttributeModuleByType(ESecondaryAttributeType Type)
+{
+switch (Type)
+{
+case ESecondaryAttributeType::Output:		return &Output;
+case ESecondaryAttributeType::Actuation:	return &Actuation;
+case ESecondaryAttributeType::Integrity:	return &Integrity;
+case ESecondaryAttributeType::Capacity:		return &Capacity;
+case ESecondaryAttributeType::Regeneration:	return &Regeneration;
+default:									return nullptr;
 }
 }
+
+const FAttributeModule* FindSecondaryAttributeModuleByType(ESecondaryAttributeType Type) const
+{
+return const_cast<FCharacterAttribute*>(this)->FindSecondaryAttributeModuleByType(Type);
+}
+
+// Never fails, invalid types report once and return the empty sentinel
+const FAttributeModule& GetPrimaryAttributeModuleByType(EPrimaryAttributeType Type) const
+{
+const FAttributeModule* Module = FindPrimaryAttributeModuleByType(Type);
+return ensureMsgf(Module, TEXT("GetPrimaryAttributeModuleByType: Invalid Primary Attribute Type selected.")) ? *Module : GetInvalidAttributeModule();
+}
+
+const FAttributeModule& GetSecondaryAttributeModuleByType(ESecondaryAttributeType Type) const
+{
+const FAttributeModule* Module = FindSecondaryAttributeModuleByType(Type);
+return ensureMsgf(Module, TEXT("GetSecondaryAttributeModuleByType: Invalid Secondary Attribute Type selected.")) ? *Module : GetInvalidAttributeModule();
+}
+
+private:
+// Returned for invalid types instead of allocating. Const, so no caller can write through it.
+static const FAttributeModule& GetInvalidAttributeModule()
+{
+static const FAttributeModule InvalidModule;
+return InvalidModule;
+}
 };
 
+// Compact attribute storage for crowd characters.
+// Current values are 16-bit fixed point relative to the min/max range of a shared archetype,
+// update flags are bit-packed and ranges and rates are read from the archetype.
+struct FCompactCharacterAttribute
+{
+static constexpr int32 NumAttributes = 9;
+
+// Shares ranges and rates with an archetype and takes its current values and update flags
+void Initialize(const FCharacterAttribute& InArchetype)
+{
+Archetype = &InArchetype;
+UpdateEnabledMask = 0;
+UpgradePoint = InArchetype.UpgradePoint;
+
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+const ECharacterAttributeType Type = static_cast<ECharacterAttributeType>(Index + 1);
+const FAttributeModule& Module = *InArchetype.FindAttributeModuleByType(Type);
+
+SetCurrentValue(Type, Module.GetCurrentValue());
+SetUpdateEnabled(Type, Module.IsUpdateEnabled());
+}
+}
+
+// Re-targets the shared archetype, keeping the quantized current values
+void SetArchetype(const FCharacterAttribute& InArchetype) { Archetype = &InArchetype; }
+
+bool IsValid() const { return Archetype != nullptr; }
+const FCharacterAttribute* GetArchetype() const { return Archetype; }
+
+float GetMinimumValue(ECharacterAttributeType Type) const
+{
+const FAttributeModule* Module = FindArchetypeModule(Type);
+return Module ? Module->GetMinimumValue() : 0.f;
+}
+
+float GetMaximumValue(ECharacterAttributeType Type) const
+{
+const FAttributeModule* Module = FindArchetypeModule(Type);
+return Module ? Module->GetMaximumValue() : 0.f;
+}
+
+float GetCurrentValue(ECharacterAttributeType Type) const
+{
+const FAttributeModule* Module = FindArchetypeModule(Type);
+
+if (!Module)
+{
+return 0.f;
+}
+
+const float Alpha = CurrentValues[static_cast<uint8>(Type) - 1] / static_cast<float>(MAX_uint16);
+return Module->GetMinimumValue() + (Module->GetMaximumValue() - Module->GetMinimumValue()) * Alpha;
+}
+
+// Quantizes and stores a current value, clamped to the archetype range
+void SetCurrentValue(ECharacterAttributeType Type, float InCurrentValue)
+{
+const FAttributeModule* Module = FindArchetypeModule(Type);
+
+if (!Module)
+{
+return;
+}
+
+const float Range = Module->GetMaximumValue() - Module->GetMinimumValue();
+const float Alpha = Range > 0.f ? FMath::Clamp((InCurrentValue - Module->GetMinimumValue()) / Range, 0.f, 1.f) : 0.f;
+
+CurrentValues[static_cast<uint8>(Type) - 1] = static_cast<uint16>(FMath::RoundToInt(Alpha * MAX_uint16));
+}
+
+bool IsUpdateEnabled(ECharacterAttributeType Type) const
+{
+return FindArchetypeModule(Type) && (UpdateEnabledMask & (1 << (static_cast<uint8>(Type) - 1))) != 0;
+}
+
+void SetUpdateEnabled(ECharacterAttributeType Type, bool bInEnableUpdate)
+{
+if (!FindArchetypeModule(Type))
+{
+return;
+}
+
+const uint16 Bit = static_cast<uint16>(1 << (static_cast<uint8>(Type) - 1));
+UpdateEnabledMask = bInEnableUpdate ? (UpdateEnabledMask | Bit) : (UpdateEnabledMask & ~Bit);
+}
+
+int32 GetUpgradePoint() const { return UpgradePoint; }
+void SetUpgradePoint(int32 InUpgradePoint) { UpgradePoint = InUpgradePoint; }
+
+// Expands an attribute into a full module for by-value accessors
+FAttributeModule ToAttributeModule(ECharacterAttributeType Type) const
+{
+const FAttributeModule* Module = FindArchetypeModule(Type);
+
+if (!Module)
+{
+return FAttributeModule();
+}
+
+FAttributeModule Result = *Module;
+Result.SetValue(Module->GetMinimumValue(), Module->GetMaximumValue(), GetCurrentValue(Type));
+Result.SetUpdateEnabled(IsUpdateEnabled(Type));
+return Result;
+}
+
+private:
+const FAttributeModule* FindArchetypeModule(ECharacterAttributeType Type) const
+{
+return Archetype ? Archetype->FindAttributeModuleByType(Type) : nullptr;
+}
+
+// Shared archetype providing ranges and rates
+const FCharacterAttribute* Archetype = nullptr;
+
+// Current values relative to the archetype range, in ECharacterAttributeType order
+uint16 CurrentValues[NumAttributes] = {};
+
+// One bit per attribute, in ECharacterAttributeType order
+uint16 UpdateEnabledMask = 0;
+
+int32 UpgradePoint = 0;
+};
+
+static_assert(sizeof(FCompactCharacterAttribute) <= 32, "FCompactCharacterAttribute should stay within 32 bytes.");
+
 #pragma endregion
 
 #pragma region Ability
@@ -458,6 +667,10 @@ struct FCharacterAbilityModule
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterRollbackState;
+friend struct FCharacterAbilityData;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)		
 FString Title;
@@ -605,6 +818,9 @@ struct FCharacterAbilityData
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterRollbackState;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
 FCharacterAbilityModule CombatStrike;
@@ -691,7 +907,7 @@ return LaserPulse;
 case ECharacterAbilityType::PlasmaShield:
 return PlasmaShield;
 default:
-return FCharacterAbilityModule();
+return GetInvalidAbility();
 }
 }
 
@@ -713,6 +929,27 @@ return nullptr;
 }
 }
 
+// Never null, invalid types return the empty sentinel
+const FCharacterAbilityModule& FindCharacterAbilityByTypeRef(ECharacterAbilityType AbilityType) const
+{
+const FCharacterAbilityModule* AbilityModule = FindCharacterAbilityByTypePtr(AbilityType);
+return AbilityModule ? *AbilityModule : GetInvalidAbility();
+}
+
+// Ability of type Null with zero ranges and empty strings, so copying it does not allocate
+static const FCharacterAbilityModule& GetInvalidAbility()
+{
+static const FCharacterAbilityModule InvalidAbility = []()
+{
+FCharacterAbilityModule Ability;
+Ability.Title.Empty();
+Ability.Description.Empty();
+return Ability;
+}();
+
+return InvalidAbility;
+}
+
 };
 
 #pragma endregion
@@ -724,6 +961,10 @@ struct FCharacterLevelData
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterRollbackState;
+friend struct FCharacterDeltaEncoder;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
 float Experience;
@@ -801,7 +1042,7 @@ return Experience;
 }
 
 // Getter for experience thresholds
-TArray<float> GetExperienceThreshold() const
+const TArray<float>& GetExperienceThreshold() const
 {
 return ExperienceThreshold;
 }
@@ -926,6 +1167,8 @@ struct FCharacterMovementData
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
 float WalkSpeed;
@@ -1013,6 +1256,9 @@ struct FCharacterData
 {
 GENERATED_BODY()
 
+friend struct FCharacterSnapshotSerializer;
+friend struct FCharacterDeltaEncoder;
+
 protected:
 UPROPERTY(EditAnywhere, BlueprintReadWrite)
 ECharacterState State;
@@ -1061,6 +1307,16 @@ FProtectionData& GetProtectionData() { return ProtectionData; }
 FCharacterLevelData& GetLevelData() { return LevelData; }
 FCharacterMovementData& GetMovementData()  { return MovementData; }
 
+// Read-only access, e.g. to sections shared with an archetype
+const ECharacterState& GetCharacterState() const { return State; }
+const ECharacterType& GetCharacterType() const { return Type; }
+const FInformationData& GetInformationData() const { return Information; }
+const FCharacterAttribute& GetAttributeData() const { return AttributeData; }
+const FCharacterAbilityData& GetAbilityData() const { return AbilityData; }
+const FProtectionData& GetProtectionData() const { return ProtectionData; }
+const FCharacterLevelData& GetLevelData() const { return LevelData; }
+const FCharacterMovementData& GetMovementData() const { return MovementData; }
+
 // Setters
 void SetCharacterState(ECharacterState InState) {State = InState; }
 void SetCharacterType(ECharacterType InType) {	Type = InType;	}
@@ -1077,3 +1333,878 @@ bool IsAI() const { return Type == ECharacterType::AI; }
 };
 
 #pragma endregion
+
+#pragma region Snapshot
+
+// Binary snapshot format versions
+enum class ECharacterSnapshotVersion : uint16
+{
+Initial = 1,
+
+// Keep last
+VersionPlusOne,
+Latest = VersionPlusOne - 1
+};
+
+// Fixed-size header at the start of every character snapshot
+struct FCharacterSnapshotHeader
+{
+uint32 Magic;
+uint16 Version;
+uint16 StringCount;
+uint32 PayloadSize;
+uint32 StringTableOffset;
+};
+
+static_assert(sizeof(FCharacterSnapshotHeader) == 16, "FCharacterSnapshotHeader must stay 16 bytes.");
+
+// Hand-rolled, versioned binary serializer for FCharacterData.
+// Layout: Header | Character | Attributes | Abilities | Level | Movement | String Table
+// Strings are deduplicated into the trailing string table and referenced by index.
+// Protection data and montage references are archetype configuration and are not written.
+struct FCharacterSnapshotSerializer
+{
+static constexpr uint32 Magic = 0x4E534D43; // 'CMSN'
+static constexpr int32 MaxStrings = 8;
+static constexpr int32 NumAttributes = 9;
+static constexpr int32 NumAbilities = 3;
+
+// Serializes the character into OutBuffer, reusing its allocation. Returns the number of bytes written,
+// 0 if a string is longer than the format can store.
+static int32 Serialize(const FCharacterData& Data, TArray<uint8>& OutBuffer)
+{
+// Collect unique strings
+const FString* Strings[MaxStrings];
+int32 StringCount = 0;
+
+auto AddString = [&Strings, &StringCount](const FString& InString) -> uint16
+{
+for (int32 Index = 0; Index < StringCount; ++Index)
+{
+if (Strings[Index]->Equals(InString, ESearchCase::CaseSensitive))
+{
+return static_cast<uint16>(Index);
+}
+}
+
+check(StringCount < MaxStrings);
+Strings[StringCount] = &InString;
+return static_cast<uint16>(StringCount++);
+};
+
+const FCharacterAttribute& Attributes = Data.AttributeData;
+const FAttributeModule* AttributeModules[NumAttributes] =
+{
+&Attributes.Health, &Attributes.Stamina, &Attributes.Energy, &Attributes.Shield,
+&Attributes.Output, &Attributes.Actuation, &Attributes.Integrity, &Attributes.Capacity, &Attributes.Regeneration
+};
+
+const FCharacterAbilityModule* AbilityModules[NumAbilities] =
+{
+&Data.AbilityData.CombatStrike, &Data.AbilityData.LaserPulse, &Data.AbilityData.PlasmaShield
+};
+
+OutBuffer.Reset();
+OutBuffer.AddUninitialized(sizeof(FCharacterSnapshotHeader));
+
+// Character
+Write<uint8>(OutBuffer, static_cast<uint8>(Data.State));
+Write<uint8>(OutBuffer, static_cast<uint8>(Data.Type));
+Write<uint16>(OutBuffer, AddString(Data.Information.Title));
+Write<uint16>(OutBuffer, AddString(Data.Information.Description));
+
+// Attributes
+uint16 UpdateMask = 0;
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+const FAttributeModule& Module = *AttributeModules[Index];
+Write<float>(OutBuffer, Module.MinimumValue);
+Write<float>(OutBuffer, Module.MaximumValue);
+Write<float>(OutBuffer, Module.CurrentValue);
+Write<float>(OutBuffer, Module.RegenerateValue);
+Write<float>(OutBuffer, Module.DepleteValue);
+UpdateMask |= Module.bEnableUpdate ? (1 << Index) : 0;
+}
+Write<uint16>(OutBuffer, UpdateMask);
+Write<int32>(OutBuffer, Attributes.UpgradePoint);
+
+// Abilities
+for (const FCharacterAbilityModule* Ability : AbilityModules)
+{
+Write<uint16>(OutBuffer, AddString(Ability->Title));
+Write<uint16>(OutBuffer, AddString(Ability->Description));
+Write<uint8>(OutBuffer, static_cast<uint8>(Ability->AbilityType));
+Write<uint8>(OutBuffer, static_cast<uint8>(Ability->EffectType));
+Write<uint8>(OutBuffer, static_cast<uint8>(Ability->DamageType));
+Write<uint8>(OutBuffer, static_cast<uint8>(Ability->CostType));
+WriteRange(OutBuffer, Ability->PowerRange);
+WriteRange(OutBuffer, Ability->DurationRange);
+WriteRange(OutBuffer, Ability->CooldownTimeRange);
+WriteRange(OutBuffer, Ability->CostRange);
+Write<float>(OutBuffer, Ability->Range);
+Write<float>(OutBuffer, Ability->Radius);
+Write<float>(OutBuffer, Ability->CooldownTimer);
+}
+
+// Level
+const FCharacterLevelData& Level = Data.LevelData;
+Write<float>(OutBuffer, Level.Experience);
+Write<int32>(OutBuffer, Level.Level);
+Write<int32>(OutBuffer, Level.MaxLevel);
+Write<float>(OutBuffer, Level.ExperienceRewardBonus);
+Write<int32>(OutBuffer, Level.ExperienceThreshold.Num());
+const int32 ThresholdOffset = OutBuffer.AddUninitialized(Level.ExperienceThreshold.Num() * sizeof(float));
+FMemory::Memcpy(OutBuffer.GetData() + ThresholdOffset, Level.ExperienceThreshold.GetData(), Level.ExperienceThreshold.Num() * sizeof(float));
+
+// Movement
+const FCharacterMovementData& Movement = Data.MovementData;
+Write<float>(OutBuffer, Movement.WalkSpeed);
+Write<float>(OutBuffer, Movement.DefaultSpeed);
+Write<float>(OutBuffer, Movement.MaxSpeed);
+Write<float>(OutBuffer, Movement.JumpHeight);
+Write<int32>(OutBuffer, Movement.MaxJumpCount);
+Write<uint8>(OutBuffer, static_cast<uint8>((Movement.bEnableSprint ? 1 : 0) | (Movement.bEnableJump ? 2 : 0) | (Movement.bEnableDoubleJump ? 4 : 0)));
+
+// String table: offsets followed by UTF-16 data
+const uint32 StringTableOffset = OutBuffer.Num();
+const int32 OffsetsStart = OutBuffer.AddUninitialized(StringCount * sizeof(uint32));
+OutBuffer.AddZeroed(OutBuffer.Num() & 1); // Align string data to UTF16CHAR
+
+for (int32 Index = 0; Index < StringCount; ++Index)
+{
+const FString& String = *Strings[Index];
+const int32 SourceLength = String.Len();
+const int32 ConvertedLength = FPlatformString::ConvertedLength<UTF16CHAR>(*String, SourceLength);
+
+// Lengths are stored as uint16
+if (ConvertedLength > MAX_uint16)
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("FCharacterSnapshotSerializer::Serialize: String of %d characters exceeds the snapshot limit."), ConvertedLength);
+#endif
+OutBuffer.Reset();
+return 0;
+}
+
+const uint32 StringOffset = OutBuffer.Num();
+FMemory::Memcpy(OutBuffer.GetData() + OffsetsStart + Index * sizeof(uint32), &StringOffset, sizeof(uint32));
+
+Write<uint16>(OutBuffer, static_cast<uint16>(ConvertedLength));
+const int32 CharsOffset = OutBuffer.AddUninitialized(ConvertedLength * sizeof(UTF16CHAR));
+FPlatformString::Convert(reinterpret_cast<UTF16CHAR*>(OutBuffer.GetData() + CharsOffset), ConvertedLength, *String, SourceLength);
+}
+
+// Header
+FCharacterSnapshotHeader Header;
+Header.Magic = Magic;
+Header.Version = static_cast<uint16>(ECharacterSnapshotVersion::Latest);
+Header.StringCount = static_cast<uint16>(StringCount);
+Header.PayloadSize = OutBuffer.Num() - sizeof(FCharacterSnapshotHeader);
+Header.StringTableOffset = StringTableOffset;
+FMemory::Memcpy(OutBuffer.GetData(), &Header, sizeof(FCharacterSnapshotHeader));
+
+return OutBuffer.Num();
+}
+
+// Deserializes a snapshot into an existing character. A first pass validates the whole snapshot without
+// writing, so a truncated or corrupted snapshot leaves the character unchanged, then the snapshot is decoded
+// in place, reusing the character's string and array allocations. Fields the snapshot does not carry keep their values.
+static bool Deserialize(TArrayView<const uint8> Buffer, FCharacterData& InOutData)
+{
+if (Buffer.Num() < static_cast<int32>(sizeof(FCharacterSnapshotHeader)))
+{
+return false;
+}
+
+FCharacterSnapshotHeader Header;
+FMemory::Memcpy(&Header, Buffer.GetData(), sizeof(FCharacterSnapshotHeader));
+
+if (Header.Magic != Magic
+|| Header.Version == 0
+|| Header.Version > static_cast<uint16>(ECharacterSnapshotVersion::Latest)
+|| Header.StringCount > MaxStrings
+|| Header.PayloadSize + sizeof(FCharacterSnapshotHeader) > static_cast<uint32>(Buffer.Num())
+|| Header.StringTableOffset + Header.StringCount * sizeof(uint32) > Header.PayloadSize + sizeof(FCharacterSnapshotHeader))
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("FCharacterSnapshotSerializer::Deserialize: Invalid snapshot header."));
+#endif
+return false;
+}
+
+FReader Reader(Buffer.GetData(), Header.StringTableOffset, sizeof(FCharacterSnapshotHeader));
+FReader StringReader(Buffer.GetData(), Header.PayloadSize + sizeof(FCharacterSnapshotHeader), Header.StringTableOffset);
+
+if (!Validate(Reader, StringReader, Header.StringCount))
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("FCharacterSnapshotSerializer::Deserialize: Snapshot is truncated or corrupted."));
+#endif
+return false;
+}
+
+// Character
+InOutData.State = ReadEnum<ECharacterState>(Reader);
+InOutData.Type = ReadEnum<ECharacterType>(Reader);
+ReadString(StringReader, Header.StringCount, Reader.Read<uint16>(), InOutData.Information.Title);
+ReadString(StringReader, Header.StringCount, Reader.Read<uint16>(), InOutData.Information.Description);
+
+// Attributes
+FCharacterAttribute& Attributes = InOutData.AttributeData;
+FAttributeModule* AttributeModules[NumAttributes] =
+{
+&Attributes.Health, &Attributes.Stamina, &Attributes.Energy, &Attributes.Shield,
+&Attributes.Output, &Attributes.Actuation, &Attributes.Integrity, &Attributes.Capacity, &Attributes.Regeneration
+};
+
+for (FAttributeModule* Module : AttributeModules)
+{
+Module->MinimumValue = Reader.Read<float>();
+Module->MaximumValue = Reader.Read<float>();
+Module->CurrentValue = Reader.Read<float>();
+Module->RegenerateValue = Reader.Read<float>();
+Module->DepleteValue = Reader.Read<float>();
+}
+
+const uint16 UpdateMask = Reader.Read<uint16>();
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+AttributeModules[Index]->bEnableUpdate = (UpdateMask & (1 << Index)) != 0;
+}
+Attributes.UpgradePoint = Reader.Read<int32>();
+
+// Abilities
+FCharacterAbilityModule* AbilityModules[NumAbilities] =
+{
+&InOutData.AbilityData.CombatStrike, &InOutData.AbilityData.LaserPulse, &InOutData.AbilityData.PlasmaShield
+};
+
+for (FCharacterAbilityModule* Ability : AbilityModules)
+{
+ReadString(StringReader, Header.StringCount, Reader.Read<uint16>(), Ability->Title);
+ReadString(StringReader, Header.StringCount, Reader.Read<uint16>(), Ability->Description);
+Ability->AbilityType = ReadEnum<ECharacterAbilityType>(Reader);
+Ability->EffectType = ReadEnum<EAbilityEffectType>(Reader);
+Ability->DamageType = ReadEnum<EDamageType>(Reader);
+Ability->CostType = ReadEnum<EAbilityCostType>(Reader);
+Ability->PowerRange = ReadRange(Reader);
+Ability->DurationRange = ReadRange(Reader);
+Ability->CooldownTimeRange = ReadRange(Reader);
+Ability->CostRange = ReadRange(Reader);
+Ability->Range = Reader.Read<float>();
+Ability->Radius = Reader.Read<float>();
+Ability->CooldownTimer = Reader.Read<float>();
+}
+
+// Level
+FCharacterLevelData& Level = InOutData.LevelData;
+Level.Experience = Reader.Read<float>();
+Level.Level = Reader.Read<int32>();
+Level.MaxLevel = Reader.Read<int32>();
+Level.ExperienceRewardBonus = Reader.Read<float>();
+
+const int32 ThresholdCount = Reader.Read<int32>();
+const float* Thresholds = reinterpret_cast<const float*>(Reader.Skip(ThresholdCount * sizeof(float)));
+
+Level.ExperienceThreshold.Reset(ThresholdCount);
+Level.ExperienceThreshold.AddUninitialized(ThresholdCount);
+FMemory::Memcpy(Level.ExperienceThreshold.GetData(), Thresholds, ThresholdCount * sizeof(float));
+
+// Movement
+FCharacterMovementData& Movement = InOutData.MovementData;
+Movement.WalkSpeed = Reader.Read<float>();
+Movement.DefaultSpeed = Reader.Read<float>();
+Movement.MaxSpeed = Reader.Read<float>();
+Movement.JumpHeight = Reader.Read<float>();
+Movement.MaxJumpCount = Reader.Read<int32>();
+
+const uint8 MovementFlags = Reader.Read<uint8>();
+Movement.bEnableSprint = (MovementFlags & 1) != 0;
+Movement.bEnableJump = (MovementFlags & 2) != 0;
+Movement.bEnableDoubleJump = (MovementFlags & 4) != 0;
+
+// Validate walked the same layout
+checkSlow(!Reader.bError && !StringReader.bError);
+return true;
+}
+
+private:
+// Bounds-checked cursor over the snapshot buffer
+struct FReader
+{
+const uint8* Data;
+uint32 End;
+uint32 Offset;
+bool bError = false;
+
+FReader(const uint8* InData, uint32 InEnd, uint32 InOffset)
+: Data(InData)
+, End(InEnd)
+, Offset(InOffset)
+{}
+
+const uint8* Skip(uint32 Size)
+{
+if (bError || Offset > End || Size > End - Offset)
+{
+bError = true;
+return nullptr;
+}
+
+const uint8* Result = Data + Offset;
+Offset += Size;
+return Result;
+}
+
+template<typename T>
+T Read()
+{
+T Value{};
+if (const uint8* Source = Skip(sizeof(T)))
+{
+FMemory::Memcpy(&Value, Source, sizeof(T));
+}
+return Value;
+}
+};
+
+template<typename T>
+static void Write(TArray<uint8>& Buffer, T Value)
+{
+const int32 Offset = Buffer.AddUninitialized(sizeof(T));
+FMemory::Memcpy(Buffer.GetData() + Offset, &Value, sizeof(T));
+}
+
+static void WriteRange(TArray<uint8>& Buffer, const FVector2D& Range)
+{
+Write<float>(Buffer, static_cast<float>(Range.X));
+Write<float>(Buffer, static_cast<float>(Range.Y));
+}
+
+// Flags values the enum does not declare, including the generated _MAX
+template<typename TEnum>
+static TEnum ReadEnum(FReader& Reader)
+{
+const uint8 Value = Reader.Read<uint8>();
+const UEnum* Enum = StaticEnum<TEnum>();
+const int32 Index = Enum->GetIndexByValue(Value);
+
+if (Index == INDEX_NONE || Index >= Enum->NumEnums() - 1)
+{
+Reader.bError = true;
+}
+
+return static_cast<TEnum>(Value);
+}
+
+static FVector2D ReadRange(FReader& Reader)
+{
+const float X = Reader.Read<float>();
+const float Y = Reader.Read<float>();
+return FVector2D(X, Y);
+}
+
+// Walks the payload in Deserialize's layout without writing. Checks bounds, enum values, string indices and the threshold count.
+static bool Validate(FReader Reader, FReader StringReader, uint16 StringCount)
+{
+// Character
+ReadEnum<ECharacterState>(Reader);
+ReadEnum<ECharacterType>(Reader);
+ValidateString(StringReader, StringCount, Reader.Read<uint16>());
+ValidateString(StringReader, StringCount, Reader.Read<uint16>());
+
+// Attributes: five floats per module, the update mask and the upgrade points
+Reader.Skip(NumAttributes * 5 * sizeof(float) + sizeof(uint16) + sizeof(int32));
+
+// Abilities: four ranges and three floats after the strings and enums
+for (int32 Index = 0; Index < NumAbilities; ++Index)
+{
+ValidateString(StringReader, StringCount, Reader.Read<uint16>());
+ValidateString(StringReader, StringCount, Reader.Read<uint16>());
+ReadEnum<ECharacterAbilityType>(Reader);
+ReadEnum<EAbilityEffectType>(Reader);
+ReadEnum<EDamageType>(Reader);
+ReadEnum<EAbilityCostType>(Reader);
+Reader.Skip(11 * sizeof(float));
+}
+
+// Level
+Reader.Skip(sizeof(float) + sizeof(int32) + sizeof(int32) + sizeof(float));
+
+const int32 ThresholdCount = Reader.Read<int32>();
+if (ThresholdCount < 0 || ThresholdCount > MAX_int32 / static_cast<int32>(sizeof(float)))
+{
+return false;
+}
+Reader.Skip(ThresholdCount * sizeof(float));
+
+// Movement
+Reader.Skip(4 * sizeof(float) + sizeof(int32) + sizeof(uint8));
+
+return !Reader.bError && !StringReader.bError;
+}
+
+// Locates an entry of the string table, flagging an out-of-range index or entry
+static const UTF16CHAR* FindString(FReader& StringReader, uint16 StringCount, uint16 Index, uint16& OutLength)
+{
+if (Index >= StringCount)
+{
+StringReader.bError = true;
+return nullptr;
+}
+
+FReader Cursor(StringReader.Data, StringReader.End, StringReader.Offset + Index * sizeof(uint32));
+Cursor.Offset = Cursor.Read<uint32>();
+
+OutLength = Cursor.Read<uint16>();
+const UTF16CHAR* Source = reinterpret_cast<const UTF16CHAR*>(Cursor.Skip(OutLength * sizeof(UTF16CHAR)));
+
+StringReader.bError |= Cursor.bError;
+return Source;
+}
+
+static void ValidateString(FReader& StringReader, uint16 StringCount, uint16 Index)
+{
+uint16 SourceLength = 0;
+FindString(StringReader, StringCount, Index, SourceLength);
+}
+
+static void ReadString(FReader& StringReader, uint16 StringCount, uint16 Index, FString& OutString)
+{
+uint16 SourceLength = 0;
+const UTF16CHAR* Source = FindString(StringReader, StringCount, Index, SourceLength);
+
+if (StringReader.bError)
+{
+return;
+}
+
+if (SourceLength == 0)
+{
+OutString.Reset();
+return;
+}
+
+const int32 Length = FPlatformString::ConvertedLength<TCHAR>(Source, SourceLength);
+
+TArray<TCHAR>& Chars = OutString.GetCharArray();
+Chars.Reset(Length + 1);
+Chars.AddUninitialized(Length + 1);
+FPlatformString::Convert(Chars.GetData(), Length, Source, SourceLength);
+Chars[Length] = TEXT('\0');
+}
+};
+
+#pragma endregion
+
+#pragma region Replication
+
+// Per-field dirty bits maintained by the UCharacterManager mutators
+namespace CharacterDirtyFlags
+{
+constexpr uint32 None			= 0;
+constexpr uint32 State			= 1u << 0;
+constexpr uint32 Type			= 1u << 1;
+constexpr uint32 Title			= 1u << 2;
+constexpr uint32 Description	= 1u << 3;
+
+// One bit per attribute for the current value and one for the min/max range, in ECharacterAttributeType order
+constexpr uint32 AttributeCurrentShift	= 4;
+constexpr uint32 AttributeRangeShift	= 13;
+
+constexpr uint32 Level			= 1u << 22;
+constexpr uint32 Experience		= 1u << 23;
+constexpr uint32 All			= (1u << 24) - 1;
+
+inline uint32 AttributeCurrent(ECharacterAttributeType Type)
+{
+return Type == ECharacterAttributeType::Null || Type == ECharacterAttributeType::Max ? None : 1u << (AttributeCurrentShift + static_cast<uint8>(Type) - 1);
+}
+
+inline uint32 AttributeRange(ECharacterAttributeType Type)
+{
+return Type == ECharacterAttributeType::Null || Type == ECharacterAttributeType::Max ? None : 1u << (AttributeRangeShift + static_cast<uint8>(Type) - 1);
+}
+}
+
+UENUM(BlueprintType)
+enum class ECharacterDeltaQuantization : uint8
+{
+Float32	UMETA(DisplayName = "32-bit Float"),
+Fixed16	UMETA(DisplayName = "16-bit Fixed Point"),
+Fixed8	UMETA(DisplayName = "8-bit Fixed Point")
+};
+
+USTRUCT(BlueprintType)
+struct FCharacterDeltaQuantization
+{
+GENERATED_BODY()
+
+// Encoding of primary attribute current values, relative to their min/max range
+UPROPERTY(EditAnywhere, BlueprintReadWrite)
+ECharacterDeltaQuantization PrimaryAttributes = ECharacterDeltaQuantization::Fixed16;
+
+// Encoding of secondary attribute current values, relative to their min/max range
+UPROPERTY(EditAnywhere, BlueprintReadWrite)
+ECharacterDeltaQuantization SecondaryAttributes = ECharacterDeltaQuantization::Float32;
+};
+
+// Writes and applies deltas that only contain the fields selected by a dirty mask.
+// Layout: uint32 Mask | State | Type | Title | Description | per attribute (Range, Current) | Level | Experience
+// Quantized current values are decoded against the receiver's range, so the first delta for a receiver must carry CharacterDirtyFlags::All.
+struct FCharacterDeltaEncoder
+{
+static constexpr int32 NumAttributes = 9;
+
+// Appends a delta for DirtyMask to OutBuffer. Returns the number of bytes appended.
+static int32 Encode(const FCharacterData& Data, uint32 DirtyMask, const FCharacterDeltaQuantization& Quantization, TArray<uint8>& OutBuffer)
+{
+const int32 StartSize = OutBuffer.Num();
+
+Write<uint32>(OutBuffer, DirtyMask);
+
+if (DirtyMask & CharacterDirtyFlags::State)
+{
+Write<uint8>(OutBuffer, static_cast<uint8>(Data.State));
+}
+
+if (DirtyMask & CharacterDirtyFlags::Type)
+{
+Write<uint8>(OutBuffer, static_cast<uint8>(Data.Type));
+}
+
+if (DirtyMask & CharacterDirtyFlags::Title)
+{
+WriteString(OutBuffer, Data.Information.Title);
+}
+
+if (DirtyMask & CharacterDirtyFlags::Description)
+{
+WriteString(OutBuffer, Data.Information.Description);
+}
+
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index + 1);
+const FAttributeModule& Module = *Data.AttributeData.FindAttributeModuleByType(AttributeType);
+
+if (DirtyMask & CharacterDirtyFlags::AttributeRange(AttributeType))
+{
+Write<float>(OutBuffer, Module.GetMinimumValue());
+Write<float>(OutBuffer, Module.GetMaximumValue());
+}
+
+if (DirtyMask & CharacterDirtyFlags::AttributeCurrent(AttributeType))
+{
+WriteQuantized(OutBuffer, Module.GetCurrentValue(), Module.GetMinimumValue(), Module.GetMaximumValue(), GetQuantization(Quantization, AttributeType));
+}
+}
+
+if (DirtyMask & CharacterDirtyFlags::Level)
+{
+Write<uint16>(OutBuffer, static_cast<uint16>(FMath::Clamp(Data.LevelData.Level, 0, static_cast<int32>(MAX_uint16))));
+}
+
+if (DirtyMask & CharacterDirtyFlags::Experience)
+{
+Write<float>(OutBuffer, Data.LevelData.Experience);
+}
+
+return OutBuffer.Num() - StartSize;
+}
+
+// Applies a delta in place. OutDirtyMask receives the fields that were written.
+// The whole delta is parsed and validated first, so a truncated or corrupted delta leaves InOutData and OutDirtyMask unchanged.
+static bool Decode(TArrayView<const uint8> Buffer, const FCharacterDeltaQuantization& Quantization, FCharacterData& InOutData, uint32& OutDirtyMask)
+{
+int32 Offset = 0;
+bool bError = false;
+
+const uint32 DirtyMask = Read<uint32>(Buffer, Offset, bError);
+bError |= (DirtyMask & ~CharacterDirtyFlags::All) != 0;
+
+const ECharacterState State = (DirtyMask & CharacterDirtyFlags::State) ? ReadEnum<ECharacterState>(Buffer, Offset, bError) : InOutData.State;
+const ECharacterType Type = (DirtyMask & CharacterDirtyFlags::Type) ? ReadEnum<ECharacterType>(Buffer, Offset, bError) : InOutData.Type;
+
+// Strings are located now and converted once the delta is known to be valid
+const int32 TitleOffset = (DirtyMask & CharacterDirtyFlags::Title) ? SkipString(Buffer, Offset, bError) : INDEX_NONE;
+const int32 DescriptionOffset = (DirtyMask & CharacterDirtyFlags::Description) ? SkipString(Buffer, Offset, bError) : INDEX_NONE;
+
+FVector3f AttributeValues[NumAttributes];
+
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index + 1);
+const FAttributeModule& Module = *InOutData.AttributeData.FindAttributeModuleByType(AttributeType);
+
+float MinValue = Module.GetMinimumValue();
+float MaxValue = Module.GetMaximumValue();
+float CurrentValue = Module.GetCurrentValue();
+
+if (DirtyMask & CharacterDirtyFlags::AttributeRange(AttributeType))
+{
+MinValue = Read<float>(Buffer, Offset, bError);
+MaxValue = Read<float>(Buffer, Offset, bError);
+}
+
+if (DirtyMask & CharacterDirtyFlags::AttributeCurrent(AttributeType))
+{
+CurrentValue = ReadQuantized(Buffer, Offset, bError, MinValue, MaxValue, GetQuantization(Quantization, AttributeType));
+}
+
+AttributeValues[Index] = FVector3f(MinValue, MaxValue, CurrentValue);
+}
+
+const int32 Level = (DirtyMask & CharacterDirtyFlags::Level) ? Read<uint16>(Buffer, Offset, bError) : InOutData.LevelData.Level;
+const float Experience = (DirtyMask & CharacterDirtyFlags::Experience) ? Read<float>(Buffer, Offset, bError) : InOutData.LevelData.Experience;
+
+if (bError)
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("FCharacterDeltaEncoder::Decode: Delta is truncated or corrupted."));
+#endif
+return false;
+}
+
+// Commit
+InOutData.State = State;
+InOutData.Type = Type;
+
+if (TitleOffset != INDEX_NONE)
+{
+ReadString(Buffer, TitleOffset, InOutData.Information.Title);
+}
+
+if (DescriptionOffset != INDEX_NONE)
+{
+ReadString(Buffer, DescriptionOffset, InOutData.Information.Description);
+}
+
+for (int32 Index = 0; Index < NumAttributes; ++Index)
+{
+const FVector3f& Values = AttributeValues[Index];
+InOutData.AttributeData.FindAttributeModuleByType(static_cast<ECharacterAttributeType>(Index + 1))->SetValue(Values.X, Values.Y, Values.Z);
+}
+
+InOutData.LevelData.Level = Level;
+InOutData.LevelData.Experience = Experience;
+
+OutDirtyMask = DirtyMask;
+return true;
+}
+
+private:
+static ECharacterDeltaQuantization GetQuantization(const FCharacterDeltaQuantization& Quantization, ECharacterAttributeType Type)
+{
+return static_cast<uint8>(Type) <= static_cast<uint8>(ECharacterAttributeType::Shield) ? Quantization.PrimaryAttributes : Quantization.SecondaryAttributes;
+}
+
+template<typename T>
+static void Write(TArray<uint8>& Buffer, T Value)
+{
+const int32 Offset = Buffer.AddUninitialized(sizeof(T));
+FMemory::Memcpy(Buffer.GetData() + Offset, &Value, sizeof(T));
+}
+
+template<typename T>
+static T Read(TArrayView<const uint8> Buffer, int32& Offset, bool& bError)
+{
+T Value{};
+if (bError || Offset + static_cast<int32>(sizeof(T)) > Buffer.Num())
+{
+bError = true;
+return Value;
+}
+
+FMemory::Memcpy(&Value, Buffer.GetData() + Offset, sizeof(T));
+Offset += sizeof(T);
+return Value;
+}
+
+static void WriteQuantized(TArray<uint8>& Buffer, float Value, float MinValue, float MaxValue, ECharacterDeltaQuantization Mode)
+{
+const float Range = MaxValue - MinValue;
+const float Alpha = Range > 0.f ? FMath::Clamp((Value - MinValue) / Range, 0.f, 1.f) : 0.f;
+
+switch (Mode)
+{
+case ECharacterDeltaQuantization::Fixed16:
+Write<uint16>(Buffer, static_cast<uint16>(FMath::RoundToInt(Alpha * MAX_uint16)));
+break;
+case ECharacterDeltaQuantization::Fixed8:
+Write<uint8>(Buffer, static_cast<uint8>(FMath::RoundToInt(Alpha * MAX_uint8)));
+break;
+default:
+Write<float>(Buffer, Value);
+break;
+}
+}
+
+static float ReadQuantized(TArrayView<const uint8> Buffer, int32& Offset, bool& bError, float MinValue, float MaxValue, ECharacterDeltaQuantization Mode)
+{
+switch (Mode)
+{
+case ECharacterDeltaQuantization::Fixed16:
+return MinValue + (MaxValue - MinValue) * (Read<uint16>(Buffer, Offset, bError) / static_cast<float>(MAX_uint16));
+case ECharacterDeltaQuantization::Fixed8:
+return MinValue + (MaxValue - MinValue) * (Read<uint8>(Buffer, Offset, bError) / static_cast<float>(MAX_uint8));
+default:
+return Read<float>(Buffer, Offset, bError);
+}
+}
+
+// Strings longer than the uint16 length field are truncated, keeping the length and the characters in step
+static void WriteString(TArray<uint8>& Buffer, const FString& String)
+{
+int32 SourceLength = FMath::Min(String.Len(), static_cast<int32>(MAX_uint16));
+int32 ConvertedLength = FPlatformString::ConvertedLength<UTF16CHAR>(*String, SourceLength);
+
+// Characters outside the BMP take two UTF-16 units
+while (ConvertedLength > MAX_uint16)
+{
+ConvertedLength = FPlatformString::ConvertedLength<UTF16CHAR>(*String, --SourceLength);
+}
+
+Write<uint16>(Buffer, static_cast<uint16>(ConvertedLength));
+const int32 CharsOffset = Buffer.AddUninitialized(ConvertedLength * sizeof(UTF16CHAR));
+FPlatformString::Convert(reinterpret_cast<UTF16CHAR*>(Buffer.GetData() + CharsOffset), ConvertedLength, *String, SourceLength);
+}
+
+// Flags values the enum does not declare, including the generated _MAX
+template<typename TEnum>
+static TEnum ReadEnum(TArrayView<const uint8> Buffer, int32& Offset, bool& bError)
+{
+const uint8 Value = Read<uint8>(Buffer, Offset, bError);
+const UEnum* Enum = StaticEnum<TEnum>();
+const int32 Index = Enum->GetIndexByValue(Value);
+
+if (Index == INDEX_NONE || Index >= Enum->NumEnums() - 1)
+{
+bError = true;
+}
+
+return static_cast<TEnum>(Value);
+}
+
+// Checks a string's bounds and moves past it. Returns the offset of its length field for ReadString.
+static int32 SkipString(TArrayView<const uint8> Buffer, int32& Offset, bool& bError)
+{
+const int32 StringOffset = Offset;
+const uint16 SourceLength = Read<uint16>(Buffer, Offset, bError);
+
+if (bError || Offset + SourceLength * static_cast<int32>(sizeof(UTF16CHAR)) > Buffer.Num())
+{
+bError = true;
+return INDEX_NONE;
+}
+
+Offset += SourceLength * sizeof(UTF16CHAR);
+return StringOffset;
+}
+
+// Converts a string SkipString has already bounds-checked
+static void ReadString(TArrayView<const uint8> Buffer, int32 Offset, FString& OutString)
+{
+uint16 SourceLength = 0;
+FMemory::Memcpy(&SourceLength, Buffer.GetData() + Offset, sizeof(uint16));
+Offset += sizeof(uint16);
+
+// Copy out to keep UTF16CHAR reads aligned
+TArray<UTF16CHAR, TInlineAllocator<128>> Source;
+Source.AddUninitialized(SourceLength);
+FMemory::Memcpy(Source.GetData(), Buffer.GetData() + Offset, SourceLength * sizeof(UTF16CHAR));
+
+const int32 Length = FPlatformString::ConvertedLength<TCHAR>(Source.GetData(), SourceLength);
+
+TArray<TCHAR>& Chars = OutString.GetCharArray();
+Chars.Reset(Length + 1);
+Chars.AddUninitialized(Length + 1);
+FPlatformString::Convert(Chars.GetData(), Length, Source.GetData(), SourceLength);
+Chars[Length] = TEXT('\0');
+}
+};
+
+#pragma endregion
+
+#pragma region Rollback
+
+// Hot state of a character for one simulation frame. Fixed size and free of heap memory,
+// so a ring of these can be saved and restored every frame.
+struct FCharacterRollbackState
+{
+static constexpr int32 NumPrimaryAttributes = static_cast<int32>(EPrimaryAttributeType::Max) - 1;
+static constexpr int32 NumAbilities = 3;
+
+// Frame this state was saved for, INDEX_NONE if the slot is empty
+int32 Frame = INDEX_NONE;
+
+ECharacterState State = ECharacterState::Idle;
+float PrimaryAttributes[NumPrimaryAttributes] = {};
+float AbilityCooldowns[NumAbilities] = {};
+int32 Level = 0;
+float Experience = 0.f;
+
+// Copies the ability cooldown timers and level progress
+void CaptureProgress(const FCharacterAbilityData& Abilities, const FCharacterLevelData& LevelData)
+{
+const FCharacterAbilityModule* Modules[NumAbilities] = { &Abilities.CombatStrike, &Abilities.LaserPulse, &Abilities.PlasmaShield };
+
+for (int32 Index = 0; Index < NumAbilities; ++Index)
+{
+AbilityCooldowns[Index] = Modules[Index]->CooldownTimer;
+}
+
+Level = LevelData.Level;
+Experience = LevelData.Experience;
+}
+
+bool HasAbilityChanges(const FCharacterAbilityData& Abilities) const
+{
+return AbilityCooldowns[0] != Abilities.CombatStrike.CooldownTimer
+|| AbilityCooldowns[1] != Abilities.LaserPulse.CooldownTimer
+|| AbilityCooldowns[2] != Abilities.PlasmaShield.CooldownTimer;
+}
+
+bool HasLevelChanges(const FCharacterLevelData& LevelData) const
+{
+return Level != LevelData.Level || Experience != LevelData.Experience;
+}
+
+// Writes the saved values back as they were, bypassing setter clamps
+void RestoreAbilities(FCharacterAbilityData& Abilities) const
+{
+Abilities.CombatStrike.CooldownTimer = AbilityCooldowns[0];
+Abilities.LaserPulse.CooldownTimer = AbilityCooldowns[1];
+Abilities.PlasmaShield.CooldownTimer = AbilityCooldowns[2];
+}
+
+void RestoreLevel(FCharacterLevelData& LevelData) const
+{
+LevelData.Level = Level;
+LevelData.Experience = Experience;
+}
+};
+
+#pragma endregion
+
+#pragma region Archetype
+
+// Sections of FCharacterData that a manager can share with an archetype until first written
+enum class ECharacterDataSection : uint8
+{
+None		= 0,
+Information	= 1 << 0,
+Attribute	= 1 << 1,
+Ability		= 1 << 2,
+Protection	= 1 << 3,
+Level		= 1 << 4,
+Movement	= 1 << 5,
+All			= Information | Attribute | Ability | Protection | Level | Movement
+};
+
+ENUM_CLASS_FLAGS(ECharacterDataSection)
+
+// Shared character prototype. It is treated as immutable once managers reference it.
+typedef TSharedPtr<FCharacterData, ESPMode::ThreadSafe> FCharacterArchetypePtr;
+
+#pragma endregion
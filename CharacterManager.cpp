@@ -1,38 +1,362 @@
 #pragma region CharacterManager
 
+#pragma region Stats
+
+DECLARE_STATS_GROUP(TEXT("CharacterManager"), STATGROUP_CharacterManager, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Tick"), STAT_CharacterManager_Tick, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Update Primary Attributes"), STAT_CharacterManager_UpdatePrimaryAttributes, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Parallel Update"), STAT_CharacterManager_ParallelUpdate, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Commit Atomic Attributes"), STAT_CharacterManager_CommitAtomicAttributes, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Set Attribute"), STAT_CharacterManager_SetAttribute, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Broadcast Attribute"), STAT_CharacterManager_BroadcastAttribute, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Execute Damage"), STAT_CharacterManager_ExecuteDamage, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Regeneration Timer"), STAT_CharacterManager_RegenerationTimer, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Add Experience"), STAT_CharacterManager_AddExperience, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Level Up"), STAT_CharacterManager_LevelUp, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Publish Hud Snapshot"), STAT_CharacterManager_PublishHudSnapshot, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Flush Replication Deltas"), STAT_CharacterManager_FlushReplicationDeltas, STATGROUP_CharacterManager);
+DECLARE_CYCLE_STAT(TEXT("Evaluate Abilities"), STAT_CharacterManager_EvaluateAbilities, STATGROUP_CharacterManager);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Broadcasts"), STAT_CharacterManager_Broadcasts, STATGROUP_CharacterManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attribute Writes"), STAT_CharacterManager_AttributeWrites, STATGROUP_CharacterManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_CharacterManager_DamageEvents, STATGROUP_CharacterManager);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Level Ups"), STAT_CharacterManager_LevelUps, STATGROUP_CharacterManager);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Timers"), STAT_CharacterManager_ActiveTimers, STATGROUP_CharacterManager);
+
+CSV_DEFINE_CATEGORY(CharacterManager, true);
+
+// Cycle stat, CSV timing and trace CPU event for one scope
+#define CHARACTER_MANAGER_SCOPE(Name) \
+SCOPE_CYCLE_COUNTER(STAT_CharacterManager_##Name); \
+CSV_SCOPED_TIMING_STAT(CharacterManager, Name); \
+TRACE_CPUPROFILER_EVENT_SCOPE(CharacterManager_##Name)
+
+// Per-frame counter in stats and CSV
+#define CHARACTER_MANAGER_COUNT(Name) \
+INC_DWORD_STAT(STAT_CharacterManager_##Name); \
+CSV_CUSTOM_STAT(CharacterManager, Name, 1, ECsvCustomStatOp::Accumulate)
+
+// Regeneration timers running across all managers
+static int32 NumActiveCharacterTimers = 0;
+
+#pragma endregion
+
+#pragma region DebugLog
+
+static TAutoConsoleVariable<int32> CVarCharacterDebugLog(
+TEXT("CharacterManager.DebugLog"),
+0,
+TEXT("Enables the character debug log ring buffer."));
+
+static TAutoConsoleVariable<int32> CVarCharacterDebugLogSampleRate(
+TEXT("CharacterManager.DebugLog.SampleRate"),
+1,
+TEXT("Logs 1 in N characters."));
+
+static TAutoConsoleVariable<float> CVarCharacterDebugLogRate(
+TEXT("CharacterManager.DebugLog.Rate"),
+10.f,
+TEXT("Messages per second allowed for each context."));
+
+static TAutoConsoleVariable<int32> CVarCharacterDebugLogBurst(
+TEXT("CharacterManager.DebugLog.Burst"),
+20,
+TEXT("Messages a context may emit at once after being quiet."));
+
+static TAutoConsoleVariable<int32> CVarCharacterDebugLogEcho(
+TEXT("CharacterManager.DebugLog.Echo"),
+1,
+TEXT("Also writes kept messages to the output log."));
+
+struct FCharacterDebugLogEntry
+{
+double Time = 0.0;
+uint32 CharacterId = 0;
+FName Context;
+TCHAR Message[FCharacterDebugLog::MaxMessageLength];
+};
+
+static constexpr int32 CharacterDebugLogCapacity = 1024;
+
+static FCriticalSection CharacterDebugLogMutex;
+static TArray<FCharacterDebugLogEntry> CharacterDebugLogEntries;
+static int64 NumCharacterDebugLogEntries = 0;
+
+// Buckets are never removed, so sites can keep references
+static TMap<FName, TUniquePtr<FCharacterDebugLog::FBucket>> CharacterDebugLogBuckets;
+
+FCharacterDebugLog::FBucket& FCharacterDebugLog::FindOrAddBucket(const TCHAR* Context)
+{
+FScopeLock Lock(&CharacterDebugLogMutex);
+
+const FName ContextName(Context);
+TUniquePtr<FBucket>& Bucket = CharacterDebugLogBuckets.FindOrAdd(ContextName);
+
+if (!Bucket)
+{
+Bucket = MakeUnique<FBucket>();
+Bucket->Context = ContextName;
+}
+
+return *Bucket;
+}
+
+bool FCharacterDebugLog::ShouldEmit(FSite& Site, uint32 CharacterId)
+{
+if (CVarCharacterDebugLog.GetValueOnAnyThread() == 0)
+{
+return false;
+}
+
+// Hash first so sequential ids do not sample a fixed pattern of spawns
+const uint32 SampleRate = static_cast<uint32>(FMath::Max(1, CVarCharacterDebugLogSampleRate.GetValueOnAnyThread()));
+
+if (SampleRate > 1 && (CharacterId * 2654435761u) % SampleRate != 0)
+{
+return false;
+}
+
+const uint64 Now = FPlatformTime::Cycles64();
+const uint64 Interval = static_cast<uint64>(1.0 / (FMath::Max(0.001f, CVarCharacterDebugLogRate.GetValueOnAnyThread()) * FPlatformTime::GetSecondsPerCycle64()));
+const uint64 Tolerance = Interval * FMath::Max(0, CVarCharacterDebugLogBurst.GetValueOnAnyThread() - 1);
+
+uint64 TheoreticalArrival = Site.Bucket.TheoreticalArrival.load(std::memory_order_relaxed);
+
+for (;;)
+{
+const uint64 Start = FMath::Max(TheoreticalArrival, Now);
+
+if (Start - Now > Tolerance)
+{
+Site.Bucket.NumDropped.fetch_add(1, std::memory_order_relaxed);
+return false;
+}
+
+if (Site.Bucket.TheoreticalArrival.compare_exchange_weak(TheoreticalArrival, Start + Interval, std::memory_order_relaxed))
+{
+return true;
+}
+}
+}
+
+void FCharacterDebugLog::Emit(const FSite& Site, uint32 CharacterId, const TCHAR* Message)
+{
+if (CVarCharacterDebugLogEcho.GetValueOnAnyThread() != 0)
+{
+UE_LOG(LogTemp, Log, TEXT("[%s] %u: %s"), *Site.Bucket.Context.ToString(), CharacterId, Message);
+}
+
+FScopeLock Lock(&CharacterDebugLogMutex);
+
+if (CharacterDebugLogEntries.Num() == 0)
+{
+CharacterDebugLogEntries.SetNum(CharacterDebugLogCapacity);
+}
+
+FCharacterDebugLogEntry& Entry = CharacterDebugLogEntries[NumCharacterDebugLogEntries++ % CharacterDebugLogCapacity];
+Entry.Time = FPlatformTime::Seconds();
+Entry.CharacterId = CharacterId;
+Entry.Context = Site.Bucket.Context;
+FCString::Strncpy(Entry.Message, Message, MaxMessageLength);
+}
+
+void FCharacterDebugLog::Dump(FOutputDevice& Output, int32 MaxEntries)
+{
+FScopeLock Lock(&CharacterDebugLogMutex);
+
+const int64 NumEntries = FMath::Min<int64>(FMath::Min<int64>(NumCharacterDebugLogEntries, CharacterDebugLogCapacity), FMath::Max(0, MaxEntries));
+
+for (int64 Index = NumCharacterDebugLogEntries - NumEntries; Index < NumCharacterDebugLogEntries; ++Index)
+{
+const FCharacterDebugLogEntry& Entry = CharacterDebugLogEntries[Index % CharacterDebugLogCapacity];
+Output.Logf(TEXT("%.3f [%s] %u: %s"), Entry.Time, *Entry.Context.ToString(), Entry.CharacterId, Entry.Message);
+}
+
+for (const TPair<FName, TUniquePtr<FBucket>>& Pair : CharacterDebugLogBuckets)
+{
+const uint32 NumDropped = Pair.Value->NumDropped.load(std::memory_order_relaxed);
+
+if (NumDropped > 0)
+{
+Output.Logf(TEXT("[%s] %u messages dropped by rate limit"), *Pair.Key.ToString(), NumDropped);
+}
+}
+}
+
+static FAutoConsoleCommandWithOutputDevice CharacterDebugLogDumpCommand(
+TEXT("CharacterManager.DebugLog.Dump"),
+TEXT("Writes the character debug log ring buffer to the output."),
+FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Output)
+{
+FCharacterDebugLog::Dump(Output);
+})
+);
+
+#pragma endregion
+
+#pragma region SimulationCore
+
+static CharacterSimulation::FAttribute MakeSimulationAttribute(float MinValue, float MaxValue, float CurrentValue, float RegenerateValue)
+{
+CharacterSimulation::FAttribute Attribute;
+Attribute.MinimumValue = MinValue;
+Attribute.MaximumValue = MaxValue;
+Attribute.CurrentValue = CurrentValue;
+Attribute.RegenerateValue = RegenerateValue;
+return Attribute;
+}
+
+void UCharacterManager::ExportSimulationCharacter(CharacterSimulation::FCharacter& OutCharacter)
+{
+const FCharacterAttribute& AttributeData = ReadAttributeData();
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+CharacterSimulation::FAttribute& Attribute = OutCharacter.GetAttribute(static_cast<CharacterSimulation::EAttribute>(Index));
+
+Attribute = MakeSimulationAttribute(GetMinimumAttributeValueByType(AttributeType), GetMaximumAttributeValueByType(AttributeType), GetCurrentAttributeValueByType(AttributeType), AttributeData.FindAttributeModuleByType(AttributeType)->GetRegenerateValue());
+Attribute.bEnableUpdate = IsAttributeUpdateEnabled(AttributeType);
+}
+
+const FCharacterAbilityData& AbilityData = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData();
+
+for (const ECharacterAbilityType AbilityType : { ECharacterAbilityType::CombatStrike, ECharacterAbilityType::LaserPulse, ECharacterAbilityType::PlasmaShield })
+{
+const FCharacterAbilityModule* AbilityModule = AbilityData.FindCharacterAbilityByTypePtr(AbilityType);
+CharacterSimulation::FAbility& Ability = OutCharacter.GetAbility(static_cast<CharacterSimulation::EAbility>(static_cast<uint8>(AbilityType) - 1));
+
+Ability.PowerMin = AbilityModule->GetPowerRange().X;
+Ability.PowerMax = AbilityModule->GetPowerRange().Y;
+Ability.CooldownTimeMin = AbilityModule->GetCooldownTimeRange().X;
+Ability.CooldownTimeMax = AbilityModule->GetCooldownTimeRange().Y;
+Ability.CostMin = AbilityModule->GetCostRange().X;
+Ability.CostMax = AbilityModule->GetCostRange().Y;
+Ability.Range = AbilityModule->GetRange();
+Ability.CostPool = static_cast<CharacterSimulation::ECostPool>(AbilityModule->GetCostType());
+Ability.bDealsDamage = AbilityModule->GetEffectType() == EAbilityEffectType::Damage;
+Ability.CooldownTimer = AbilityModule->GetCooldownTimer();
+}
+
+const FCharacterLevelData& LevelData = ReadCharacterData(ECharacterDataSection::Level).GetLevelData();
+const TArray<float>& ExperienceThresholds = LevelData.GetExperienceThreshold();
+
+OutCharacter.Level.Experience = LevelData.GetExperience();
+OutCharacter.Level.Level = LevelData.GetLevel();
+OutCharacter.Level.MaxLevel = LevelData.GetMaxLevel();
+OutCharacter.Level.ExperienceThreshold.assign(ExperienceThresholds.GetData(), ExperienceThresholds.GetData() + ExperienceThresholds.Num());
+
+OutCharacter.bDead = GetStoredCharacterState() == ECharacterState::Death;
+}
+
+CharacterSimulation::FProtection UCharacterManager::ExportSimulationProtection(EProtectionType Type)
+{
+CharacterSimulation::FProtection Protection;
+Protection.Value = GetValueByType(Type);
+Protection.Multiplier = GetMultiplierByType(Type);
+Protection.Amplifier = GetAmplifierByType(Type);
+return Protection;
+}
+
+#pragma endregion
+
 #pragma region Delegate
 
 void UCharacterManager::SetupDelegates()
 {
 /*State*/
-OnCharacterStateChanged.AddDynamic(this, &UCharacterManager::BindOnCharacterStateChanged);
+StateChangedEvents.Subscribe(this, [](void* Context, const FCharacterStateChangedEvent& Event)
+{
+static_cast<UCharacterManager*>(Context)->BindOnCharacterStateChanged(Event.NewState);
+});
+
+/*Attribute*/
+AttributeChangedEvents.Subscribe(this, [](void* Context, const FCharacterAttributeChangedEvent& Event)
+{
+UCharacterManager* Manager = static_cast<UCharacterManager*>(Context);
+
+switch (Event.AttributeType)
+{
+case ECharacterAttributeType::Health:
+Manager->BindOnHealthAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Stamina:
+Manager->BindOnStaminaAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Energy:
+Manager->BindOnEnergyAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Shield:
+Manager->BindOnShieldAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Output:
+Manager->BindOnOutputAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Actuation:
+Manager->BindOnActuationAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Integrity:
+Manager->BindOnIntegrityAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Capacity:
+Manager->BindOnCapacityAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+case ECharacterAttributeType::Regeneration:
+Manager->BindOnRegenerationAttributeChanged(Event.MinValue, Event.MaxValue, Event.CurrentValue);
+break;
+default:
+break;
+}
+});
+}
+
+void UCharacterManager::BroadcastStateChanged(ECharacterState NewState)
+{
+CHARACTER_MANAGER_COUNT(Broadcasts);
+
+StateChangedEvents.Broadcast({ this, NewState });
+
+if (bBroadcastBlueprintDelegates)
+{
+OnCharacterStateChanged.Broadcast(NewState);
+}
+}
 
-// Health
-OnHealthAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnHealthAttributeChanged);
+void UCharacterManager::BroadcastTypeChanged(ECharacterType NewType)
+{
+CHARACTER_MANAGER_COUNT(Broadcasts);
 
-// Stamina
-OnStaminaAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnStaminaAttributeChanged);
+TypeChangedEvents.Broadcast({ this, NewType });
 
-// Energy
-OnEnergyAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnEnergyAttributeChanged);
+if (bBroadcastBlueprintDelegates)
+{
+OnCharacterTypeChanged.Broadcast(NewType);
+}
+}
 
-// Shield
-OnShieldAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnShieldAttributeChanged);
+void UCharacterManager::BroadcastTitleChanged(const FString& NewTitle)
+{
+CHARACTER_MANAGER_COUNT(Broadcasts);
 
-// Output
-OnOutputAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnOutputAttributeChanged);
+TitleChangedEvents.Broadcast({ this, NewTitle });
 
-// Actuation
-OnActuationAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnActuationAttributeChanged);
+if (bBroadcastBlueprintDelegates)
+{
+OnCharacterTitleChanged.Broadcast(NewTitle);
+}
+}
 
-// Integrity
-OnIntegrityAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnIntegrityAttributeChanged);
+void UCharacterManager::BroadcastDescriptionChanged(const FString& NewDescription)
+{
+CHARACTER_MANAGER_COUNT(Broadcasts);
 
-// Capacity
-OnCapacityAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnCapacityAttributeChanged);
+DescriptionChangedEvents.Broadcast({ this, NewDescription });
 
-// Regeneration
-OnRegenerationAttributeChanged.AddDynamic(this, &UCharacterManager::BindOnRegenerationAttributeChanged);
+if (bBroadcastBlueprintDelegates)
+{
+OnCharacterDescriptionChanged.Broadcast(NewDescription);
+}
 }
 
 void UCharacterManager::BindOnCharacterStateChanged(ECharacterState NewCharacterState)
@@ -60,1253 +384,5950 @@ break;
 
 void UCharacterManager::BindOnHealthAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Health Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Health Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnStaminaAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Stamina Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Stamina Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnEnergyAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Energy Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Energy Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnShieldAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Shield Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Shield Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnOutputAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Output Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Output Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnActuationAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Actuation Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Actuation Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnIntegrityAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Integrity Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Integrity Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnCapacityAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Capacity Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Capacity Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
 void UCharacterManager::BindOnRegenerationAttributeChanged(float MinValue, float MaxValue, float CurrentValue)
 {
-UE_LOG(LogTemp, Warning, TEXT("Regeneration Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeChanged", TEXT("Regeneration Attribute Changed: Min: %f, Max: %f, Current: %f"), MinValue, MaxValue, CurrentValue);
 }
 
-#pragma endregion
-
-#pragma region Constructor
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterEventBusBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkEventBus"),
+TEXT("Compares native channel and Blueprint delegate broadcast cost by subscriber count. Usage: CharacterManager.BenchmarkEventBus [MaxSubscribers] [Broadcasts]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 MaxSubscribers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64;
+const int32 NumBroadcasts = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100000;
 
-UCharacterManager::UCharacterManager()
+for (int32 NumSubscribers = 1; NumSubscribers <= MaxSubscribers; NumSubscribers *= 2)
 {
-PrimaryComponentTick.bCanEverTick = true;
-SetupDelegates();
-}
+TCharacterEventChannel<FCharacterAttributeChangedEvent> Channel;
+FOnHealthAttributeChangedSignature Delegate;
+TArray<UCharacterManager*> Listeners;
 
-#pragma endregion
+// Static so the captureless handler can count
+static int64 NativeCalls;
+NativeCalls = 0;
 
-#pragma region BeginPlay
+for (int32 Index = 0; Index < NumSubscribers; ++Index)
+{
+// Managers are the listeners on the Blueprint side, so no dev-only UCLASS is needed for a UFUNCTION target
+UCharacterManager* Listener = NewObject<UCharacterManager>(GetTransientPackage());
+Listeners.Add(Listener);
 
-void UCharacterManager::BeginPlay()
+// A UObject context, so the weak tracking is part of the measured cost
+Channel.Subscribe(Listener, [](void* Context, const FCharacterAttributeChangedEvent& Event)
 {
-Super::BeginPlay();
+++NativeCalls;
+});
+
+// Bound by name, the handler is private; it costs one sampled debug-log check
+FScriptDelegate ScriptDelegate;
+ScriptDelegate.BindUFunction(Listener, TEXT("BindOnHealthAttributeChanged"));
+Delegate.Add(ScriptDelegate);
 }
 
-#pragma endregion
+const FCharacterAttributeChangedEvent Event = { nullptr, ECharacterAttributeType::Health, 0.f, 100.f, 50.f };
 
-#pragma region Tick 
+const double NativeStart = FPlatformTime::Seconds();
 
-void UCharacterManager::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+for (int32 Index = 0; Index < NumBroadcasts; ++Index)
 {
-UpdatePrimaryAttributes(DeltaTime);
+Channel.Broadcast(Event);
 }
 
-void UCharacterManager::DebugTick(FCharacterDebugData& Debug, const FString& Context, const FString& Message)
-{
-if (!Debug.bEnableLog || !GetWorld())
+const double NativeSeconds = FPlatformTime::Seconds() - NativeStart;
+const double DynamicStart = FPlatformTime::Seconds();
+
+for (int32 Index = 0; Index < NumBroadcasts; ++Index)
 {
-return;
+Delegate.Broadcast(Event.MinValue, Event.MaxValue, Event.CurrentValue);
 }
 
-const float DeltaTime = GetWorld()->GetDeltaSeconds();
+const double DynamicSeconds = FPlatformTime::Seconds() - DynamicStart;
 
-Debug.LogTimer += DeltaTime;
-Debug.LogAccumulatedTime += DeltaTime;
+const int64 TotalCalls = NativeCalls;
 
-if(Debug.LogTimer >= Debug.LogInterval && Debug.LogAccumulatedTime <= Debug.LogDuration)
+for (UCharacterManager* Listener : Listeners)
 {
-UE_LOG(
-LogTemp,
-Log,
-TEXT("[%s] %s"),
-*Context,
-*Message
+Listener->MarkAsGarbage();
+}
+
+UE_LOG(LogTemp, Log, TEXT("Subscribers: %3d | Native: %8.1f ns | Blueprint: %8.1f ns per broadcast | Calls: %lld"),
+NumSubscribers,
+NativeSeconds * 1000000000.0 / NumBroadcasts,
+DynamicSeconds * 1000000000.0 / NumBroadcasts,
+TotalCalls);
+}
+})
 );
+#endif
+
+#pragma endregion
+
+#pragma region Constructor
+
+UCharacterManager::UCharacterManager()
+{
+PrimaryComponentTick.bCanEverTick = true;
+SetupDelegates();
 
-Debug.LogTimer = 0.0f;
-Debug.LogAccumulatedTime = 0.0f;
+// Instances copy the character data of their template
+if (HasAnyFlags(RF_ClassDefaultObject))
+{
+CharacterDataStorage.InitializeAs<FCharacterData>();
 }
 }
 
-#pragma endregion
+void UCharacterManager::PostInitProperties()
+{
+Super::PostInitProperties();
 
-#pragma region CharacterState
+// Attribute accessors read the compact storage as soon as the flag is set, so it has to be valid before BeginPlay
+if (bUseCompactAttributes)
+{
+EnableCompactAttributes();
+}
+}
 
-void UCharacterManager::SetCharacterState(ECharacterState NewState)
+void UCharacterManager::PostLoad()
 {
-CharacterData.SetCharacterState(NewState);
-OnCharacterStateChanged.Broadcast(NewState);
+Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+// Deprecated properties are never saved, so the inline data only differs from the defaults after loading an old package
+static const FCharacterData DefaultData;
+
+if (!FCharacterData::StaticStruct()->CompareScriptStruct(&CharacterData_DEPRECATED, &DefaultData, PPF_None))
+{
+AllocateCharacterData() = CharacterData_DEPRECATED;
+CharacterData_DEPRECATED = FCharacterData();
 }
+#endif
 
-ECharacterState UCharacterManager::GetCharacterState()
+if (bUseCompactAttributes)
 {
-return CharacterData.GetCharacterState();
+EnableCompactAttributes();
+}
 }
 
-void UCharacterManager::HandleOnDeathState()
+#if WITH_EDITOR
+void UCharacterManager::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
-check(OwnerCharacter);
+Super::PostEditChangeProperty(PropertyChangedEvent);
 
-bool AI = CharacterData.IsAI();
-bool Player = CharacterData.IsPlayer();
+const FName PropertyName = PropertyChangedEvent.GetMemberPropertyName();
 
-if (Player)
+if (PropertyName != GET_MEMBER_NAME_CHECKED(UCharacterManager, bUseCompactAttributes) && PropertyName != GET_MEMBER_NAME_CHECKED(UCharacterManager, CharacterDataStorage))
 {
-OwnerCharacter->PlayerHandleOnDeathState();
+return;
 }
-else if (AI)
+
+if (bUseCompactAttributes)
 {
-OwnerCharacter->AIHandleOnDeathState();
+EnableCompactAttributes();
 }
-else
+else if (CompactAttributeData.IsValid())
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("HandleOnDeathState: Character Type is not valid."));
-#endif
+// The flag was cleared by the edit, expand the values the compact storage still holds
+bUseCompactAttributes = true;
+DisableCompactAttributes();
 }
 }
+#endif
 
 #pragma endregion
 
-#pragma region CharacterType
+#pragma region BeginPlay
 
-ECharacterType UCharacterManager::GetCharacterType()
+void UCharacterManager::BeginPlay()
 {
+Super::BeginPlay();
 
-return CharacterData.GetCharacterType();
+PublishState();
 }
 
-void UCharacterManager::SetCharacterType(ECharacterType NewType)
+#pragma endregion
+
+#pragma region Registration
+
+void UCharacterManager::OnRegister()
 {
-CharacterData.SetCharacterType(NewType);
-OnCharacterTypeChanged.Broadcast(NewType);
-}
+Super::OnRegister();
 
-bool UCharacterManager::IsPlayerCharacter()
+if (RegisteredIndex != INDEX_NONE || IsTemplate())
 {
-return CharacterData.GetCharacterType() == ECharacterType::Player;
+return;
 }
 
-bool UCharacterManager::IsAICharacter()
+if (UWorld* World = GetWorld())
+{
+if (UCharacterManagerRegistrySubsystem* WorldRegistry = World->GetSubsystem<UCharacterManagerRegistrySubsystem>())
 {
-return CharacterData.GetCharacterType() == ECharacterType::AI;
+Registry = WorldRegistry;
+RegisteredIndex = WorldRegistry->Managers.Add(this);
+}
+}
 }
 
-#pragma endregion
+const TArray<UCharacterManager*>& UCharacterManager::GetRegisteredManagers(const UWorld* World)
+{
+static const TArray<UCharacterManager*> NoManagers;
 
-#pragma region Information
+const UCharacterManagerRegistrySubsystem* WorldRegistry = World ? World->GetSubsystem<UCharacterManagerRegistrySubsystem>() : nullptr;
+return WorldRegistry ? WorldRegistry->GetManagers() : NoManagers;
+}
 
-FString UCharacterManager::GetTitle()
+void UCharacterManager::OnUnregister()
 {
-return CharacterData.GetInformationData().GetTitle();
+RemoveFromReplicationQueue();
+
+RemoveFromRegistry();
+StopPrimaryAttributeRegeneration();
+
+Super::OnUnregister();
 }
 
-FString UCharacterManager::GetDescription()
+void UCharacterManager::RemoveFromRegistry()
 {
-return CharacterData.GetInformationData().GetDescription();
+if (RegisteredIndex == INDEX_NONE)
+{
+return;
 }
 
-void UCharacterManager::SetTitle(const FString& NewTitle)
+// Gone together with its world, nothing left to remove from
+if (UCharacterManagerRegistrySubsystem* WorldRegistry = Registry.Get())
 {
-CharacterData.GetInformationData().SetTitle(NewTitle);
-OnCharacterTitleChanged.Broadcast(NewTitle);
+TArray<UCharacterManager*>& Managers = WorldRegistry->Managers;
+
+// Swap removal keeps the registry dense; the moved manager takes over our index
+Managers.RemoveAtSwap(RegisteredIndex);
+
+if (Managers.IsValidIndex(RegisteredIndex))
+{
+Managers[RegisteredIndex]->RegisteredIndex = RegisteredIndex;
+}
 }
 
-void UCharacterManager::SetDescription(const FString& NewDescription)
+Registry.Reset();
+RegisteredIndex = INDEX_NONE;
+}
+
+void UCharacterManager::BeginDestroy()
 {
-CharacterData.GetInformationData().SetDescription(NewDescription);
-OnCharacterDescriptionChanged.Broadcast(NewDescription);
+// Unregistered managers (e.g. archetype spawns in the transient package) can still be queued
+RemoveFromReplicationQueue();
+
+RemoveFromRegistry();
+
+Super::BeginDestroy();
 }
 
 #pragma endregion
 
-#pragma region Attribute
+#pragma region Tick 
 
-float UCharacterManager::GetCurrentAttributeValueByType(ECharacterAttributeType AttributeType)
+static TAutoConsoleVariable<int32> CVarCharacterParallelUpdate(
+TEXT("CharacterManager.ParallelUpdate"),
+0,
+TEXT("Updates character attributes and cooldowns for all managers in a parallel phase at world tick start instead of per component tick."));
+
+static TAutoConsoleVariable<int32> CVarCharacterParallelUpdateThreads(
+TEXT("CharacterManager.ParallelUpdateThreads"),
+0,
+TEXT("Maximum number of parallel tasks for CharacterManager.ParallelUpdate. 0 uses all worker threads."));
+
+void UCharacterManager::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
-switch (AttributeType)
+CHARACTER_MANAGER_SCOPE(Tick);
+CSV_CUSTOM_STAT(CharacterManager, ActiveTimers, NumActiveCharacterTimers, ECsvCustomStatOp::Set);
+
+if (bUseAtomicAttributes)
+{
+CommitAtomicAttributes();
+}
+
+if (CVarCharacterParallelUpdate.GetValueOnGameThread() == 0)
+{
+UpdatePrimaryAttributes(DeltaTime);
+}
+
+if (bPublishHudSnapshot)
+{
+PublishHudSnapshot();
+}
+
+if (bMovementParametersDirty)
+{
+PushMovementParameters();
+}
+
+PublishState();
+}
+
+#pragma endregion
+
+#pragma region CharacterData
+
+int32 UCharacterManager::SaveCharacterSnapshot(TArray<uint8>& OutBuffer)
+{
+if (Archetype.IsValid())
+{
+return FCharacterSnapshotSerializer::Serialize(ComposeCharacterData(), OutBuffer);
+}
+
+SyncCompactAttributesToCharacterData();
+return FCharacterSnapshotSerializer::Serialize(ReadCharacterData(ECharacterDataSection::All), OutBuffer);
+}
+
+bool UCharacterManager::LoadCharacterSnapshot(const TArray<uint8>& Buffer)
+{
+// The snapshot carries the hot state as well
+MaterializeArchetype();
+
+const bool bLoaded = FCharacterSnapshotSerializer::Deserialize(Buffer, AllocateCharacterData());
+SyncCompactAttributesFromCharacterData();
+RefreshAtomicAttributes();
+return bLoaded;
+}
+
+bool UCharacterManager::InitializeFromArchetype(const FCharacterArchetypeArchive& Archive, uint32 ArchetypeKey)
+{
+MaterializeArchetype();
+
+const bool bInitialized = Archive.InitializeCharacterData(ArchetypeKey, AllocateCharacterData());
+SyncCompactAttributesFromCharacterData();
+RefreshAtomicAttributes();
+return bInitialized;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterSnapshotBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkSnapshot"),
+TEXT("Measures character snapshot serialize and deserialize throughput. Usage: CharacterManager.BenchmarkSnapshot [Iterations]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+FCharacterData Source;
+FCharacterData Target;
+TArray<uint8> Buffer;
+const int32 SnapshotSize = FCharacterSnapshotSerializer::Serialize(Source, Buffer);
+
+// Binary snapshot write
+double StartTime = FPlatformTime::Seconds();
+for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+{
+FCharacterSnapshotSerializer::Serialize(Source, Buffer);
+}
+const double SerializeSeconds = FPlatformTime::Seconds() - StartTime;
+
+// Binary snapshot read
+StartTime = FPlatformTime::Seconds();
+for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+{
+FCharacterSnapshotSerializer::Deserialize(Buffer, Target);
+}
+const double DeserializeSeconds = FPlatformTime::Seconds() - StartTime;
+
+// Reflection write for comparison
+TArray<uint8> ReflectionBuffer;
+StartTime = FPlatformTime::Seconds();
+for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+{
+ReflectionBuffer.Reset();
+FMemoryWriter Writer(ReflectionBuffer);
+FCharacterData::StaticStruct()->SerializeItem(Writer, &Source, nullptr);
+}
+const double ReflectionSeconds = FPlatformTime::Seconds() - StartTime;
+
+const double SnapshotMegaBytes = static_cast<double>(SnapshotSize) * Iterations / (1024.0 * 1024.0);
+const double ReflectionMegaBytes = static_cast<double>(ReflectionBuffer.Num()) * Iterations / (1024.0 * 1024.0);
+
+UE_LOG(LogTemp, Log, TEXT("Snapshot: %d bytes | Serialize: %.1f MB/s | Deserialize: %.1f MB/s"),
+SnapshotSize, SnapshotMegaBytes / SerializeSeconds, SnapshotMegaBytes / DeserializeSeconds);
+UE_LOG(LogTemp, Log, TEXT("Reflection: %d bytes | Serialize: %.1f MB/s"),
+ReflectionBuffer.Num(), ReflectionMegaBytes / ReflectionSeconds);
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Archetype
+
+// Frees the heap memory of the reflected strings and arrays of a struct, including external ones such as FProtectionData
+static void ReleaseStructHeap(const UStruct* Struct, void* Data)
+{
+for (TFieldIterator<FProperty> It(Struct); It; ++It)
+{
+if (const FStrProperty* StrProperty = CastField<FStrProperty>(*It))
+{
+StrProperty->GetPropertyValuePtr_InContainer(Data)->Empty();
+}
+else if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(*It))
+{
+FScriptArrayHelper_InContainer(ArrayProperty, Data).EmptyValues();
+}
+else if (const FStructProperty* StructProperty = CastField<FStructProperty>(*It))
+{
+ReleaseStructHeap(StructProperty->Struct, StructProperty->ContainerPtrToValuePtr<void>(Data));
+}
+}
+}
+
+void UCharacterManager::SpawnFromArchetype(const FCharacterArchetypePtr& InArchetype)
+{
+check(InArchetype.IsValid());
+
+Archetype = InArchetype;
+OwnedSections = ECharacterDataSection::None;
+bResistanceMatrixDirty = true;
+bMovementParametersDirty = true;
+
+// Every section is served by the archetype until it is overridden. Storage a pooled manager
+// allocated in an earlier life is kept and reused by the first override.
+
+// Hot state
+InstanceState = ECharacterState::Idle;
+InstanceType = Archetype->GetCharacterType();
+EnableCompactAttributes(Archetype->GetAttributeData());
+RefreshAtomicAttributes();
+
+MarkFullReplicationDirty();
+}
+
+void UCharacterManager::MaterializeArchetype()
+{
+if (!Archetype.IsValid())
+{
+return;
+}
+
+FCharacterData& Data = WriteCharacterData(ECharacterDataSection::All);
+Data.SetCharacterState(InstanceState);
+Data.SetCharacterType(InstanceType);
+
+// Compact attributes were re-targeted to the copied attributes and keep their values
+Archetype.Reset();
+OwnedSections = ECharacterDataSection::None;
+}
+
+void UCharacterManager::DetachArchetype()
+{
+Archetype.Reset();
+OwnedSections = ECharacterDataSection::None;
+bResistanceMatrixDirty = true;
+bMovementParametersDirty = true;
+
+if (bUseCompactAttributes)
+{
+EnableCompactAttributes();
+}
+}
+
+void UCharacterManager::SetStoredCharacterState(ECharacterState NewState)
+{
+if (Archetype.IsValid())
+{
+InstanceState = NewState;
+}
+else
+{
+AllocateCharacterData().SetCharacterState(NewState);
+}
+}
+
+void UCharacterManager::SetStoredCharacterType(ECharacterType NewType)
+{
+if (Archetype.IsValid())
+{
+InstanceType = NewType;
+}
+else
+{
+AllocateCharacterData().SetCharacterType(NewType);
+}
+}
+
+FCharacterData& UCharacterManager::AllocateCharacterData()
+{
+if (CharacterDataStorage.IsValid())
+{
+return CharacterDataStorage.GetMutable();
+}
+
+if (Archetype.IsValid())
+{
+CharacterDataStorage.InitializeAs<FCharacterData>();
+
+// Sections that are not overridden stay with the archetype and need no heap memory of their own
+ReleaseStructHeap(FCharacterData::StaticStruct(), &CharacterDataStorage.GetMutable());
+}
+else
+{
+// Starts from the same class defaults ReadCharacterData served while nothing was allocated
+CharacterDataStorage.InitializeAs<FCharacterData>(ReadCharacterData(ECharacterDataSection::None));
+}
+
+return CharacterDataStorage.GetMutable();
+}
+
+FCharacterData& UCharacterManager::WriteCharacterData(ECharacterDataSection Section)
+{
+// Callers may change protection and movement through the returned data
+if (EnumHasAnyFlags(Section, ECharacterDataSection::Protection))
+{
+bResistanceMatrixDirty = true;
+}
+
+if (EnumHasAnyFlags(Section, ECharacterDataSection::Movement))
+{
+bMovementParametersDirty = true;
+}
+
+const ECharacterDataSection SectionsToCopy = Archetype.IsValid() ? (Section & ~OwnedSections) : ECharacterDataSection::None;
+
+if (SectionsToCopy == ECharacterDataSection::None)
+{
+return AllocateCharacterData();
+}
+
+FCharacterData& Overrides = AllocateCharacterData();
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Information))
+{
+Overrides.SetInformationData(Archetype->GetInformationData());
+}
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Attribute))
+{
+Overrides.SetAttributeData(Archetype->GetAttributeData());
+
+if (bUseCompactAttributes && CompactAttributeData.GetArchetype() == &Archetype->GetAttributeData())
+{
+CompactAttributeData.SetArchetype(Overrides.GetAttributeData());
+}
+}
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Ability))
+{
+Overrides.SetAbilityData(Archetype->GetAbilityData());
+}
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Protection))
+{
+Overrides.SetProtectionData(Archetype->GetProtectionData());
+}
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Level))
+{
+Overrides.SetLevelData(Archetype->GetLevelData());
+}
+
+if (EnumHasAnyFlags(SectionsToCopy, ECharacterDataSection::Movement))
+{
+Overrides.SetMovementData(Archetype->GetMovementData());
+}
+
+OwnedSections |= SectionsToCopy;
+
+return Overrides;
+}
+
+FCharacterData UCharacterManager::ComposeCharacterData() const
+{
+FCharacterData Result;
+ComposeCharacterData(Result, ECharacterDataSection::All);
+return Result;
+}
+
+void UCharacterManager::ComposeCharacterData(FCharacterData& OutData, ECharacterDataSection Sections) const
+{
+OutData.SetCharacterState(GetStoredCharacterState());
+OutData.SetCharacterType(GetStoredCharacterType());
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Information))
+{
+OutData.SetInformationData(ReadCharacterData(ECharacterDataSection::Information).GetInformationData());
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Attribute))
+{
+OutData.SetAttributeData(ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData());
+
+if (bUseCompactAttributes)
+{
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+*OutData.GetAttributeData().FindAttributeModuleByType(AttributeType) = CompactAttributeData.ToAttributeModule(AttributeType);
+}
+}
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Ability))
+{
+OutData.SetAbilityData(ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData());
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Protection))
+{
+OutData.SetProtectionData(ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData());
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Level))
+{
+OutData.SetLevelData(ReadCharacterData(ECharacterDataSection::Level).GetLevelData());
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Movement))
+{
+OutData.SetMovementData(ReadCharacterData(ECharacterDataSection::Movement).GetMovementData());
+}
+}
+
+static SIZE_T GetStructHeapSize(const UStruct* Struct, const void* Data);
+
+// Heap bytes owned by a reflected FString, TArray, struct or Blueprint delegate member
+static SIZE_T GetPropertyHeapSize(const FProperty* Property, const void* Data)
+{
+if (const FStrProperty* StrProperty = CastField<FStrProperty>(Property))
+{
+return StrProperty->GetPropertyValue_InContainer(Data).GetAllocatedSize();
+}
+
+if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+{
+return ArrayProperty->ContainerPtrToValuePtr<FScriptArray>(Data)->GetAllocatedSize(ArrayProperty->Inner->GetSize());
+}
+
+if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+{
+return GetStructHeapSize(StructProperty->Struct, StructProperty->ContainerPtrToValuePtr<void>(Data));
+}
+
+if (const FMulticastInlineDelegateProperty* DelegateProperty = CastField<FMulticastInlineDelegateProperty>(Property))
+{
+return DelegateProperty->ContainerPtrToValuePtr<FMulticastScriptDelegate>(Data)->GetAllocatedSize();
+}
+
+return 0;
+}
+
+// Heap bytes owned by the reflected members of a struct
+static SIZE_T GetStructHeapSize(const UStruct* Struct, const void* Data)
+{
+SIZE_T HeapSize = 0;
+
+for (TFieldIterator<FProperty> It(Struct); It; ++It)
+{
+HeapSize += GetPropertyHeapSize(*It, Data);
+}
+
+return HeapSize;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterArchetypeMemoryBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkArchetypeMemory"),
+TEXT("Reports per-instance memory of default managers, archetype spawns and archetype spawns with one overridden section. Usage: CharacterManager.BenchmarkArchetypeMemory [Count]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 Count = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+
+FCharacterArchetypePtr Prototype = MakeShared<FCharacterData, ESPMode::ThreadSafe>();
+Prototype->SetCharacterType(ECharacterType::AI);
+
+const TCHAR* const ModeNames[] = { TEXT("Default"), TEXT("Archetype"), TEXT("Archetype with override") };
+double DefaultBytesPerInstance = 0.0;
+
+for (int32 Mode = 0; Mode < UE_ARRAY_COUNT(ModeNames); ++Mode)
+{
+TArray<UCharacterManager*> Managers;
+Managers.Reserve(Count);
+
+const double StartTime = FPlatformTime::Seconds();
+
+for (int32 Index = 0; Index < Count; ++Index)
+{
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
+
+if (Mode == 0)
+{
+Manager->GetCharacterData() = *Prototype;
+}
+else
+{
+Manager->SpawnFromArchetype(Prototype);
+}
+
+Managers.Add(Manager);
+}
+
+const double SpawnSeconds = FPlatformTime::Seconds() - StartTime;
+
+FCharacterMemoryUsage Total;
+SIZE_T SharedBytes = 0;
+
+for (UCharacterManager* Manager : Managers)
+{
+// A single overridden section copies the character data out of line
+if (Mode == 2)
+{
+Manager->SetTitle(TEXT("Override"));
+}
+
+FCharacterMemoryUsage Usage = Manager->GetMemoryUsage();
+
+// Paid once for all instances
+SharedBytes = Usage.SharedHeapBytes;
+Usage.SharedHeapBytes = 0;
+Total += Usage;
+
+Manager->MarkAsGarbage();
+}
+
+const double BytesPerInstance = static_cast<double>(Total.GetOwnedBytes() + SharedBytes) / Count;
+
+if (Mode == 0)
+{
+DefaultBytesPerInstance = BytesPerInstance;
+}
+
+UE_LOG(LogTemp, Log, TEXT("%s: %.1f inline + %.1f heap bytes per instance, %llu shared bytes | %.1f%% of the default | Spawn: %.3f us per instance"),
+ModeNames[Mode],
+static_cast<double>(Total.GetInlineBytes()) / Count,
+static_cast<double>(Total.GetHeapBytes()) / Count,
+static_cast<uint64>(SharedBytes),
+DefaultBytesPerInstance > 0.0 ? BytesPerInstance * 100.0 / DefaultBytesPerInstance : 100.0,
+SpawnSeconds * 1000000.0 / Count);
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region MemoryReport
+
+static TAutoConsoleVariable<int32> CVarCharacterMemoryBudget(
+TEXT("CharacterManager.MemoryBudget"),
+0,
+TEXT("Average bytes a character of one archetype may cost in CharacterManager.MemoryReport, shared bytes included. 0 disables the check."));
+
+static TAutoConsoleVariable<FString> CVarCharacterMemoryArchetypeBudgets(
+TEXT("CharacterManager.MemoryArchetypeBudgets"),
+TEXT(""),
+TEXT("Per-archetype budgets overriding CharacterManager.MemoryBudget, as Title=Bytes pairs separated by spaces, e.g. \"Grunt=2048 Boss=16384\"."));
+
+// Adds Title=Bytes tokens to Budgets, other tokens are ignored
+static void ParseCharacterArchetypeBudgets(const TArray<FString>& Tokens, TMap<FString, SIZE_T>& Budgets)
+{
+for (const FString& Token : Tokens)
+{
+FString Title;
+FString Bytes;
+
+if (Token.Split(TEXT("="), &Title, &Bytes) && Bytes.IsNumeric())
+{
+Budgets.Add(Title, static_cast<SIZE_T>(FMath::Max(FCString::Atoi64(*Bytes), 0ll)));
+}
+}
+}
+
+const TCHAR* FCharacterMemoryUsage::GetSectionName(int32 Section)
+{
+static const TCHAR* const SectionNames[NumSections] = { TEXT("Information"), TEXT("Attribute"), TEXT("Ability"), TEXT("Protection"), TEXT("Level"), TEXT("Movement"), TEXT("Manager") };
+return Section >= 0 && Section < NumSections ? SectionNames[Section] : TEXT("Invalid");
+}
+
+SIZE_T FCharacterMemoryUsage::GetInlineBytes() const
+{
+SIZE_T Bytes = 0;
+
+for (int32 Section = 0; Section < NumSections; ++Section)
+{
+Bytes += InlineBytes[Section];
+}
+
+return Bytes;
+}
+
+SIZE_T FCharacterMemoryUsage::GetHeapBytes() const
+{
+SIZE_T Bytes = 0;
+
+for (int32 Section = 0; Section < NumSections; ++Section)
+{
+Bytes += HeapBytes[Section];
+}
+
+return Bytes;
+}
+
+FCharacterMemoryUsage& FCharacterMemoryUsage::operator+=(const FCharacterMemoryUsage& Other)
+{
+for (int32 Section = 0; Section < NumSections; ++Section)
+{
+InlineBytes[Section] += Other.InlineBytes[Section];
+HeapBytes[Section] += Other.HeapBytes[Section];
+}
+
+SharedHeapBytes += Other.SharedHeapBytes;
+return *this;
+}
+
+FCharacterMemoryUsage UCharacterManager::GetMemoryUsage() const
+{
+FCharacterMemoryUsage Usage;
+
+// Null for a character spawned from an archetype that has not overridden a section yet
+const FCharacterData* OwnedData = CharacterDataStorage.GetPtr();
+const FCharacterData* SharedData = Archetype.Get();
+SIZE_T SectionBytes = 0;
+
+// The character data is held out of line, so a section costs its full size on the heap. The sections of an
+// override copy that are still served by the archetype are empty but take their size as well.
+const auto AddSection = [this, OwnedData, &Usage, &SectionBytes](FCharacterMemoryUsage::ESection Index, ECharacterDataSection Section, const UScriptStruct* Struct, const void* OwnedSection, const void* ArchetypeSection)
+{
+SectionBytes += Struct->GetStructureSize();
+
+if (OwnedData)
+{
+Usage.HeapBytes[Index] = Struct->GetStructureSize() + GetStructHeapSize(Struct, OwnedSection);
+}
+
+if (Archetype.IsValid() && !EnumHasAllFlags(OwnedSections, Section))
+{
+Usage.SharedHeapBytes += Struct->GetStructureSize() + GetStructHeapSize(Struct, ArchetypeSection);
+}
+};
+
+AddSection(FCharacterMemoryUsage::Information, ECharacterDataSection::Information, FInformationData::StaticStruct(),
+OwnedData ? &OwnedData->GetInformationData() : nullptr, SharedData ? &SharedData->GetInformationData() : nullptr);
+AddSection(FCharacterMemoryUsage::Attribute, ECharacterDataSection::Attribute, FCharacterAttribute::StaticStruct(),
+OwnedData ? &OwnedData->GetAttributeData() : nullptr, SharedData ? &SharedData->GetAttributeData() : nullptr);
+AddSection(FCharacterMemoryUsage::Ability, ECharacterDataSection::Ability, FCharacterAbilityData::StaticStruct(),
+OwnedData ? &OwnedData->GetAbilityData() : nullptr, SharedData ? &SharedData->GetAbilityData() : nullptr);
+AddSection(FCharacterMemoryUsage::Protection, ECharacterDataSection::Protection, FProtectionData::StaticStruct(),
+OwnedData ? &OwnedData->GetProtectionData() : nullptr, SharedData ? &SharedData->GetProtectionData() : nullptr);
+AddSection(FCharacterMemoryUsage::Level, ECharacterDataSection::Level, FCharacterLevelData::StaticStruct(),
+OwnedData ? &OwnedData->GetLevelData() : nullptr, SharedData ? &SharedData->GetLevelData() : nullptr);
+AddSection(FCharacterMemoryUsage::Movement, ECharacterDataSection::Movement, FCharacterMovementData::StaticStruct(),
+OwnedData ? &OwnedData->GetMovementData() : nullptr, SharedData ? &SharedData->GetMovementData() : nullptr);
+
+// The component itself, including the pointer to the character data and the hot state of archetype spawns
+Usage.InlineBytes[FCharacterMemoryUsage::Manager] = GetClass()->GetStructureSize();
+
+// Compact attributes are the only attribute storage held inline
+if (bUseCompactAttributes)
+{
+Usage.InlineBytes[FCharacterMemoryUsage::Attribute] = sizeof(FCompactCharacterAttribute);
+Usage.InlineBytes[FCharacterMemoryUsage::Manager] -= sizeof(FCompactCharacterAttribute);
+}
+
+SIZE_T ManagerHeapBytes = 0;
+
+if (OwnedData)
+{
+// The information delegates are not reflected
+Usage.HeapBytes[FCharacterMemoryUsage::Information] += OwnedData->GetInformationData().OnTitleChanged.GetAllocatedSize();
+Usage.HeapBytes[FCharacterMemoryUsage::Information] += OwnedData->GetInformationData().OnDescriptionChanged.GetAllocatedSize();
+
+// State, type and padding of the out-of-line character data
+ManagerHeapBytes += sizeof(FCharacterData) - SectionBytes;
+}
+
+// Blueprint delegates and other reflected members declared by the manager
+for (TFieldIterator<FProperty> It(UCharacterManager::StaticClass(), EFieldIteratorFlags::ExcludeSuper); It; ++It)
+{
+if (It->GetFName() != GET_MEMBER_NAME_CHECKED(UCharacterManager, CharacterDataStorage))
+{
+ManagerHeapBytes += GetPropertyHeapSize(*It, this);
+}
+}
+
+ManagerHeapBytes += StateChangedEvents.GetAllocatedSize();
+ManagerHeapBytes += TypeChangedEvents.GetAllocatedSize();
+ManagerHeapBytes += TitleChangedEvents.GetAllocatedSize();
+ManagerHeapBytes += DescriptionChangedEvents.GetAllocatedSize();
+ManagerHeapBytes += AttributeChangedEvents.GetAllocatedSize();
+ManagerHeapBytes += RollbackHistory.GetAllocatedSize();
+ManagerHeapBytes += ThresholdSubscriptions.GetAllocatedSize();
+
+for (const FThresholdSubscription& Subscription : ThresholdSubscriptions)
+{
+ManagerHeapBytes += Subscription.Boundaries.GetAllocatedSize();
+}
+
+Usage.HeapBytes[FCharacterMemoryUsage::Manager] = ManagerHeapBytes;
+return Usage;
+}
+
+void UCharacterManager::DumpMemoryReport(const UWorld* World, FOutputDevice& Output, SIZE_T BudgetBytes, const TMap<FString, SIZE_T>& ArchetypeBudgets)
+{
+const TArray<UCharacterManager*>& RegisteredManagers = GetRegisteredManagers(World);
+
+struct FArchetypeUsage
+{
+FString Name;
+SIZE_T BudgetBytes = 0;
+int32 NumCharacters = 0;
+FCharacterMemoryUsage Usage;
+};
+
+// Characters without an archetype are grouped under a null key
+TMap<FCharacterData*, FArchetypeUsage> Archetypes;
+FCharacterMemoryUsage Total;
+
+for (const UCharacterManager* Manager : RegisteredManagers)
+{
+FCharacterData* Key = Manager->Archetype.Get();
+FCharacterMemoryUsage Usage = Manager->GetMemoryUsage();
+FArchetypeUsage* Entry = Archetypes.Find(Key);
+
+if (!Entry)
+{
+Entry = &Archetypes.Add(Key);
+Entry->Name = Key ? FString::Printf(TEXT("%s (%s)"), *Key->GetInformationData().GetTitle(), *UEnum::GetDisplayValueAsText(Key->GetCharacterType()).ToString()) : FString(TEXT("No archetype"));
+
+const SIZE_T* ArchetypeBudget = Key ? ArchetypeBudgets.Find(Key->GetInformationData().GetTitle()) : nullptr;
+Entry->BudgetBytes = ArchetypeBudget ? *ArchetypeBudget : BudgetBytes;
+
+// Shared sections are paid once per archetype, not per character
+Entry->Usage.SharedHeapBytes = Usage.SharedHeapBytes;
+Total.SharedHeapBytes += Usage.SharedHeapBytes;
+}
+
+Usage.SharedHeapBytes = 0;
+
+Entry->Usage += Usage;
+Total += Usage;
+++Entry->NumCharacters;
+}
+
+const auto WriteUsage = [&Output](const TCHAR* Label, int32 NumCharacters, const FCharacterMemoryUsage& Usage)
+{
+const SIZE_T TotalBytes = Usage.GetOwnedBytes() + Usage.SharedHeapBytes;
+
+Output.Logf(TEXT("%s: %d characters | %.1f KB total | %.1f bytes per character | %.1f KB shared"),
+Label, NumCharacters, TotalBytes / 1024.0, NumCharacters > 0 ? static_cast<double>(TotalBytes) / NumCharacters : 0.0, Usage.SharedHeapBytes / 1024.0);
+
+for (int32 Section = 0; Section < FCharacterMemoryUsage::NumSections; ++Section)
+{
+Output.Logf(TEXT("  %-12s %10.1f inline %10.1f heap bytes per character"),
+FCharacterMemoryUsage::GetSectionName(Section),
+NumCharacters > 0 ? static_cast<double>(Usage.InlineBytes[Section]) / NumCharacters : 0.0,
+NumCharacters > 0 ? static_cast<double>(Usage.HeapBytes[Section]) / NumCharacters : 0.0);
+}
+};
+
+for (const TPair<FCharacterData*, FArchetypeUsage>& Pair : Archetypes)
+{
+const FArchetypeUsage& Entry = Pair.Value;
+WriteUsage(*Entry.Name, Entry.NumCharacters, Entry.Usage);
+
+const SIZE_T BytesPerCharacter = (Entry.Usage.GetOwnedBytes() + Entry.Usage.SharedHeapBytes) / FMath::Max(Entry.NumCharacters, 1);
+
+if (Entry.BudgetBytes > 0 && BytesPerCharacter > Entry.BudgetBytes)
+{
+Output.Logf(ELogVerbosity::Warning, TEXT("%s: %llu bytes per character exceeds the budget of %llu bytes."),
+*Entry.Name, static_cast<uint64>(BytesPerCharacter), static_cast<uint64>(Entry.BudgetBytes));
+}
+}
+
+WriteUsage(TEXT("Total"), RegisteredManagers.Num(), Total);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CharacterMemoryReportCommand(
+TEXT("CharacterManager.MemoryReport"),
+TEXT("Reports inline and heap memory per section for the characters of the current world, grouped by archetype. ")
+TEXT("Usage: CharacterManager.MemoryReport [BudgetBytes] [Title=Bytes ...], the budgets default to CharacterManager.MemoryBudget ")
+TEXT("and CharacterManager.MemoryArchetypeBudgets"),
+FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Output)
+{
+int32 BudgetBytes = CVarCharacterMemoryBudget.GetValueOnGameThread();
+TMap<FString, SIZE_T> ArchetypeBudgets;
+
+TArray<FString> ConfiguredBudgets;
+CVarCharacterMemoryArchetypeBudgets.GetValueOnGameThread().ParseIntoArrayWS(ConfiguredBudgets);
+ParseCharacterArchetypeBudgets(ConfiguredBudgets, ArchetypeBudgets);
+
+// Arguments override the console variables
+ParseCharacterArchetypeBudgets(Args, ArchetypeBudgets);
+
+if (Args.Num() > 0 && Args[0].IsNumeric())
+{
+BudgetBytes = FCString::Atoi(*Args[0]);
+}
+
+UCharacterManager::DumpMemoryReport(World, Output, static_cast<SIZE_T>(FMath::Max(BudgetBytes, 0)), ArchetypeBudgets);
+})
+);
+
+#pragma endregion
+
+#pragma region Pooling
+
+void UCharacterManager::ResetForPool()
+{
+SetComponentTickEnabled(false);
+
+// Deltas of the previous life are never sent
+RemoveFromReplicationQueue();
+
+ReplicationDirtyMask = CharacterDirtyFlags::None;
+RollbackHistory.Reset();
+
+// The version keeps counting so widgets of the next owner never see a stale match
+bPublishHudSnapshot = false;
+
+// Deltas still in flight belong to the previous life as well
+bUseAtomicAttributes = false;
+AtomicDirtyMask.store(0, std::memory_order_relaxed);
+bAtomicDeathPending.store(false, std::memory_order_relaxed);
+
+// A regeneration of the previous life must not keep healing its old target
+StopPrimaryAttributeRegeneration();
+RegenTarget = nullptr;
+RegenType = EPrimaryAttributeType::Null;
+RemainingRegenAmount = 0.f;
+
+// Listeners of the previous owner, only the manager's own handlers from SetupDelegates stay
+StateChangedEvents.UnsubscribeAllExcept(this);
+TypeChangedEvents.UnsubscribeAllExcept(this);
+TitleChangedEvents.UnsubscribeAllExcept(this);
+DescriptionChangedEvents.UnsubscribeAllExcept(this);
+AttributeChangedEvents.UnsubscribeAllExcept(this);
+RemoveThresholdSubscriptions([](const FThresholdSubscription& Subscription) { return true; });
+
+// The identity is journaled again under the next owner's name
+JournalSession = 0;
+
+// The character data, archetype and compact attributes stay readable until Reinitialize replaces them.
+// The storage is kept for the next life, whether it respawns from an archetype or from the class defaults.
+OwnerCharacter = nullptr;
+MovementParametersOwner.Reset();
+}
+
+void UCharacterManager::Reinitialize(ACharacterModule* NewOwner, const FCharacterArchetypePtr& InArchetype)
+{
+OwnerCharacter = NewOwner;
+bMovementParametersDirty = true;
+
+if (InArchetype.IsValid())
+{
+SpawnFromArchetype(InArchetype);
+}
+else
+{
+const UCharacterManager* Defaults = GetClass()->GetDefaultObject<UCharacterManager>();
+
+// Copy-assignment keeps the string and array capacity of the previous life
+AllocateCharacterData() = Defaults->CharacterDataStorage.Get();
+bUseCompactAttributes = Defaults->bUseCompactAttributes;
+
+// Re-enables compact attributes over the restored data
+DetachArchetype();
+MarkFullReplicationDirty();
+}
+
+SetComponentTickEnabled(true);
+BroadcastStateChanged(GetStoredCharacterState());
+PublishState();
+}
+
+#pragma endregion
+
+#pragma region CharacterState
+
+void UCharacterManager::SetCharacterState(ECharacterState NewState)
+{
+JournalMutation(ECharacterJournalEvent::StateChange, static_cast<uint8>(NewState), static_cast<float>(GetStoredCharacterState()));
+
+SetStoredCharacterState(NewState);
+MarkReplicationDirty(CharacterDirtyFlags::State);
+BroadcastStateChanged(NewState);
+}
+
+ECharacterState UCharacterManager::GetCharacterState()
+{
+return GetStoredCharacterState();
+}
+
+void UCharacterManager::HandleOnDeathState()
+{
+check(OwnerCharacter);
+
+bool AI = GetStoredCharacterType() == ECharacterType::AI;
+bool Player = GetStoredCharacterType() == ECharacterType::Player;
+
+if (Player)
+{
+OwnerCharacter->PlayerHandleOnDeathState();
+}
+else if (AI)
+{
+OwnerCharacter->AIHandleOnDeathState();
+}
+else
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("HandleOnDeathState: Character Type is not valid."));
+#endif
+}
+}
+
+#pragma endregion
+
+#pragma region CharacterType
+
+ECharacterType UCharacterManager::GetCharacterType()
+{
+
+return GetStoredCharacterType();
+}
+
+void UCharacterManager::SetCharacterType(ECharacterType NewType)
+{
+SetStoredCharacterType(NewType);
+MarkReplicationDirty(CharacterDirtyFlags::Type);
+BroadcastTypeChanged(NewType);
+}
+
+bool UCharacterManager::IsPlayerCharacter()
+{
+return GetStoredCharacterType() == ECharacterType::Player;
+}
+
+bool UCharacterManager::IsAICharacter()
+{
+return GetStoredCharacterType() == ECharacterType::AI;
+}
+
+#pragma endregion
+
+#pragma region Information
+
+FString UCharacterManager::GetTitle()
+{
+return ReadCharacterData(ECharacterDataSection::Information).GetInformationData().GetTitle();
+}
+
+FString UCharacterManager::GetDescription()
+{
+return ReadCharacterData(ECharacterDataSection::Information).GetInformationData().GetDescription();
+}
+
+void UCharacterManager::SetTitle(const FString& NewTitle)
+{
+WriteCharacterData(ECharacterDataSection::Information).GetInformationData().SetTitle(NewTitle);
+MarkReplicationDirty(CharacterDirtyFlags::Title);
+BroadcastTitleChanged(NewTitle);
+}
+
+void UCharacterManager::SetDescription(const FString& NewDescription)
+{
+WriteCharacterData(ECharacterDataSection::Information).GetInformationData().SetDescription(NewDescription);
+MarkReplicationDirty(CharacterDirtyFlags::Description);
+BroadcastDescriptionChanged(NewDescription);
+}
+
+#pragma endregion
+
+#pragma region Attribute
+
+float UCharacterManager::GetCurrentAttributeValueByType(ECharacterAttributeType AttributeType)
+{
+if (bUseAtomicAttributes && AttributeType >= ECharacterAttributeType::Health && AttributeType <= ECharacterAttributeType::Shield)
+{
+return AtomicAttributes[static_cast<uint8>(AttributeType) - 1].CurrentValue.load(std::memory_order_relaxed);
+}
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetCurrentValue(AttributeType);
+}
+switch (AttributeType)
+{
+case ECharacterAttributeType::Health:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Energy:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Shield:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Stamina:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue();
+case ECharacterAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetCurrentAttributeValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetMinimumAttributeValueByType(ECharacterAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMinimumValue(AttributeType);
+}
+switch (AttributeType)
+{
+case ECharacterAttributeType::Health:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Energy:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Shield:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Stamina:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetMinimumValue();
+case ECharacterAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetMinimumAttributeValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetMaximumAttributeValueByType(ECharacterAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMaximumValue(AttributeType);
+}
+switch (AttributeType)
+{
+case ECharacterAttributeType::Health:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Energy:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Shield:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Stamina:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetMaximumValue();
+case ECharacterAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetMaximumAttributeByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+default:
+return 0.0f;
+}
+}
+
+FAttributeModule UCharacterManager::GetPrimaryAttributeModuleByType(EPrimaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.ToAttributeModule(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule();
+case EPrimaryAttributeType::Energy:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule();
+case EPrimaryAttributeType::Shield:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule();
+case EPrimaryAttributeType::Stamina:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule();
+case EPrimaryAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetPrimaryAttributeModuleByType: Selected AttributeType is Null."));
+#endif
+return FAttributeModule();
+default:
+return FAttributeModule();
+}
+}
+
+float UCharacterManager::GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType AttributeType)
+{
+if (bUseAtomicAttributes && AttributeType != EPrimaryAttributeType::Null && AttributeType != EPrimaryAttributeType::Max)
+{
+return AtomicAttributes[static_cast<uint8>(AttributeType) - 1].CurrentValue.load(std::memory_order_relaxed);
+}
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetCurrentValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+{
+const auto& Health = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule();
+return Health.GetCurrentValue();
+}
+case EPrimaryAttributeType::Energy:
+{
+const auto& Energy = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule();
+return Energy.GetCurrentValue();
+}
+
+case EPrimaryAttributeType::Shield:
+{
+const auto& Shield = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule();
+return Shield.GetCurrentValue();
+}
+
+case EPrimaryAttributeType::Stamina:
+{
+const auto& Stamina = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule();
+return Stamina.GetCurrentValue();
+}
+
+case EPrimaryAttributeType::Null:
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetPrimaryAttributeCurrentValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+}
+
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMinimumValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+{
+const auto& Health = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule();
+return Health.GetMinimumValue();
+}
+
+case EPrimaryAttributeType::Energy:
+{
+const auto& Energy = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule();
+return Energy.GetMinimumValue();
+}
+
+case EPrimaryAttributeType::Shield:
+{
+const auto& Shield = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule();
+return Shield.GetMinimumValue();
+}
+
+case EPrimaryAttributeType::Stamina:
+{
+const auto& Stamina = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule();
+return Stamina.GetMinimumValue();
+}
+
+case EPrimaryAttributeType::Null:
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetPrimaryAttributeMinimumValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+}
+
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMaximumValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+{
+const auto& Health = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule();
+return Health.GetMaximumValue();
+}
+
+case EPrimaryAttributeType::Energy:
+{
+const auto& Energy = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule();
+return Energy.GetMaximumValue();
+}
+
+case EPrimaryAttributeType::Shield:
+{
+const auto& Shield = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule();
+return Shield.GetMaximumValue();
+}
+
+case EPrimaryAttributeType::Stamina:
+{
+const auto& Stamina = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule();
+return Stamina.GetMaximumValue();
+}
+
+case EPrimaryAttributeType::Null:
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetPrimaryAttributeMaximumValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+}
+
+default:
+return 0.0f;
+}
+}
+
+FAttributeModule UCharacterManager::GetSecondaryAttributeModuleByType(ESecondaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.ToAttributeModule(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule();
+case ESecondaryAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule();
+case ESecondaryAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule();
+case ESecondaryAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule();
+case ESecondaryAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule();
+case ESecondaryAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetSecondaryAttributeModuleByType: Selected AttributeType is Null."));
+#endif
+return FAttributeModule();
+default:
+return FAttributeModule();
+}
+}
+
+float UCharacterManager::GetSecondaryAttributeCurrentValueByType(ESecondaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetCurrentValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetCurrentValue();
+case ESecondaryAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetCurrentValue();
+case ESecondaryAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue();
+case ESecondaryAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetCurrentValue();
+case ESecondaryAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue();
+case ESecondaryAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetSecondaryAttributeCurrentValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetSecondaryAttributeMinimumValueByType(ESecondaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMinimumValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetMinimumValue();
+case ESecondaryAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetMinimumValue();
+case ESecondaryAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetMinimumValue();
+case ESecondaryAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetMinimumValue();
+case ESecondaryAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetMinimumValue();
+case ESecondaryAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetSecondaryAttributeMinimumValueByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetSecondaryAttributeMaximumByType(ESecondaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetMaximumValue(ToCharacterAttributeType(AttributeType));
+}
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetMaximumValue();
+case ESecondaryAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetMaximumValue();
+case ESecondaryAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetMaximumValue();
+case ESecondaryAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetMaximumValue();
+case ESecondaryAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetMaximumValue();
+case ESecondaryAttributeType::Null:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("GetSecondaryAttributeMaximumByType: Selected AttributeType is Null."));
+#endif
+return 0.0f;
+default:
+return 0.0f;
+}
+}
+
+float UCharacterManager::GetMaximumAttributeByType(ECharacterAttributeType AttributeType)
+{
+return GetMaximumAttributeValueByType(AttributeType);
+}
+
+void UCharacterManager::SetPrimaryAttributeValueByType(EPrimaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+CHARACTER_MANAGER_SCOPE(SetAttribute);
+CHARACTER_MANAGER_COUNT(AttributeWrites);
+
+MarkAttributeReplicationDirty(ToCharacterAttributeType(AttributeType), MinValue, MaxValue, CurrentValue);
+
+if (bUseAtomicAttributes)
+{
+StoreAtomicAttribute(AttributeType, MinValue, MaxValue, CurrentValue);
+}
+
+if (bUseCompactAttributes)
+{
+WriteCompactAttributeValue(ToCharacterAttributeType(AttributeType), MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ToCharacterAttributeType(AttributeType));
+BroadcastAttributeChanged(ToCharacterAttributeType(AttributeType));
+
+if (AttributeType == EPrimaryAttributeType::Health && GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health) <= 0.0f)
+{
+SetCharacterState(ECharacterState::Death);
+}
+
+return;
+}
+
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+{
+auto& Health = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule();
+Health.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Health);
+BroadcastAttributeChanged(ECharacterAttributeType::Health, Health.GetMinimumValue(), Health.GetMaximumValue(), Health.GetCurrentValue());
+
+if(Health.GetCurrentValue() <= 0.0f)
+{
+SetCharacterState(ECharacterState::Death);
+}	
+
+break;
+}
+case EPrimaryAttributeType::Energy:
+{
+auto& Energy = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule();
+Energy.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Energy);
+BroadcastAttributeChanged(ECharacterAttributeType::Energy, Energy.GetMinimumValue(), Energy.GetMaximumValue(), Energy.GetCurrentValue());
+break;
+}
+case EPrimaryAttributeType::Shield:
+{
+auto& Shield = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule();
+Shield.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Shield);
+BroadcastAttributeChanged(ECharacterAttributeType::Shield, Shield.GetMinimumValue(), Shield.GetMaximumValue(), Shield.GetCurrentValue());
+break;
+}
+case EPrimaryAttributeType::Stamina:
+{
+auto& Stamina = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule();
+Stamina.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Stamina);
+BroadcastAttributeChanged(ECharacterAttributeType::Stamina, Stamina.GetMinimumValue(), Stamina.GetMaximumValue(), Stamina.GetCurrentValue());
+break;
+}
+default:
+break;
+}
+}
+
+void UCharacterManager::SetSecondaryAttributeValueByType(ESecondaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+CHARACTER_MANAGER_SCOPE(SetAttribute);
+CHARACTER_MANAGER_COUNT(AttributeWrites);
+
+MarkAttributeReplicationDirty(ToCharacterAttributeType(AttributeType), MinValue, MaxValue, CurrentValue);
+
+if (bUseCompactAttributes)
+{
+WriteCompactAttributeValue(ToCharacterAttributeType(AttributeType), MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ToCharacterAttributeType(AttributeType));
+BroadcastAttributeChanged(ToCharacterAttributeType(AttributeType));
+return;
+}
+
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+{
+auto& Output = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule();
+Output.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Output);
+BroadcastAttributeChanged(ECharacterAttributeType::Output, Output.GetMinimumValue(), Output.GetMaximumValue(), Output.GetCurrentValue());
+break;
+}
+
+case ESecondaryAttributeType::Actuation:
+{
+auto& Actuation = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule();
+Actuation.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Actuation);
+BroadcastAttributeChanged(ECharacterAttributeType::Actuation, Actuation.GetMinimumValue(), Actuation.GetMaximumValue(), Actuation.GetCurrentValue());
+break;
+}
+
+case ESecondaryAttributeType::Integrity:
+{
+auto& Integrity = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule();
+Integrity.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Integrity);
+BroadcastAttributeChanged(ECharacterAttributeType::Integrity, Integrity.GetMinimumValue(), Integrity.GetMaximumValue(), Integrity.GetCurrentValue());
+break;
+}
+
+case ESecondaryAttributeType::Capacity:
+{
+auto& Capacity = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule();
+Capacity.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Capacity);
+BroadcastAttributeChanged(ECharacterAttributeType::Capacity, Capacity.GetMinimumValue(), Capacity.GetMaximumValue(), Capacity.GetCurrentValue());
+break;
+}
+
+case ESecondaryAttributeType::Regeneration:
+{
+auto& Regeneration = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule();
+Regeneration.SetValue(MinValue, MaxValue, CurrentValue);
+JournalStoredAttribute(ECharacterAttributeType::Regeneration);
+BroadcastAttributeChanged(ECharacterAttributeType::Regeneration, Regeneration.GetMinimumValue(), Regeneration.GetMaximumValue(), Regeneration.GetCurrentValue());
+break;
+}
+
+case ESecondaryAttributeType::Null:
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("SetSecondaryAttributeCurrentValueByType: Selected AttributeType is Null."));
+#endif
+break;
+}
+}
+}
+
+bool UCharacterManager::HasPrimaryAttributeValue(EPrimaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes && AttributeType != EPrimaryAttributeType::Null)
+{
+return CompactAttributeData.GetCurrentValue(ToCharacterAttributeType(AttributeType)) > 0.0f;
+}
+switch (AttributeType)
+{
+case EPrimaryAttributeType::Health:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetHealthAttributeModule().GetCurrentValue() > 0.0f;
+
+case EPrimaryAttributeType::Energy:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetEnergyAttributeModule().GetCurrentValue() > 0.0f;
+
+case EPrimaryAttributeType::Shield:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetShieldAttributeModule().GetCurrentValue() > 0.0f;
+
+case EPrimaryAttributeType::Stamina:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetStaminaAttributeModule().GetCurrentValue() > 0.0f;
+
+case EPrimaryAttributeType::Null:
+default:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("HasPrimaryAttributeValue: Invalid AttributeType."));
+#endif
+return false;
+}
+}
+
+bool UCharacterManager::HasSecondaryAttributeValue(ESecondaryAttributeType AttributeType)
+{
+if (bUseCompactAttributes && AttributeType != ESecondaryAttributeType::Null)
+{
+return CompactAttributeData.GetCurrentValue(ToCharacterAttributeType(AttributeType)) > 0.0f;
+}
+switch (AttributeType)
+{
+case ESecondaryAttributeType::Output:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetOutputAttributeModule().GetCurrentValue() > 0.0f;
+
+case ESecondaryAttributeType::Actuation:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetActuationAttributeModule().GetCurrentValue() > 0.0f;
+
+case ESecondaryAttributeType::Integrity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue() > 0.0f;
+
+case ESecondaryAttributeType::Capacity:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetCapacityAttributeModule().GetCurrentValue() > 0.0f;
+
+case ESecondaryAttributeType::Regeneration:
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue() > 0.0f;
+
+case ESecondaryAttributeType::Null:
+default:
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("HasSecondaryAttributeValue: Invalid AttributeType."));
+#endif
+return false;
+}
+}
+
+void UCharacterManager::BroadcastAttributeChanged(ECharacterAttributeType AttributeType)
+{
+BroadcastAttributeChanged(AttributeType, GetMinimumAttributeValueByType(AttributeType), GetMaximumAttributeValueByType(AttributeType), GetCurrentAttributeValueByType(AttributeType));
+}
+
+void UCharacterManager::BroadcastAttributeChanged(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+CHARACTER_MANAGER_SCOPE(BroadcastAttribute);
+CHARACTER_MANAGER_COUNT(Broadcasts);
+
+if (ThresholdAttributeMask & (1u << static_cast<uint8>(AttributeType)))
+{
+EvaluateAttributeThresholds(AttributeType, MinValue, MaxValue, CurrentValue);
+}
+
+AttributeChangedEvents.Broadcast({ this, AttributeType, MinValue, MaxValue, CurrentValue });
+
+// Speeds derive from Actuation
+if (AttributeType == ECharacterAttributeType::Actuation && bScaleSpeedByActuation)
+{
+bMovementParametersDirty = true;
+}
+
+if (!bBroadcastBlueprintDelegates)
+{
+return;
+}
+
+switch (AttributeType)
 {
 case ECharacterAttributeType::Health:
-return CharacterData.GetAttributeData().GetHealthAttributeModule().GetCurrentValue();
+OnHealthAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
+case ECharacterAttributeType::Stamina:
+OnStaminaAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Energy:
-return CharacterData.GetAttributeData().GetEnergyAttributeModule().GetCurrentValue();
+OnEnergyAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Shield:
-return CharacterData.GetAttributeData().GetShieldAttributeModule().GetCurrentValue();
-case ECharacterAttributeType::Stamina:
-return CharacterData.GetAttributeData().GetStaminaAttributeModule().GetCurrentValue();
+OnShieldAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetCurrentValue();
+OnOutputAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetCurrentValue();
+OnActuationAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue();
+OnIntegrityAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetCurrentValue();
+OnCapacityAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
 case ECharacterAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue();
-case ECharacterAttributeType::Null:
+OnRegenerationAttributeChanged.Broadcast(MinValue, MaxValue, CurrentValue);
+break;
+default:
+break;
+}
+}
+
+void UCharacterManager::UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType AttributeType, float DeltaValue, float Amount)
+{
+if (AttributeType != EPrimaryAttributeType::Null && AttributeType != EPrimaryAttributeType::Max)
+{
+const float MinValue = GetPrimaryAttributeMinimumValueByType(AttributeType);
+const float MaxValue = GetPrimaryAttributeMaximumValueByType(AttributeType);
+const float CurrentValue = GetPrimaryAttributeCurrentValueByType(AttributeType);
+
+// No need to update if the attribute is already at maximum
+if (CurrentValue >= MaxValue)
+{
+return;
+}
+
+const float NewValue = CharacterSimulation::RegenerateAttribute(MakeSimulationAttribute(MinValue, MaxValue, CurrentValue, Amount), DeltaValue);
+SetPrimaryAttributeValueByType(AttributeType, MinValue, MaxValue, NewValue);
+}
+
+CHARACTER_DEBUG_LOG(GetUniqueID(), "AttributeUpdate", TEXT("Updated %s Attribute: %f"), *UEnum::GetValueAsString(AttributeType), DeltaValue * Amount);
+}
+
+void UCharacterManager::UpdatePrimaryAttributes(float DeltaTime)
+{
+CHARACTER_MANAGER_SCOPE(UpdatePrimaryAttributes);
+
+// Attribute Data Reference
+const FCharacterAttribute& AttributeData = ReadAttributeData();
+const FAttributeModule& HealthModule	= *AttributeData.FindAttributeModuleByType(ECharacterAttributeType::Health);
+const FAttributeModule& EnergyModule	= *AttributeData.FindAttributeModuleByType(ECharacterAttributeType::Energy);
+const FAttributeModule& ShieldModule	= *AttributeData.FindAttributeModuleByType(ECharacterAttributeType::Shield);
+const FAttributeModule& StaminaModule	= *AttributeData.FindAttributeModuleByType(ECharacterAttributeType::Stamina);
+
+// Regenerate Health
+if (IsAttributeUpdateEnabled(ECharacterAttributeType::Health))
+{
+UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health,DeltaTime, HealthModule.GetRegenerateValue());
+}
+
+// Regenerate Energy
+if (IsAttributeUpdateEnabled(ECharacterAttributeType::Energy))
+{
+UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Energy, DeltaTime, EnergyModule.GetRegenerateValue());
+}
+
+// Regenerate Shield
+if (IsAttributeUpdateEnabled(ECharacterAttributeType::Shield))
+{
+UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Shield, DeltaTime, ShieldModule.GetRegenerateValue());
+}
+
+// Regenerate Stamina
+if (IsAttributeUpdateEnabled(ECharacterAttributeType::Stamina))
+{
+UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Stamina, DeltaTime, StaminaModule.GetRegenerateValue());
+}
+
+UpdateAbilityCooldowns(DeltaTime);
+}
+
+bool UCharacterManager::IsAnyAbilityOnCooldown() const
+{
+const FCharacterAbilityData& SharedAbilities = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData();
+
+return SharedAbilities.FindCharacterAbilityByTypePtr(ECharacterAbilityType::CombatStrike)->IsAbilityOnCooldown() ||
+SharedAbilities.FindCharacterAbilityByTypePtr(ECharacterAbilityType::LaserPulse)->IsAbilityOnCooldown() ||
+SharedAbilities.FindCharacterAbilityByTypePtr(ECharacterAbilityType::PlasmaShield)->IsAbilityOnCooldown();
+}
+
+void UCharacterManager::UpdateAbilityCooldowns(float DeltaTime)
+{
+// Idle characters keep sharing the archetype's abilities
+if (!IsAnyAbilityOnCooldown())
+{
+return;
+}
+
+FCharacterAbilityData& Abilities = WriteCharacterData(ECharacterDataSection::Ability).GetAbilityData();
+
+for (const ECharacterAbilityType AbilityType : { ECharacterAbilityType::CombatStrike, ECharacterAbilityType::LaserPulse, ECharacterAbilityType::PlasmaShield })
+{
+const_cast<FCharacterAbilityModule*>(Abilities.FindCharacterAbilityByTypePtr(AbilityType))->CooldownTimerUpdate(DeltaTime);
+}
+}
+
+// Compact storage only reads ranges and rates from the attributes it shares
+static bool HasSameRangesAndRates(const FCharacterAttribute& A, const FCharacterAttribute& B)
+{
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+const FAttributeModule& ModuleA = *A.FindAttributeModuleByType(AttributeType);
+const FAttributeModule& ModuleB = *B.FindAttributeModuleByType(AttributeType);
+
+if (ModuleA.GetMinimumValue() != ModuleB.GetMinimumValue() || ModuleA.GetMaximumValue() != ModuleB.GetMaximumValue() ||
+ModuleA.GetRegenerateValue() != ModuleB.GetRegenerateValue() || ModuleA.GetDepleteValue() != ModuleB.GetDepleteValue())
+{
+return false;
+}
+}
+
+return true;
+}
+
+void UCharacterManager::EnableCompactAttributes()
+{
+const FCharacterAttribute& OwnAttributes = AllocateCharacterData().GetAttributeData();
+EnableCompactAttributes(OwnAttributes);
+
+// Characters that still have the default ranges and rates read them from the class defaults,
+// which outlive every instance. The first range change copies them back, see WriteCompactAttributeValue.
+const UCharacterManager* Defaults = GetClass()->GetDefaultObject<UCharacterManager>();
+
+if (Defaults != this && Defaults->CharacterDataStorage.IsValid() && HasSameRangesAndRates(OwnAttributes, Defaults->CharacterDataStorage.Get().GetAttributeData()))
+{
+CompactAttributeData.SetArchetype(Defaults->CharacterDataStorage.Get().GetAttributeData());
+}
+}
+
+void UCharacterManager::EnableCompactAttributes(const FCharacterAttribute& InArchetype)
+{
+CompactAttributeData.Initialize(InArchetype);
+bUseCompactAttributes = true;
+}
+
+void UCharacterManager::DisableCompactAttributes()
+{
+if (!bUseCompactAttributes)
+{
+return;
+}
+
+WriteCharacterData(ECharacterDataSection::Attribute);
+SyncCompactAttributesToCharacterData();
+bUseCompactAttributes = false;
+CompactAttributeData = FCompactCharacterAttribute();
+}
+
+bool UCharacterManager::IsAttributeUpdateEnabled(ECharacterAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.IsUpdateEnabled(AttributeType);
+}
+
+const FAttributeModule* Module = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().FindAttributeModuleByType(AttributeType);
+return Module && Module->IsUpdateEnabled();
+}
+
+const FCharacterAttribute& UCharacterManager::ReadAttributeData() const
+{
+// Rates are shared with the archetype or the class defaults in compact mode
+if (bUseCompactAttributes && CompactAttributeData.IsValid())
+{
+return *CompactAttributeData.GetArchetype();
+}
+
+return ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData();
+}
+
+void UCharacterManager::WriteCompactAttributeValue(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+// Ranges live in the shared attributes. Changing one copies them into our own data first,
+// current values only go to the compact storage and are expanded on demand.
+const bool bRangeChanged = MinValue != CompactAttributeData.GetMinimumValue(AttributeType) || MaxValue != CompactAttributeData.GetMaximumValue(AttributeType);
+
+if (bRangeChanged)
+{
+FCharacterAttribute& OwnAttributes = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData();
+
+if (CompactAttributeData.GetArchetype() != &OwnAttributes)
+{
+OwnAttributes = *CompactAttributeData.GetArchetype();
+CompactAttributeData.SetArchetype(OwnAttributes);
+}
+
+OwnAttributes.FindAttributeModuleByType(AttributeType)->SetValue(MinValue, MaxValue, CurrentValue);
+}
+
+CompactAttributeData.SetCurrentValue(AttributeType, CurrentValue);
+}
+
+void UCharacterManager::SyncCompactAttributesToCharacterData()
+{
+if (!bUseCompactAttributes)
+{
+return;
+}
+
+FCharacterAttribute& OwnAttributes = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData();
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+*OwnAttributes.FindAttributeModuleByType(AttributeType) = CompactAttributeData.ToAttributeModule(AttributeType);
+}
+}
+
+void UCharacterManager::SyncCompactAttributesFromCharacterData()
+{
+if (!bUseCompactAttributes)
+{
+return;
+}
+
+// The written data may carry new ranges, so the shared attributes are picked again
+EnableCompactAttributes();
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterCompactAttributeBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkCompactAttributes"),
+TEXT("Compares per-instance memory and regeneration cost of full and compact attribute storage. Usage: CharacterManager.BenchmarkCompactAttributes [Count] [Frames]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 Count = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+const int32 Frames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 60;
+
+UE_LOG(LogTemp, Log, TEXT("FCharacterAttribute: %d bytes | FCompactCharacterAttribute: %d bytes"),
+static_cast<int32>(sizeof(FCharacterAttribute)),
+static_cast<int32>(sizeof(FCompactCharacterAttribute)));
+
+// Own compact attributes still keep the full attributes in the character data, archetype spawns do not
+FCharacterArchetypePtr Prototype = MakeShared<FCharacterData, ESPMode::ThreadSafe>();
+const TCHAR* const ModeNames[] = { TEXT("Full"), TEXT("Compact"), TEXT("Compact archetype") };
+
+for (int32 Mode = 0; Mode < UE_ARRAY_COUNT(ModeNames); ++Mode)
+{
+TArray<UCharacterManager*> Managers;
+Managers.Reserve(Count);
+
+for (int32 Index = 0; Index < Count; ++Index)
+{
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
+
+if (Mode == 1)
+{
+Manager->EnableCompactAttributes();
+}
+else if (Mode == 2)
+{
+Manager->SpawnFromArchetype(Prototype);
+}
+
+// Below maximum so every frame regenerates
+for (const EPrimaryAttributeType AttributeType : { EPrimaryAttributeType::Health, EPrimaryAttributeType::Energy, EPrimaryAttributeType::Shield, EPrimaryAttributeType::Stamina })
+{
+Manager->SetPrimaryAttributeValueByType(AttributeType, Manager->GetPrimaryAttributeMinimumValueByType(AttributeType), Manager->GetPrimaryAttributeMaximumValueByType(AttributeType), Manager->GetPrimaryAttributeMinimumValueByType(AttributeType));
+}
+
+Managers.Add(Manager);
+}
+
+const double StartTime = FPlatformTime::Seconds();
+
+for (int32 Frame = 0; Frame < Frames; ++Frame)
+{
+for (UCharacterManager* Manager : Managers)
+{
+Manager->UpdatePrimaryAttributes(1.f / 60.f);
+}
+}
+
+const double UpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+FCharacterMemoryUsage Total;
+
+for (UCharacterManager* Manager : Managers)
+{
+Total += Manager->GetMemoryUsage();
+Manager->MarkAsGarbage();
+}
+
+UE_LOG(LogTemp, Log, TEXT("%s: %.1f inline + %.1f heap bytes per instance, %.1f own attribute bytes | Regenerate: %.3f us per instance per frame"),
+ModeNames[Mode],
+static_cast<double>(Total.GetInlineBytes()) / Count,
+static_cast<double>(Total.GetHeapBytes()) / Count,
+static_cast<double>(Total.InlineBytes[FCharacterMemoryUsage::Attribute] + Total.HeapBytes[FCharacterMemoryUsage::Attribute]) / Count,
+UpdateSeconds * 1000000.0 / (static_cast<double>(Count) * Frames));
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Ability
+
+FCharacterAbilityModule UCharacterManager::GetCharacterAbilityModuleByType(ECharacterAbilityType AbilityType)
+{
+return ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByType(AbilityType);
+}
+
+FString UCharacterManager::GetCharacterAbilityTitleByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetTitle();
+}
+
+FString UCharacterManager::GetCharacterAbilityDescriptionByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+return AbilityModule.GetDescription();
+}
+
+ECharacterAbilityType UCharacterManager::GetAbilityTypeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+return AbilityModule.GetAbilityType();
+}
+
+FVector2D UCharacterManager::GetAbilityPowerRangeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+return AbilityModule.GetPowerRange();
+}
+
+FVector2D UCharacterManager::GetAbilityDurationRangeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+return AbilityModule.GetDurationRange();
+}
+
+FVector2D UCharacterManager::GetAbilityCooldownTimeRangeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetCooldownTimeRange();
+}
+
+EAbilityCostType UCharacterManager::GetAbilityCostTypeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetCostType();
+}
+
+FVector2D UCharacterManager::GetAbilityCostRangeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetCostRange();
+}
+
+float UCharacterManager::GetAbilityRangeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRange();
+}
+
+float UCharacterManager::GetAbilityAreaRadiusByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRadius();
+}
+
+float UCharacterManager::GetAbilityRandomPowerByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRandomPower();
+}
+
+float UCharacterManager::GetAbilityRandomDurationByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRandomDuration();
+}
+
+float UCharacterManager::GetAbilityRandomCooldownTimeByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRandomCooldownTime();
+}
+
+float UCharacterManager::GetAbilityRandomCostByType(ECharacterAbilityType AbilityType)
+{
+const FCharacterAbilityModule& AbilityModule = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData().FindCharacterAbilityByTypeRef(AbilityType);
+
+return AbilityModule.GetRandomCost();
+}
+
+void UCharacterManager::SetCharacterAbilityTitleByType(ECharacterAbilityType AbilityType, const FString& NewTitle)
+{
+
+}
+
+void UCharacterManager::SetCharacterAbilityDescriptionByType(ECharacterAbilityType AbilityType, const FString& NewDescription)
+{
+
+}
+
+void UCharacterManager::SetAbilityPowerRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewPowerRange)
+{
+
+}
+
+void UCharacterManager::SetAbilityDurationRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewDurationRange)
+{
+
+}
+
+void UCharacterManager::SetAbilityCooldownTimeRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewCooldownTimeRange)
+{
+
+}
+
+void UCharacterManager::SetAbilityCostRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewCostRange)
+{
+
+}
+
+void UCharacterManager::SetAbilityRangeByType(ECharacterAbilityType AbilityType, float NewRange)
+{
+
+}
+
+void UCharacterManager::SetAbilityAreaRadiusByType(ECharacterAbilityType AbilityType, float NewRadius)
+{
+
+}
+
+void UCharacterManager::SetCharacterAbilityModuleByType(ECharacterAbilityType AbilityType, const FCharacterAbilityModule& NewAbilityModule)
+{
+
+}
+
+#pragma endregion
+
+#pragma region Protection
+
+EProtectionType UCharacterManager::GetProtectionTypeByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetProtectionTypeByType(Type);
+}
+
+FString UCharacterManager::GetTitleByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetTitleByType(Type);
+}
+
+FString UCharacterManager::GetDescriptionByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetDescriptionByType(Type);
+}
+
+float UCharacterManager::GetValueByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetValueByType(Type);
+}
+
+float UCharacterManager::GetMultiplierByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetMultiplierByType(Type);
+}
+
+float UCharacterManager::GetAmplifierByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetAmplifierByType(Type);
+}
+
+float UCharacterManager::GetRandomFinalProtectionByType(EProtectionType Type)
+{
+return ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData().GetNetValueByType(Type);
+}
+
+// Protection type with the same name as each damage type, INDEX_NONE without a match. Resolved once.
+// A damage type without a protection of the same name is never resisted, so each one is reported when the table is built.
+static const TArray<int64>& GetProtectionTypesByDamageType()
+{
+static const TArray<int64> ProtectionTypes = []()
+{
+const UEnum* DamageEnum = StaticEnum<EDamageType>();
+const UEnum* ProtectionEnum = StaticEnum<EProtectionType>();
+
+TArray<int64> Result;
+Result.Init(INDEX_NONE, static_cast<int32>(DamageEnum->GetMaxEnumValue()) + 1);
+
+// The last entry is the generated _MAX
+for (int32 Index = 0; Index < DamageEnum->NumEnums() - 1; ++Index)
+{
+const int64 DamageValue = DamageEnum->GetValueByIndex(Index);
+
+if (DamageValue != static_cast<int64>(EDamageType::Null) && Result.IsValidIndex(static_cast<int32>(DamageValue)))
+{
+Result[static_cast<int32>(DamageValue)] = ProtectionEnum->GetValueByNameString(DamageEnum->GetNameStringByIndex(Index));
+
+#if !UE_BUILD_SHIPPING
+if (Result[static_cast<int32>(DamageValue)] == INDEX_NONE)
+{
+UE_LOG(LogTemp, Warning, TEXT("GetProtectionTypesByDamageType: No EProtectionType named %s, this damage type is never resisted."), *DamageEnum->GetNameStringByIndex(Index));
+}
+#endif
+}
+}
+
+return Result;
+}();
+
+return ProtectionTypes;
+}
+
+void UCharacterManager::RebuildResistanceMatrix()
+{
+const TArray<int64>& ProtectionTypes = GetProtectionTypesByDamageType();
+const FProtectionData& ProtectionData = ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData();
+
+for (int32 Index = 0; Index < MaxDamageTypes; ++Index)
+{
+FResistance& Resistance = ResistanceMatrix[Index];
+Resistance = FResistance();
+
+if (!ProtectionTypes.IsValidIndex(Index) || ProtectionTypes[Index] == INDEX_NONE)
+{
+continue;
+}
+
+const EProtectionType ProtectionType = static_cast<EProtectionType>(ProtectionTypes[Index]);
+Resistance.Base = ProtectionData.GetValueByType(ProtectionType) * ProtectionData.GetMultiplierByType(ProtectionType);
+Resistance.Spread = Resistance.Base * ProtectionData.GetAmplifierByType(ProtectionType) - Resistance.Base;
+}
+
+#if WITH_EDITOR
+if (ProtectionTypes.Num() > MaxDamageTypes)
+{
+UE_LOG(LogTemp, Error, TEXT("RebuildResistanceMatrix: EDamageType has more values than MaxDamageTypes, the extra types are not resisted."));
+}
+#endif
+
+bResistanceMatrixDirty = false;
+}
+
+float UCharacterManager::GetRandomProtectionAgainst(EDamageType DamageType)
+{
+if (bResistanceMatrixDirty)
+{
+RebuildResistanceMatrix();
+}
+
+const int32 Index = static_cast<int32>(DamageType);
+
+if (Index >= MaxDamageTypes)
+{
+return 0.f;
+}
+
+const FResistance& Resistance = ResistanceMatrix[Index];
+return FMath::MulAdd(Resistance.Spread, FMath::FRand(), Resistance.Base);
+}
+
+
+#pragma endregion
+
+#pragma region Level 
+
+FCharacterLevelData& UCharacterManager::GetLevelData()
+{
+
+return WriteCharacterData(ECharacterDataSection::Level).GetLevelData();
+}
+
+float UCharacterManager::GetCurrentExperience()
+{
+return ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetExperience();
+}
+
+float UCharacterManager::GetNextLevelExperienceThreshold()
+{
+int32 CurrentLevel = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetLevel();
+const TArray<float>& ExperienceThresholds = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetExperienceThreshold();
+
+return ExperienceThresholds.IsValidIndex(CurrentLevel) ? ExperienceThresholds[CurrentLevel] : 0.f;
+}
+
+int32 UCharacterManager::GetLevel()
+{
+return ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetLevel();
+}
+
+int32 UCharacterManager::GetMaxLevel()
+{
+return ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetMaxLevel();
+}
+
+float UCharacterManager::GetExperienceRewardBonus()
+{
+return ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetExperienceRewardBonus();
+}
+
+void UCharacterManager::AddExperience(float Amount)
+{
+CHARACTER_MANAGER_SCOPE(AddExperience);
+
+if(Amount <= 0.f)
+{
+return;
+}
+
+// Current level and max level
+int32 CurrentLevel = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetLevel();
+const int32 MaxLevel = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetMaxLevel();
+
+// Current experience and experience thresholds
+float CurrentExperience = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetExperience();
+const TArray<float>& ExperienceThresholds = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetExperienceThreshold();
+
+// Validate experience thresholds
+if(!ExperienceThresholds.IsValidIndex(CurrentLevel))
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Error, TEXT("AddExperience: Experience thresholds not properly configured."));
+#endif
+return;
+}
+
+JournalMutation(ECharacterJournalEvent::Experience, 0, Amount);
+
+// Reused so the threshold copy keeps its capacity between calls
+thread_local CharacterSimulation::FLevel Level;
+Level.Experience = CurrentExperience;
+Level.Level = CurrentLevel;
+Level.MaxLevel = MaxLevel;
+Level.ExperienceThreshold.assign(ExperienceThresholds.GetData(), ExperienceThresholds.GetData() + ExperienceThresholds.Num());
+
+// One LevelUp per level gained keeps replication and journaling per level
+const CharacterSimulation::FExperienceResult Result = CharacterSimulation::AddExperience(Level, Amount);
+
+if (!Result.bValid)
+{
+return;
+}
+
+for (int32 Index = 0; Index < Result.LevelsGained; ++Index)
+{
+LevelUp();
+}
+
+// Remaining experience after the thresholds of the gained levels were spent
+WriteCharacterData(ECharacterDataSection::Level).GetLevelData().SetExperience(Result.Experience);
+MarkReplicationDirty(CharacterDirtyFlags::Experience);
+}
+
+void UCharacterManager::LevelUp()
+{
+CHARACTER_MANAGER_SCOPE(LevelUp);
+CHARACTER_MANAGER_COUNT(LevelUps);
+
+// Increment level by 1 if not at max level
+// Get current and max level
+int32 CurrentLevel = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetLevel();
+int32 MaxLevel = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetMaxLevel();
+
+// Level up if not at max level
+if (CurrentLevel < MaxLevel)
+{
+WriteCharacterData(ECharacterDataSection::Level).GetLevelData().SetLevel(CurrentLevel + 1);
+MarkReplicationDirty(CharacterDirtyFlags::Level);
+JournalMutation(ECharacterJournalEvent::LevelUp, 0, static_cast<float>(CurrentLevel + 1));
+}
+else
+{
+#if WITH_EDITOR
+CHARACTER_LOG_ONCE(Warning, TEXT("LevelUp: Character has reached maximum level already."));
+#endif
+}
+}
+
+#pragma endregion
+
+#pragma region Movement 
+
+float UCharacterManager::GetWalkSpeed()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().GetWalkSpeed();
+}
+
+float UCharacterManager::GetDefaultSpeed()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().GetDefaultSpeed();
+}
+
+float UCharacterManager::GetMaximumSpeed()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().GetMaxSpeed();
+}
+
+bool UCharacterManager::IsSprintEnabled()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().IsSprintEnabled();
+}
+
+bool UCharacterManager::IsJumpEnabled()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().IsJumpEnabled();
+}
+
+bool UCharacterManager::IsDoubleJumpEnabled()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().IsDoubleJumpEnabled();
+}
+
+int32 UCharacterManager::GetMaxJumpCount()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().GetMaxJumpCount();
+}
+
+float UCharacterManager::GetJumpHeight()
+{
+return ReadCharacterData(ECharacterDataSection::Movement).GetMovementData().GetJumpHeight();
+}
+
+void UCharacterManager::PushMovementParameters()
+{
+bMovementParametersDirty = false;
+
+const FCharacterMovementData& MovementData = ReadCharacterData(ECharacterDataSection::Movement).GetMovementData();
+float SpeedScale = 1.f;
+
+if (bScaleSpeedByActuation)
+{
+// Relative to the starting Actuation, so an unmodified character moves at its authored speeds
+const FCharacterData& Defaults = Archetype.IsValid() ? *Archetype : GetClass()->GetDefaultObject<UCharacterManager>()->CharacterDataStorage.Get();
+const float DefaultActuation = Defaults.GetAttributeData().FindAttributeModuleByType(ECharacterAttributeType::Actuation)->GetCurrentValue();
+SpeedScale = DefaultActuation > 0.f ? FMath::Clamp(GetCurrentAttributeValueByType(ECharacterAttributeType::Actuation) / DefaultActuation, 0.f, 1.f) : 1.f;
+}
+
+FCharacterMovementParameters Next;
+Next.WalkSpeed = MovementData.GetWalkSpeed() * SpeedScale;
+Next.DefaultSpeed = MovementData.GetDefaultSpeed() * SpeedScale;
+Next.MaxSpeed = MovementData.GetMaxSpeed() * SpeedScale;
+Next.JumpHeight = MovementData.GetJumpHeight();
+Next.MaxJumpCount = MovementData.GetMaxJumpCount();
+Next.bEnableSprint = MovementData.IsSprintEnabled();
+Next.bEnableJump = MovementData.IsJumpEnabled();
+Next.bEnableDoubleJump = MovementData.IsDoubleJumpEnabled();
+
+const bool bChanged = !Next.HasSameContent(MovementParameters);
+
+if (bChanged)
+{
+Next.Version = MovementParameters.Version + 1;
+MovementParameters = Next;
+}
+
+// Unchanged parameters are not reapplied, e.g. over a speed another system set on the same owner
+if (!OwnerCharacter || (!bChanged && MovementParametersOwner.Get() == OwnerCharacter))
+{
+return;
+}
+
+MovementParametersOwner = OwnerCharacter;
+
+// Walk and sprint speeds stay in the parameters for the consumers that switch between them
+if (UCharacterMovementComponent* MovementComponent = OwnerCharacter->GetCharacterMovement())
+{
+MovementComponent->MaxWalkSpeed = MovementParameters.DefaultSpeed;
+MovementComponent->JumpZVelocity = MovementParameters.JumpHeight;
+MovementComponent->GetNavAgentPropertiesRef().bCanJump = MovementParameters.bEnableJump;
+}
+
+OwnerCharacter->JumpMaxCount = !MovementParameters.bEnableJump ? 0 : MovementParameters.bEnableDoubleJump ? FMath::Max(MovementParameters.MaxJumpCount, 2) : MovementParameters.MaxJumpCount;
+}
+
+#pragma endregion
+
+#pragma region Damage
+
+static TAutoConsoleVariable<int32> CVarCharacterDamageMessages(
+TEXT("CharacterManager.DamageMessages"),
+1,
+TEXT("Shows an on-screen message for every damage event. The message allocates, disable it when profiling."));
+
+void UCharacterManager::ExecuteDamage(ACharacterModule* TargetCharacter, float InstigatorDamage, float TargetProtection)
+{
+CHARACTER_MANAGER_SCOPE(ExecuteDamage);
+CHARACTER_MANAGER_COUNT(DamageEvents);
+
+// Get target's current health attributes
+float TargetHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health);
+float TargetMinHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+float TargetMaxHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health);
+
+// Final damage after protection and the clamped health
+const CharacterSimulation::FDamageResult Result = CharacterSimulation::ApplyDamage(MakeSimulationAttribute(TargetMinHealth, TargetMaxHealth, TargetHealth, 0.f), InstigatorDamage, TargetProtection);
+float FinalDamage = Result.FinalDamage;
+float NewHealth = Result.NewHealth;
+
+// Journal the hit before the health change and a possible death it causes
+TargetCharacter->GetCharacterManager()->JournalMutation(ECharacterJournalEvent::Damage, 0, InstigatorDamage, TargetProtection, FinalDamage, this);
+
+// Apply damage to target's health
+TargetCharacter->GetCharacterManager()->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, TargetMinHealth, TargetMaxHealth, NewHealth);
+
+if (GEngine && CVarCharacterDamageMessages.GetValueOnGameThread())
+{
+// Debug message to show damage applied
+FString DebugMessage = FString::Printf(TEXT("Damage Applied: %.2f | Target Health: %.2f"), FinalDamage, NewHealth);
+GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, DebugMessage);
+}
+}
+
+void UCharacterManager::ExecuteDamageByType(ACharacterModule* TargetCharacter, float InstigatorDamage, EDamageType DamageType)
+{
+if (!TargetCharacter || !TargetCharacter->GetCharacterManager())
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("ExecuteDamageByType: Invalid target character."));
+#endif
+return;
+}
+
+ExecuteDamage(TargetCharacter, InstigatorDamage, TargetCharacter->GetCharacterManager()->GetRandomProtectionAgainst(DamageType));
+}
+
+// Uniform in [0, 1) from a counter. Stateless, so the batch loop has no dependency between elements.
+static FORCEINLINE float HashToUnitFloat(uint32 Seed, uint32 Index)
+{
+uint32 Hash = Seed ^ (Index * 0x9e3779b9u);
+Hash = (Hash ^ (Hash >> 16)) * 0x7feb352du;
+Hash = (Hash ^ (Hash >> 15)) * 0x846ca68bu;
+Hash ^= Hash >> 16;
+
+// 24 random mantissa bits
+return static_cast<float>(Hash >> 8) * (1.f / 16777216.f);
+}
+
+void UCharacterManager::RollProtectionBatch(TArrayView<ACharacterModule* const> Targets, TArrayView<const EDamageType> DamageTypes, TArrayView<float> OutProtection)
+{
+check(Targets.Num() == DamageTypes.Num() && Targets.Num() == OutProtection.Num());
+
+const int32 NumTargets = Targets.Num();
+
+// Stack storage covers typical area hits without allocating and stays safe if a damage handler starts another batch
+TArray<float, TInlineAllocator<64>> Bases;
+TArray<float, TInlineAllocator<64>> Spreads;
+Bases.AddUninitialized(NumTargets);
+Spreads.AddUninitialized(NumTargets);
+
+// Gather: the only pass that touches the targets
+for (int32 Index = 0; Index < NumTargets; ++Index)
+{
+UCharacterManager* Manager = Targets[Index] ? Targets[Index]->GetCharacterManager() : nullptr;
+const int32 DamageIndex = static_cast<int32>(DamageTypes[Index]);
+
+if (!Manager || DamageIndex >= MaxDamageTypes)
+{
+Bases[Index] = 0.f;
+Spreads[Index] = 0.f;
+continue;
+}
+
+if (Manager->bResistanceMatrixDirty)
+{
+Manager->RebuildResistanceMatrix();
+}
+
+Bases[Index] = Manager->ResistanceMatrix[DamageIndex].Base;
+Spreads[Index] = Manager->ResistanceMatrix[DamageIndex].Spread;
+}
+
+// Roll: contiguous arrays and a stateless generator, so this loop vectorizes
+const uint32 Seed = FMath::Rand32();
+const float* RESTRICT BaseData = Bases.GetData();
+const float* RESTRICT SpreadData = Spreads.GetData();
+float* RESTRICT OutData = OutProtection.GetData();
+
+for (int32 Index = 0; Index < NumTargets; ++Index)
+{
+OutData[Index] = FMath::MulAdd(SpreadData[Index], HashToUnitFloat(Seed, static_cast<uint32>(Index)), BaseData[Index]);
+}
+}
+
+void UCharacterManager::ExecuteDamageBatch(TArrayView<ACharacterModule* const> Targets, TArrayView<const float> Damages, TArrayView<const EDamageType> DamageTypes)
+{
+check(Targets.Num() == Damages.Num() && Targets.Num() == DamageTypes.Num());
+
+// Local, as ExecuteDamage broadcasts and a handler may run a batch of its own
+TArray<float, TInlineAllocator<64>> Protections;
+Protections.AddUninitialized(Targets.Num());
+
+RollProtectionBatch(Targets, DamageTypes, Protections);
+
+for (int32 Index = 0; Index < Targets.Num(); ++Index)
+{
+if (Targets[Index] && Targets[Index]->GetCharacterManager())
+{
+ExecuteDamage(Targets[Index], Damages[Index], Protections[Index]);
+}
+}
+}
+
+#pragma endregion
+
+#pragma region PrimaryAttribute
+
+void UCharacterManager::ExecutePrimaryAttributeRegeneration(ACharacterModule* TargetCharacter, EPrimaryAttributeType Type, float Amount)
+{
+if (!TargetCharacter || Amount <= 0.f)
+{
+return;
+}
+
+RegenTarget = TargetCharacter;
+RegenType = Type;
+RemainingRegenAmount = Amount;
+
+// A running timer is restarted in place and stays counted once
+if (!PrimaryAttributeRegenerationTimerHandle.IsValid())
+{
+INC_DWORD_STAT(STAT_CharacterManager_ActiveTimers);
+++NumActiveCharacterTimers;
+}
+
+GetWorld()->GetTimerManager().SetTimer
+(
+PrimaryAttributeRegenerationTimerHandle,
+this,
+&UCharacterManager::HandleExecutePrimaryAttributeRegenerationHandler,
+0.1f,	// tick interval
+true    // looping
+);
+}
+
+void UCharacterManager::HandleExecutePrimaryAttributeRegenerationHandler()
+{
+CHARACTER_MANAGER_SCOPE(RegenerationTimer);
+
+if (!RegenTarget || !RegenTarget->GetCharacterManager())
+{
+StopPrimaryAttributeRegeneration();
+return;
+}
+
+UCharacterManager* TargetManager = RegenTarget->GetCharacterManager();
+
+float CurrentValue = TargetManager->GetPrimaryAttributeCurrentValueByType(RegenType);
+float MinValue = TargetManager->GetPrimaryAttributeMinimumValueByType(RegenType);
+float MaxValue = TargetManager->GetPrimaryAttributeMaximumValueByType(RegenType);
+
+if (RemainingRegenAmount <= 0.f || CurrentValue >= MaxValue)
+{
+StopPrimaryAttributeRegeneration();
+return;
+}
+
+float RegenPerTick = 1.f;
+
+// 
+float AppliedAmount = FMath::Min(RegenPerTick, FMath::Min(RemainingRegenAmount, MaxValue - CurrentValue));
+TargetManager->SetPrimaryAttributeValueByType(RegenType, MinValue, MaxValue, CurrentValue + AppliedAmount);
+
+RemainingRegenAmount -= AppliedAmount;
+
+
+if (RemainingRegenAmount <= 0.f)
+{
+StopPrimaryAttributeRegeneration();
+return;
+}
+}
+
+void UCharacterManager::StopPrimaryAttributeRegeneration()
+{
+if (!PrimaryAttributeRegenerationTimerHandle.IsValid())
+{
+return;
+}
+
+if (UWorld* World = GetWorld())
+{
+World->GetTimerManager().ClearTimer(PrimaryAttributeRegenerationTimerHandle);
+}
+
+PrimaryAttributeRegenerationTimerHandle.Invalidate();
+DEC_DWORD_STAT(STAT_CharacterManager_ActiveTimers);
+--NumActiveCharacterTimers;
+}
+
+#pragma endregion
+
+#pragma region Replication
+
+TMap<TObjectKey<UWorld>, TArray<UCharacterManager*>> UCharacterManager::PendingReplicationManagers;
+
+void UCharacterManager::MarkReplicationDirty(uint32 Flags)
+{
+ReplicationDirtyMask |= Flags;
+
+if (ReplicationDirtyMask != CharacterDirtyFlags::None && !bQueuedForReplication)
+{
+// Managers outside a world (e.g. archetype spawns in the transient package) share the null key
+ReplicationQueueWorld = GetWorld();
+PendingReplicationManagers.FindOrAdd(ReplicationQueueWorld).Add(this);
+bQueuedForReplication = true;
+}
+}
+
+void UCharacterManager::RemoveFromReplicationQueue()
+{
+if (!bQueuedForReplication)
+{
+return;
+}
+
+// Not found while the queue is being flushed; the flush skips managers whose flag is cleared
+if (TArray<UCharacterManager*>* Pending = PendingReplicationManagers.Find(ReplicationQueueWorld))
+{
+Pending->RemoveSingleSwap(this);
+}
+
+bQueuedForReplication = false;
+}
+
+void UCharacterManager::MarkAttributeReplicationDirty(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+if (AttributeType == ECharacterAttributeType::Null)
+{
+return;
+}
+
+MarkReplicationDirty(GetAttributeReplicationFlags(AttributeType, MinValue, MaxValue, CurrentValue));
+}
+
+uint32 UCharacterManager::GetAttributeReplicationFlags(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+uint32 Flags = CharacterDirtyFlags::None;
+
+if (GetMinimumAttributeValueByType(AttributeType) != MinValue || GetMaximumAttributeValueByType(AttributeType) != MaxValue)
+{
+Flags |= CharacterDirtyFlags::AttributeRange(AttributeType);
+}
+
+// Compared against storage, atomic attributes may be ahead of it
+if (ReadStoredCurrentValue(AttributeType) != CurrentValue)
+{
+Flags |= CharacterDirtyFlags::AttributeCurrent(AttributeType);
+}
+
+return Flags;
+}
+
+void UCharacterManager::MarkFullReplicationDirty()
+{
+MarkReplicationDirty(CharacterDirtyFlags::All);
+}
+
+int32 UCharacterManager::WriteReplicationDelta(TArray<uint8>& OutBuffer)
+{
+if (ReplicationDirtyMask == CharacterDirtyFlags::None)
+{
+return 0;
+}
+
+if (Archetype.IsValid())
+{
+// Composed into a reused copy that only holds the sections the delta reads, so characters that share an
+// archetype neither copy it nor allocate per delta
+check(IsInGameThread());
+static FCharacterData ReplicatedData;
+
+ComposeCharacterData(ReplicatedData, ECharacterDataSection::Attribute
+| ((ReplicationDirtyMask & (CharacterDirtyFlags::Title | CharacterDirtyFlags::Description)) ? ECharacterDataSection::Information : ECharacterDataSection::None)
+| ((ReplicationDirtyMask & (CharacterDirtyFlags::Level | CharacterDirtyFlags::Experience)) ? ECharacterDataSection::Level : ECharacterDataSection::None));
+
+const int32 BytesWritten = FCharacterDeltaEncoder::Encode(ReplicatedData, ReplicationDirtyMask, DeltaQuantization, OutBuffer);
+ReplicationDirtyMask = CharacterDirtyFlags::None;
+
+return BytesWritten;
+}
+
+SyncCompactAttributesToCharacterData();
+
+const int32 BytesWritten = FCharacterDeltaEncoder::Encode(ReadCharacterData(ECharacterDataSection::All), ReplicationDirtyMask, DeltaQuantization, OutBuffer);
+ReplicationDirtyMask = CharacterDirtyFlags::None;
+
+return BytesWritten;
+}
+
+bool UCharacterManager::ApplyReplicationDelta(TArrayView<const uint8> Buffer)
+{
+uint32 AppliedMask = CharacterDirtyFlags::None;
+
+if (!ApplyDecodedReplicationDelta(Buffer, AppliedMask))
+{
+return false;
+}
+
+RefreshAtomicAttributes();
+
+if (AppliedMask & CharacterDirtyFlags::State)
+{
+BroadcastStateChanged(GetStoredCharacterState());
+}
+
+if (AppliedMask & CharacterDirtyFlags::Type)
+{
+BroadcastTypeChanged(GetStoredCharacterType());
+}
+
+if (AppliedMask & CharacterDirtyFlags::Title)
+{
+BroadcastTitleChanged(ReadCharacterData(ECharacterDataSection::Information).GetInformationData().GetTitle());
+}
+
+if (AppliedMask & CharacterDirtyFlags::Description)
+{
+BroadcastDescriptionChanged(ReadCharacterData(ECharacterDataSection::Information).GetInformationData().GetDescription());
+}
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+
+if (AppliedMask & (CharacterDirtyFlags::AttributeCurrent(AttributeType) | CharacterDirtyFlags::AttributeRange(AttributeType)))
+{
+BroadcastAttributeChanged(AttributeType);
+}
+}
+
+return true;
+}
+
+bool UCharacterManager::ApplyDecodedReplicationDelta(TArrayView<const uint8> Buffer, uint32& OutAppliedMask)
+{
+uint32 IncomingMask = CharacterDirtyFlags::None;
+
+if (Buffer.Num() >= sizeof(uint32))
+{
+FMemory::Memcpy(&IncomingMask, Buffer.GetData(), sizeof(uint32));
+}
+
+// Decoded into a reused copy of the sections the delta touches and applied only once the whole delta decoded,
+// so a bad packet leaves the full and compact attributes untouched. Shared sections are only copied out of the
+// archetype once the delta actually changes them.
+check(IsInGameThread());
+static FCharacterData ReplicatedData;
+
+ComposeCharacterData(ReplicatedData, ECharacterDataSection::Attribute
+| ((IncomingMask & (CharacterDirtyFlags::Title | CharacterDirtyFlags::Description)) ? ECharacterDataSection::Information : ECharacterDataSection::None)
+| ((IncomingMask & (CharacterDirtyFlags::Level | CharacterDirtyFlags::Experience)) ? ECharacterDataSection::Level : ECharacterDataSection::None));
+
+if (!FCharacterDeltaEncoder::Decode(Buffer, DeltaQuantization, ReplicatedData, OutAppliedMask))
+{
+return false;
+}
+
+SetStoredCharacterState(ReplicatedData.GetCharacterState());
+SetStoredCharacterType(ReplicatedData.GetCharacterType());
+
+if (OutAppliedMask & (CharacterDirtyFlags::Title | CharacterDirtyFlags::Description))
+{
+FInformationData& Information = WriteCharacterData(ECharacterDataSection::Information).GetInformationData();
+Information.GetTitle() = ReplicatedData.GetInformationData().GetTitle();
+Information.GetDescription() = ReplicatedData.GetInformationData().GetDescription();
+}
+
+if (OutAppliedMask & (CharacterDirtyFlags::Level | CharacterDirtyFlags::Experience))
+{
+WriteCharacterData(ECharacterDataSection::Level).SetLevelData(ReplicatedData.GetLevelData());
+}
+
+bool bRangeChanged = false;
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+bRangeChanged |= (OutAppliedMask & CharacterDirtyFlags::AttributeRange(static_cast<ECharacterAttributeType>(Index))) != 0;
+}
+
+if (bRangeChanged || !bUseCompactAttributes)
+{
+WriteCharacterData(ECharacterDataSection::Attribute).SetAttributeData(ReplicatedData.GetAttributeData());
+}
+
+if (bUseCompactAttributes && bRangeChanged)
+{
+// Re-targets the compact values at the new ranges, which may no longer match the class defaults
+EnableCompactAttributes();
+}
+else if (bUseCompactAttributes)
+{
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+CompactAttributeData.SetCurrentValue(AttributeType, ReplicatedData.GetAttributeData().FindAttributeModuleByType(AttributeType)->GetCurrentValue());
+}
+}
+
+return true;
+}
+
+void UCharacterManager::FlushReplicationDeltas(const UWorld* World, TFunctionRef<void(UCharacterManager* Manager, TArrayView<const uint8> Delta)> Visitor)
+{
+CHARACTER_MANAGER_SCOPE(FlushReplicationDeltas);
+
+TArray<UCharacterManager*>* Pending = PendingReplicationManagers.Find(World);
+
+if (!Pending || Pending->Num() == 0)
+{
+return;
+}
+
+// Swapped out so managers the visitor dirties again queue for the next flush instead of this one
+TArray<UCharacterManager*> Managers = MoveTemp(*Pending);
+Pending->Reset();
+
+TArray<uint8> DeltaBuffer;
+
+for (UCharacterManager* Manager : Managers)
+{
+// Unregistered, destroyed or pooled while an earlier manager was visited
+if (!Manager->bQueuedForReplication)
+{
+continue;
+}
+
+DeltaBuffer.Reset();
+if (Manager->WriteReplicationDelta(DeltaBuffer) > 0)
+{
+Visitor(Manager, DeltaBuffer);
+}
+
+Manager->bQueuedForReplication = false;
+
+// Changes made by the visitor were not queued while the flag was still set
+if (Manager->ReplicationDirtyMask != CharacterDirtyFlags::None)
+{
+Manager->MarkReplicationDirty(CharacterDirtyFlags::None);
+}
+}
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterDeltaBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkDelta"),
+TEXT("Loopback delta replication of regenerating characters. Usage: CharacterManager.BenchmarkDelta [Characters] [Seconds] [UpdateRateHz]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+const int32 NumSeconds = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10;
+const int32 UpdateRate = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 30;
+
+for (const ECharacterDeltaQuantization Mode : { ECharacterDeltaQuantization::Float32, ECharacterDeltaQuantization::Fixed16, ECharacterDeltaQuantization::Fixed8 })
+{
+FCharacterDeltaQuantization Quantization;
+Quantization.PrimaryAttributes = Mode;
+
+TArray<FCharacterData> Senders;
+TArray<FCharacterData> Receivers;
+Senders.SetNum(NumCharacters);
+Receivers.SetNum(NumCharacters);
+
+TArray<uint8> Buffer;
+int64 TotalBytes = 0;
+
+// Initial full state
+for (int32 Index = 0; Index < NumCharacters; ++Index)
+{
+Buffer.Reset();
+uint32 AppliedMask = 0;
+FCharacterDeltaEncoder::Encode(Senders[Index], CharacterDirtyFlags::All, Quantization, Buffer);
+FCharacterDeltaEncoder::Decode(Buffer, Quantization, Receivers[Index], AppliedMask);
+}
+
+// Every character regenerates energy and a tenth of them take damage each update
+for (int32 Update = 0; Update < NumSeconds * UpdateRate; ++Update)
+{
+for (int32 Index = 0; Index < NumCharacters; ++Index)
+{
+FCharacterAttribute& Attributes = Senders[Index].GetAttributeData();
+uint32 DirtyMask = CharacterDirtyFlags::None;
+
+FAttributeModule& Energy = Attributes.GetEnergyAttributeModule();
+Energy.SetValue(Energy.GetMinimumValue(), Energy.GetMaximumValue(), FMath::Fmod(Energy.GetCurrentValue() + 0.5f, Energy.GetMaximumValue()));
+DirtyMask |= CharacterDirtyFlags::AttributeCurrent(ECharacterAttributeType::Energy);
+
+if ((Index + Update) % 10 == 0)
+{
+FAttributeModule& Health = Attributes.GetHealthAttributeModule();
+Health.SetValue(Health.GetMinimumValue(), Health.GetMaximumValue(), FMath::Fmod(Health.GetCurrentValue() + 7.f, Health.GetMaximumValue()));
+DirtyMask |= CharacterDirtyFlags::AttributeCurrent(ECharacterAttributeType::Health);
+}
+
+Buffer.Reset();
+uint32 AppliedMask = 0;
+TotalBytes += FCharacterDeltaEncoder::Encode(Senders[Index], DirtyMask, Quantization, Buffer);
+FCharacterDeltaEncoder::Decode(Buffer, Quantization, Receivers[Index], AppliedMask);
+}
+}
+
+UE_LOG(LogTemp, Log, TEXT("%s: %.1f bytes per character per second (%d characters, %d Hz)"),
+*UEnum::GetValueAsString(Mode), static_cast<double>(TotalBytes) / NumCharacters / NumSeconds, NumCharacters, UpdateRate);
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Rollback
+
+void UCharacterManager::SaveRollbackFrame(int32 Frame)
+{
+if (RollbackFrames <= 0 || Frame < 0)
+{
+return;
+}
+
+const int32 Capacity = static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(RollbackFrames)));
+
+if (RollbackHistory.Num() != Capacity)
+{
+RollbackHistory.Reset();
+RollbackHistory.SetNum(Capacity);
+}
+
+FCharacterRollbackState& Saved = RollbackHistory[Frame & (Capacity - 1)];
+
+Saved.Frame = Frame;
+Saved.State = GetStoredCharacterState();
+
+for (int32 Index = 0; Index < FCharacterRollbackState::NumPrimaryAttributes; ++Index)
+{
+Saved.PrimaryAttributes[Index] = GetPrimaryAttributeCurrentValueByType(static_cast<EPrimaryAttributeType>(Index + 1));
+}
+
+Saved.CaptureProgress(ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData(), ReadCharacterData(ECharacterDataSection::Level).GetLevelData());
+}
+
+bool UCharacterManager::RestoreRollbackFrame(int32 Frame)
+{
+const int32 Capacity = RollbackHistory.Num();
+
+if (Capacity == 0 || Frame < 0)
+{
+return false;
+}
+
+const FCharacterRollbackState& Saved = RollbackHistory[Frame & (Capacity - 1)];
+
+if (Saved.Frame != Frame)
+{
+return false;
+}
+
+SetStoredCharacterState(Saved.State);
+
+for (int32 Index = 0; Index < FCharacterRollbackState::NumPrimaryAttributes; ++Index)
+{
+const ECharacterAttributeType AttributeType = ToCharacterAttributeType(static_cast<EPrimaryAttributeType>(Index + 1));
+
+if (bUseCompactAttributes)
+{
+CompactAttributeData.SetCurrentValue(AttributeType, Saved.PrimaryAttributes[Index]);
+}
+else
+{
+FAttributeModule* Module = WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().FindAttributeModuleByType(AttributeType);
+Module->SetValue(Module->GetMinimumValue(), Module->GetMaximumValue(), Saved.PrimaryAttributes[Index]);
+}
+}
+
+// Shared archetype sections are only copied when the saved values actually differ
+if (Saved.HasAbilityChanges(ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData()))
+{
+Saved.RestoreAbilities(WriteCharacterData(ECharacterDataSection::Ability).GetAbilityData());
+}
+
+if (Saved.HasLevelChanges(ReadCharacterData(ECharacterDataSection::Level).GetLevelData()))
+{
+Saved.RestoreLevel(WriteCharacterData(ECharacterDataSection::Level).GetLevelData());
+}
+
+RefreshAtomicAttributes();
+
+return true;
+}
+
+void UCharacterManager::SaveRollbackFrameForAll(const UWorld* World, int32 Frame)
+{
+for (UCharacterManager* Manager : GetRegisteredManagers(World))
+{
+Manager->SaveRollbackFrame(Frame);
+}
+}
+
+int32 UCharacterManager::RestoreRollbackFrameForAll(const UWorld* World, int32 Frame)
+{
+int32 NumRestored = 0;
+
+for (UCharacterManager* Manager : GetRegisteredManagers(World))
+{
+NumRestored += Manager->RestoreRollbackFrame(Frame) ? 1 : 0;
+}
+
+return NumRestored;
+}
+
+#pragma endregion
+
+#pragma region ArchetypeArchive
+
+FCharacterArchetypeArchive::FCharacterArchetypeArchive() = default;
+
+FCharacterArchetypeArchive::~FCharacterArchetypeArchive()
+{
+Close();
+}
+
+bool FCharacterArchetypeArchive::Cook(const TMap<FName, FCharacterData>& Archetypes, const FString& Filename)
+{
+const uint32 BucketCount = FMath::RoundUpToPowerOfTwo(FMath::Max(1, Archetypes.Num() * 2));
+const uint32 Mask = BucketCount - 1;
+
+TArray<FCharacterArchetypeArchiveEntry> Buckets;
+Buckets.SetNumZeroed(BucketCount);
+
+TArray<uint8> Blob;
+Blob.AddZeroed(sizeof(FCharacterArchetypeArchiveHeader) + BucketCount * sizeof(FCharacterArchetypeArchiveEntry));
+
+TArray<uint8> Snapshot;
+
+for (const TPair<FName, FCharacterData>& Pair : Archetypes)
+{
+const uint32 Key = MakeArchetypeKey(Pair.Key);
+
+uint32 Bucket = Key & Mask;
+while (Buckets[Bucket].Size != 0)
+{
+if (Buckets[Bucket].Key == Key)
+{
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::Cook: Archetype key collision for %s."), *Pair.Key.ToString());
+return false;
+}
+
+Bucket = (Bucket + 1) & Mask;
+}
+
+FCharacterSnapshotSerializer::Serialize(Pair.Value, Snapshot);
+
+Blob.AddZeroed(Align(Blob.Num(), 8) - Blob.Num());
+
+FCharacterArchetypeArchiveEntry& Entry = Buckets[Bucket];
+Entry.Key = Key;
+Entry.Offset = Blob.Num();
+Entry.Size = Snapshot.Num();
+
+Blob.Append(Snapshot);
+Blob.AddZeroed(Align(Blob.Num(), 8) - Blob.Num());
+
+FCharacterArchetypeArchiveHotBlock HotBlock;
+HotBlock.AttributeData = Pair.Value.GetAttributeData();
+HotBlock.MovementData = Pair.Value.GetMovementData();
+HotBlock.State = Pair.Value.GetCharacterState();
+HotBlock.Type = Pair.Value.GetCharacterType();
+
+Entry.HotOffset = Blob.Num();
+Blob.Append(reinterpret_cast<const uint8*>(&HotBlock), sizeof(FCharacterArchetypeArchiveHotBlock));
+}
+
+FCharacterArchetypeArchiveHeader ArchiveHeader;
+ArchiveHeader.Magic = Magic;
+ArchiveHeader.Version = Version;
+ArchiveHeader.HotBlockSize = sizeof(FCharacterArchetypeArchiveHotBlock);
+ArchiveHeader.ArchetypeCount = Archetypes.Num();
+ArchiveHeader.BucketCount = BucketCount;
+
+FMemory::Memcpy(Blob.GetData(), &ArchiveHeader, sizeof(FCharacterArchetypeArchiveHeader));
+FMemory::Memcpy(Blob.GetData() + sizeof(FCharacterArchetypeArchiveHeader), Buckets.GetData(), BucketCount * sizeof(FCharacterArchetypeArchiveEntry));
+
+return FFileHelper::SaveArrayToFile(Blob, *Filename);
+}
+
+uint32 FCharacterArchetypeArchive::MakeArchetypeKey(FName ArchetypeId)
+{
+return FCrc::StrCrc32(*ArchetypeId.ToString().ToLower());
+}
+
+bool FCharacterArchetypeArchive::Open(const FString& Filename)
+{
+Close();
+
+MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+if (!MappedHandle)
+{
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::Open: Failed to map %s."), *Filename);
+return false;
+}
+
+MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+if (!MappedRegion)
+{
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::Open: Failed to map region of %s."), *Filename);
+Close();
+return false;
+}
+
+MappedData = MappedRegion->GetMappedPtr();
+MappedSize = MappedRegion->GetMappedSize();
+
+const FCharacterArchetypeArchiveHeader* MappedHeader = reinterpret_cast<const FCharacterArchetypeArchiveHeader*>(MappedData);
+
+if (MappedSize < static_cast<int64>(sizeof(FCharacterArchetypeArchiveHeader))
+|| MappedHeader->Magic != Magic
+|| MappedHeader->Version != Version
+|| MappedHeader->HotBlockSize != sizeof(FCharacterArchetypeArchiveHotBlock)
+|| !FMath::IsPowerOfTwo(MappedHeader->BucketCount)
+|| MappedSize < static_cast<int64>(sizeof(FCharacterArchetypeArchiveHeader) + static_cast<int64>(MappedHeader->BucketCount) * sizeof(FCharacterArchetypeArchiveEntry)))
+{
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::Open: %s is not a valid archetype archive."), *Filename);
+Close();
+return false;
+}
+
+Header = MappedHeader;
+Entries = reinterpret_cast<const FCharacterArchetypeArchiveEntry*>(MappedData + sizeof(FCharacterArchetypeArchiveHeader));
+
+return true;
+}
+
+void FCharacterArchetypeArchive::Close()
+{
+Header = nullptr;
+Entries = nullptr;
+MappedData = nullptr;
+MappedSize = 0;
+
+MappedRegion.Reset();
+MappedHandle.Reset();
+}
+
+TArrayView<const uint8> FCharacterArchetypeArchive::FindArchetype(uint32 ArchetypeKey) const
+{
+const FCharacterArchetypeArchiveEntry* Entry = FindEntry(ArchetypeKey);
+return Entry ? TArrayView<const uint8>(MappedData + Entry->Offset, Entry->Size) : TArrayView<const uint8>();
+}
+
+const FCharacterArchetypeArchiveEntry* FCharacterArchetypeArchive::FindEntry(uint32 ArchetypeKey) const
+{
+if (!Header)
+{
+return nullptr;
+}
+
+const uint32 Mask = Header->BucketCount - 1;
+uint32 Bucket = ArchetypeKey & Mask;
+
+for (uint32 Probe = 0; Probe < Header->BucketCount; ++Probe)
+{
+const FCharacterArchetypeArchiveEntry& Entry = Entries[Bucket];
+
+if (Entry.Size == 0)
+{
+break;
+}
+
+if (Entry.Key == ArchetypeKey)
+{
+if (static_cast<int64>(Entry.Offset) + Entry.Size > MappedSize
+|| !IsAligned(Entry.HotOffset, alignof(FCharacterArchetypeArchiveHotBlock))
+|| static_cast<int64>(Entry.HotOffset) + static_cast<int64>(sizeof(FCharacterArchetypeArchiveHotBlock)) > MappedSize)
+{
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::FindEntry: Entry is out of bounds."));
+break;
+}
+
+return &Entry;
+}
+
+Bucket = (Bucket + 1) & Mask;
+}
+
+return nullptr;
+}
+
+bool FCharacterArchetypeArchive::InitializeCharacterData(uint32 ArchetypeKey, FCharacterData& OutData, ECharacterDataSection Sections) const
+{
+const FCharacterArchetypeArchiveEntry* Entry = FindEntry(ArchetypeKey);
+
+if (!Entry)
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("FCharacterArchetypeArchive::InitializeCharacterData: Archetype %u not found."), ArchetypeKey);
+#endif
+return false;
+}
+
+// Strings and arrays still need the decoder, it writes the hot sections too and they are overwritten below with the same values
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Information | ECharacterDataSection::Ability | ECharacterDataSection::Protection | ECharacterDataSection::Level))
+{
+if (!FCharacterSnapshotSerializer::Deserialize(TArrayView<const uint8>(MappedData + Entry->Offset, Entry->Size), OutData))
+{
+return false;
+}
+}
+
+const FCharacterArchetypeArchiveHotBlock& HotBlock = *reinterpret_cast<const FCharacterArchetypeArchiveHotBlock*>(MappedData + Entry->HotOffset);
+
+OutData.SetCharacterState(HotBlock.State);
+OutData.SetCharacterType(HotBlock.Type);
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Attribute))
+{
+OutData.GetAttributeData() = HotBlock.AttributeData;
+}
+
+if (EnumHasAnyFlags(Sections, ECharacterDataSection::Movement))
+{
+OutData.GetMovementData() = HotBlock.MovementData;
+}
+
+return true;
+}
+
+void FCharacterArchetypeArchive::ForEachArchetype(TFunctionRef<void(uint32 ArchetypeKey)> Visitor) const
+{
+if (!Header)
+{
+return;
+}
+
+for (uint32 Bucket = 0; Bucket < Header->BucketCount; ++Bucket)
+{
+if (Entries[Bucket].Size != 0)
+{
+Visitor(Entries[Bucket].Key);
+}
+}
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterArchetypeArchiveBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkArchetypeArchive"),
+TEXT("Measures archetype archive startup, hot sections only and all sections. The first pass is only cold if the OS page cache was dropped before the run. Usage: CharacterManager.BenchmarkArchetypeArchive <Filename>"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+if (Args.Num() == 0)
+{
+UE_LOG(LogTemp, Warning, TEXT("Usage: CharacterManager.BenchmarkArchetypeArchive <Filename>"));
+return;
+}
+
+FCharacterData Character;
+const ECharacterDataSection HotSections = ECharacterDataSection::Attribute | ECharacterDataSection::Movement;
+
+// The first pass faults the pages in, the second pass runs from the page cache
+for (const TCHAR* Pass : { TEXT("First"), TEXT("Repeat") })
+{
+const double StartTime = FPlatformTime::Seconds();
+
+FCharacterArchetypeArchive Archive;
+if (!Archive.Open(Args[0]))
+{
+return;
+}
+
+const double OpenSeconds = FPlatformTime::Seconds() - StartTime;
+
+Archive.ForEachArchetype([&Archive, &Character, HotSections](uint32 ArchetypeKey)
+{
+Archive.InitializeCharacterData(ArchetypeKey, Character, HotSections);
+});
+
+const double HotSeconds = FPlatformTime::Seconds() - StartTime - OpenSeconds;
+
+Archive.ForEachArchetype([&Archive, &Character](uint32 ArchetypeKey)
+{
+Archive.InitializeCharacterData(ArchetypeKey, Character);
+});
+
+const double AllSeconds = FPlatformTime::Seconds() - StartTime - OpenSeconds - HotSeconds;
+
+UE_LOG(LogTemp, Log, TEXT("%s: %d archetypes | Open: %.3f ms | Initialize Hot Sections: %.3f ms | Initialize All: %.3f ms"),
+Pass, Archive.GetArchetypeCount(), OpenSeconds * 1000.0, HotSeconds * 1000.0, AllSeconds * 1000.0);
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Pool
+
+UCharacterManager* UCharacterManagerPoolSubsystem::AcquireCharacterManager(ACharacterModule* NewOwner, const FCharacterArchetypePtr& InArchetype)
+{
+check(NewOwner);
+
+UCharacterManager* Manager = nullptr;
+
+if (PooledManagers.Num() > 0)
+{
+// Moving the component to the new owner keeps its allocation and delegate bindings
+Manager = PooledManagers.Pop();
+Manager->Rename(nullptr, NewOwner, REN_DontCreateRedirectors | REN_DoNotDirty | REN_NonTransactional);
+}
+else
+{
+Manager = NewObject<UCharacterManager>(NewOwner);
+}
+
+NewOwner->AddInstanceComponent(Manager);
+Manager->RegisterComponent();
+Manager->Reinitialize(NewOwner, InArchetype);
+
+return Manager;
+}
+
+void UCharacterManagerPoolSubsystem::ReleaseCharacterManager(UCharacterManager* Manager)
+{
+if (!IsValid(Manager))
+{
+#if WITH_EDITOR
+UE_LOG(LogTemp, Error, TEXT("ReleaseCharacterManager: Manager is not valid."));
+#endif
+return;
+}
+
+// Must run before the owner is destroyed, otherwise the manager is destroyed with it
+if (AActor* Owner = Manager->GetOwner())
+{
+Owner->RemoveInstanceComponent(Manager);
+}
+
+Manager->UnregisterComponent();
+Manager->ResetForPool();
+Manager->Rename(nullptr, this, REN_DontCreateRedirectors | REN_DoNotDirty | REN_NonTransactional);
+
+PooledManagers.Add(Manager);
+}
+
+void UCharacterManagerPoolSubsystem::Prewarm(int32 Count)
+{
+PooledManagers.Reserve(PooledManagers.Num() + Count);
+
+for (int32 Index = 0; Index < Count; ++Index)
+{
+UCharacterManager* Manager = NewObject<UCharacterManager>(this);
+Manager->ResetForPool();
+PooledManagers.Add(Manager);
+}
+}
+
+void UCharacterManagerPoolSubsystem::Deinitialize()
+{
+PooledManagers.Empty();
+
+Super::Deinitialize();
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CharacterPoolBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkPoolChurn"),
+TEXT("Compares pooled and unpooled manager churn. Usage: CharacterManager.BenchmarkPoolChurn [DeathsPerSecond] [Seconds] [LiveCharacters]"),
+FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+{
+UCharacterManagerPoolSubsystem* Pool = World ? World->GetSubsystem<UCharacterManagerPoolSubsystem>() : nullptr;
+
+if (!Pool)
+{
+UE_LOG(LogTemp, Error, TEXT("BenchmarkPoolChurn: No game world."));
+return;
+}
+
+const int32 DeathsPerSecond = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+const int32 NumSeconds = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+const int32 NumLive = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 500;
+const int32 FrameRate = 60;
+const int32 DeathsPerFrame = FMath::Max(1, DeathsPerSecond / FrameRate);
+
+FActorSpawnParameters SpawnParameters;
+SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+ACharacterModule* Host = World->SpawnActor<ACharacterModule>(SpawnParameters);
+
+if (!Host)
+{
+UE_LOG(LogTemp, Error, TEXT("BenchmarkPoolChurn: Failed to spawn host character."));
+return;
+}
+
+for (const bool bPooled : { false, true })
+{
+auto Spawn = [&]() -> UCharacterManager*
+{
+if (bPooled)
+{
+return Pool->AcquireCharacterManager(Host);
+}
+
+UCharacterManager* Manager = NewObject<UCharacterManager>(Host);
+Manager->RegisterComponent();
+Manager->SetOwnerCharacter(Host);
+return Manager;
+};
+
+auto Kill = [&](UCharacterManager* Manager)
+{
+if (bPooled)
+{
+Pool->ReleaseCharacterManager(Manager);
+}
+else
+{
+Manager->DestroyComponent();
+}
+};
+
+CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+
+if (bPooled)
+{
+Pool->Prewarm(DeathsPerFrame);
+}
+
+TArray<UCharacterManager*> Live;
+Live.Reserve(NumLive);
+
+for (int32 Index = 0; Index < NumLive; ++Index)
+{
+Live.Add(Spawn());
+}
+
+const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+double TotalFrameSeconds = 0.0;
+double MaxFrameSeconds = 0.0;
+
+for (int32 Frame = 0; Frame < NumSeconds * FrameRate; ++Frame)
+{
+const double FrameStart = FPlatformTime::Seconds();
+
+for (int32 Death = 0; Death < DeathsPerFrame; ++Death)
+{
+const int32 Index = (Frame * DeathsPerFrame + Death) % NumLive;
+Kill(Live[Index]);
+Live[Index] = Spawn();
+}
+
+const double FrameSeconds = FPlatformTime::Seconds() - FrameStart;
+TotalFrameSeconds += FrameSeconds;
+MaxFrameSeconds = FMath::Max(MaxFrameSeconds, FrameSeconds);
+}
+
+const int32 ObjectsAfter = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+const double GCStart = FPlatformTime::Seconds();
+CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+const double GCSeconds = FPlatformTime::Seconds() - GCStart;
+
+UE_LOG(LogTemp, Log, TEXT("%s: Frame avg %.3f ms, max %.3f ms | Objects created: %d | GC: %.3f ms"),
+bPooled ? TEXT("Pooled") : TEXT("Unpooled"),
+TotalFrameSeconds * 1000.0 / (NumSeconds * FrameRate),
+MaxFrameSeconds * 1000.0,
+ObjectsAfter - ObjectsBefore,
+GCSeconds * 1000.0);
+
+for (UCharacterManager* Manager : Live)
+{
+Kill(Manager);
+}
+}
+
+Host->Destroy();
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region PublishedState
+
+void UCharacterManager::PublishState()
+{
+FCharacterPublishedState State;
+State.Frame = GFrameCounter;
+State.State = GetStoredCharacterState();
+State.Type = GetStoredCharacterType();
+State.Level = ReadCharacterData(ECharacterDataSection::Level).GetLevelData().GetLevel();
+
+for (int32 Index = 0; Index < FCharacterPublishedState::NumPrimaryAttributes; ++Index)
+{
+const EPrimaryAttributeType AttributeType = static_cast<EPrimaryAttributeType>(Index + 1);
+
+State.CurrentValues[Index] = GetPrimaryAttributeCurrentValueByType(AttributeType);
+State.MaximumValues[Index] = GetPrimaryAttributeMaximumValueByType(AttributeType);
+}
+
+PublishedState.Write(State);
+}
+
+#pragma endregion
+
+#pragma region HudSnapshot
+
+const FCharacterHudSnapshot& UCharacterManager::GetHudSnapshot()
+{
+if (!bPublishHudSnapshot)
+{
+bPublishHudSnapshot = true;
+PublishHudSnapshot();
+}
+
+return HudSnapshot;
+}
+
+void UCharacterManager::PublishHudSnapshot()
+{
+CHARACTER_MANAGER_SCOPE(PublishHudSnapshot);
+
+FCharacterHudSnapshot Next;
+Next.State = GetStoredCharacterState();
+
+const FCharacterLevelData& LevelData = ReadCharacterData(ECharacterDataSection::Level).GetLevelData();
+Next.Level = LevelData.GetLevel();
+Next.Experience = LevelData.GetExperience();
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+FCharacterHudAttribute& Attribute = *Next.FindAttribute(AttributeType);
+
+Attribute.MinValue = GetMinimumAttributeValueByType(AttributeType);
+Attribute.MaxValue = GetMaximumAttributeValueByType(AttributeType);
+Attribute.CurrentValue = GetCurrentAttributeValueByType(AttributeType);
+}
+
+const FCharacterAbilityData& AbilityData = ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData();
+Next.CombatStrikeCooldown = AbilityData.FindCharacterAbilityByTypePtr(ECharacterAbilityType::CombatStrike)->GetCooldownTimer();
+Next.LaserPulseCooldown = AbilityData.FindCharacterAbilityByTypePtr(ECharacterAbilityType::LaserPulse)->GetCooldownTimer();
+Next.PlasmaShieldCooldown = AbilityData.FindCharacterAbilityByTypePtr(ECharacterAbilityType::PlasmaShield)->GetCooldownTimer();
+
+if (Next.HasSameContent(HudSnapshot))
+{
+return;
+}
+
+Next.Version = HudSnapshot.Version + 1;
+HudSnapshot = Next;
+}
+
+#pragma endregion
+
+#pragma region ParallelUpdate
+
+void UCharacterManager::UpdateManagersParallel(TArrayView<UCharacterManager* const> Managers, float DeltaTime, int32 NumThreads)
+{
+CHARACTER_MANAGER_SCOPE(ParallelUpdate);
+
+const int32 NumManagers = Managers.Num();
+
+if (NumManagers == 0)
+{
+return;
+}
+
+// One contiguous partition per task keeps each worker on its own cache lines
+const int32 MaxTasks = NumThreads > 0 ? NumThreads : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+const int32 NumTasks = FMath::Clamp(MaxTasks, 1, NumManagers);
+const int32 PartitionSize = FMath::DivideAndRoundUp(NumManagers, NumTasks);
+
+for (UCharacterManager* Manager : Managers)
+{
+Manager->PrepareParallelUpdate();
+}
+
+ParallelFor(NumTasks, [&Managers, NumManagers, PartitionSize, DeltaTime](int32 TaskIndex)
+{
+const int32 Start = TaskIndex * PartitionSize;
+const int32 End = FMath::Min(Start + PartitionSize, NumManagers);
+
+for (int32 Index = Start; Index < End; ++Index)
+{
+Managers[Index]->SimulateParallelUpdate(DeltaTime);
+}
+}, NumTasks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+for (UCharacterManager* Manager : Managers)
+{
+Manager->CommitParallelUpdate();
+}
+}
+
+void UCharacterManager::PrepareParallelUpdate()
+{
+// Copying a section out of the archetype or class defaults allocates and may release the archetype's struct heap,
+// so every section the parallel phase writes is made the manager's own here, on the calling thread
+if (IsAnyAbilityOnCooldown())
+{
+WriteCharacterData(ECharacterDataSection::Ability);
+}
+
+if (bUseCompactAttributes || bUseAtomicAttributes)
+{
+return;
+}
+
+for (const ECharacterAttributeType AttributeType : { ECharacterAttributeType::Health, ECharacterAttributeType::Energy, ECharacterAttributeType::Shield, ECharacterAttributeType::Stamina })
+{
+if (IsAttributeUpdateEnabled(AttributeType) && GetCurrentAttributeValueByType(AttributeType) < GetMaximumAttributeValueByType(AttributeType))
+{
+WriteCharacterData(ECharacterDataSection::Attribute);
+return;
+}
+}
+}
+
+void UCharacterManager::SimulateParallelUpdate(float DeltaTime)
+{
+// Same rules as UpdatePrimaryAttributeCurrentValueByType, without the side effects
+const FCharacterAttribute& AttributeData = ReadAttributeData();
+
+for (const ECharacterAttributeType AttributeType : { ECharacterAttributeType::Health, ECharacterAttributeType::Energy, ECharacterAttributeType::Shield, ECharacterAttributeType::Stamina })
+{
+if (!IsAttributeUpdateEnabled(AttributeType))
+{
+continue;
+}
+
+const float MinValue = GetMinimumAttributeValueByType(AttributeType);
+const float MaxValue = GetMaximumAttributeValueByType(AttributeType);
+const float CurrentValue = GetCurrentAttributeValueByType(AttributeType);
+
+if (CurrentValue >= MaxValue)
+{
+continue;
+}
+
+const float NewValue = CharacterSimulation::RegenerateAttribute(MakeSimulationAttribute(MinValue, MaxValue, CurrentValue, AttributeData.FindAttributeModuleByType(AttributeType)->GetRegenerateValue()), DeltaTime);
+
+// Regeneration is a delta like any other concurrent change and is committed with them
+if (bUseAtomicAttributes)
+{
+ApplyPrimaryAttributeDeltaAtomic(static_cast<EPrimaryAttributeType>(AttributeType), NewValue - CurrentValue);
+continue;
+}
+
+DeferredReplicationMask |= GetAttributeReplicationFlags(AttributeType, MinValue, MaxValue, NewValue);
+DeferredAttributeMask |= 1u << static_cast<uint8>(AttributeType);
+
+if (bUseCompactAttributes)
+{
+WriteCompactAttributeValue(AttributeType, MinValue, MaxValue, NewValue);
+}
+else
+{
+WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().FindAttributeModuleByType(AttributeType)->SetValue(MinValue, MaxValue, NewValue);
+}
+}
+
+// The ability section was made the manager's own by PrepareParallelUpdate
+UpdateAbilityCooldowns(DeltaTime);
+}
+
+void UCharacterManager::CommitParallelUpdate()
+{
+if (bUseAtomicAttributes)
+{
+CommitAtomicAttributes();
+}
+
+if (DeferredReplicationMask != CharacterDirtyFlags::None)
+{
+MarkReplicationDirty(DeferredReplicationMask);
+DeferredReplicationMask = CharacterDirtyFlags::None;
+}
+
+if (DeferredAttributeMask == 0)
+{
+return;
+}
+
+const uint16 AttributeMask = DeferredAttributeMask;
+DeferredAttributeMask = 0;
+
+for (uint8 Index = static_cast<uint8>(ECharacterAttributeType::Health); Index < static_cast<uint8>(ECharacterAttributeType::Max); ++Index)
+{
+if (AttributeMask & (1u << Index))
+{
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index);
+const float MinValue = GetMinimumAttributeValueByType(AttributeType);
+const float MaxValue = GetMaximumAttributeValueByType(AttributeType);
+const float CurrentValue = GetCurrentAttributeValueByType(AttributeType);
+
+CHARACTER_MANAGER_COUNT(AttributeWrites);
+JournalMutation(ECharacterJournalEvent::AttributeSet, Index, MinValue, MaxValue, CurrentValue);
+BroadcastAttributeChanged(AttributeType, MinValue, MaxValue, CurrentValue);
+}
+}
+
+if ((AttributeMask & (1u << static_cast<uint8>(ECharacterAttributeType::Health)))
+&& GetCurrentAttributeValueByType(ECharacterAttributeType::Health) <= 0.0f
+&& GetStoredCharacterState() != ECharacterState::Death)
+{
+SetCharacterState(ECharacterState::Death);
+}
+}
+
+void UCharacterManagerRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+Super::Initialize(Collection);
+
+WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UCharacterManagerRegistrySubsystem::HandleWorldTickStart);
+}
+
+void UCharacterManagerRegistrySubsystem::Deinitialize()
+{
+FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+WorldTickStartHandle.Reset();
+
+Super::Deinitialize();
+}
+
+void UCharacterManagerRegistrySubsystem::HandleWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+// The delegate fires for every world, each registry only updates its own
+if (World != GetWorld() || CVarCharacterParallelUpdate.GetValueOnGameThread() == 0 || TickType == LEVELTICK_TimeOnly)
+{
+return;
+}
+
+// A paused world only ticks components that tick even when paused, the parallel phase follows the same rule
+const bool bPaused = World->IsPaused();
+
+TArray<UCharacterManager*, TInlineAllocator<256>> WorldManagers;
+
+for (UCharacterManager* Manager : Managers)
+{
+if (Manager->IsComponentTickEnabled() && (!bPaused || Manager->PrimaryComponentTick.bTickEvenWhenPaused))
+{
+WorldManagers.Add(Manager);
+}
+}
+
+UCharacterManager::UpdateManagersParallel(WorldManagers, DeltaTime, CVarCharacterParallelUpdateThreads.GetValueOnGameThread());
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterParallelUpdateBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkParallelUpdate"),
+TEXT("Measures parallel update scaling for 1 to 16 threads. Usage: CharacterManager.BenchmarkParallelUpdate [Characters] [Frames]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+
+TArray<UCharacterManager*> Managers;
+Managers.Reserve(NumCharacters);
+
+for (int32 Index = 0; Index < NumCharacters; ++Index)
+{
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
+
+// Drop the manager's own logging handlers so only the update itself is measured
+Manager->AttributeChangedEvents.UnsubscribeAll(Manager);
+Managers.Add(Manager);
+}
+
+double SingleThreadSeconds = 0.0;
+
+for (int32 NumThreads = 1; NumThreads <= 16; NumThreads *= 2)
+{
+// Start every run from the same drained state so each one regenerates
+for (UCharacterManager* Manager : Managers)
+{
+for (const EPrimaryAttributeType AttributeType : { EPrimaryAttributeType::Health, EPrimaryAttributeType::Energy, EPrimaryAttributeType::Shield, EPrimaryAttributeType::Stamina })
+{
+const float MinValue = Manager->GetPrimaryAttributeMinimumValueByType(AttributeType);
+const float MaxValue = Manager->GetPrimaryAttributeMaximumValueByType(AttributeType);
+Manager->SetPrimaryAttributeValueByType(AttributeType, MinValue, MaxValue, FMath::Lerp(MinValue, MaxValue, 0.1f) + 1.f);
+}
+}
+
+const double StartTime = FPlatformTime::Seconds();
+
+for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+{
+UCharacterManager::UpdateManagersParallel(Managers, 1.f / 60.f, NumThreads);
+}
+
+const double Seconds = FPlatformTime::Seconds() - StartTime;
+UCharacterManager::FlushReplicationDeltas(nullptr, [](UCharacterManager* Manager, TArrayView<const uint8> Delta) {});
+SingleThreadSeconds = NumThreads == 1 ? Seconds : SingleThreadSeconds;
+
+UE_LOG(LogTemp, Log, TEXT("Threads: %2d | %.3f ms per frame | Speedup: %.2fx"), NumThreads, Seconds * 1000.0 / NumFrames, SingleThreadSeconds / Seconds);
+}
+
+for (UCharacterManager* Manager : Managers)
+{
+Manager->MarkAsGarbage();
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region AtomicAttribute
+
+void UCharacterManager::EnableAtomicAttributes()
+{
+check(IsInGameThread());
+
+bUseAtomicAttributes = true;
+AtomicDirtyMask.store(0, std::memory_order_relaxed);
+bAtomicDeathPending.store(false, std::memory_order_relaxed);
+RefreshAtomicAttributes();
+}
+
+void UCharacterManager::DisableAtomicAttributes()
+{
+check(IsInGameThread());
+
+if (!bUseAtomicAttributes)
+{
+return;
+}
+
+// Deltas still in flight are kept
+CommitAtomicAttributes();
+bUseAtomicAttributes = false;
+}
+
+float UCharacterManager::ApplyPrimaryAttributeDeltaAtomic(EPrimaryAttributeType AttributeType, float Delta, bool* bOutCrossedMinimum)
+{
+if (bOutCrossedMinimum)
+{
+*bOutCrossedMinimum = false;
+}
+
+if (!bUseAtomicAttributes || AttributeType == EPrimaryAttributeType::Null || AttributeType == EPrimaryAttributeType::Max)
+{
 #if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetCurrentAttributeValueByType: Selected AttributeType is Null."));
+UE_LOG(LogTemp, Error, TEXT("ApplyPrimaryAttributeDeltaAtomic: Atomic attributes are not enabled or the attribute type is invalid."));
 #endif
-return 0.0f;
+return 0.f;
+}
+
+const uint8 Index = static_cast<uint8>(AttributeType) - 1;
+FAtomicPrimaryAttribute& Attribute = AtomicAttributes[Index];
+
+const float MinValue = Attribute.MinimumValue.load(std::memory_order_relaxed);
+const float MaxValue = Attribute.MaximumValue.load(std::memory_order_relaxed);
+
+float OldValue = Attribute.CurrentValue.load(std::memory_order_relaxed);
+float NewValue;
+
+do
+{
+NewValue = FMath::Clamp(OldValue + Delta, MinValue, MaxValue);
+}
+while (!Attribute.CurrentValue.compare_exchange_weak(OldValue, NewValue, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+AtomicDirtyMask.fetch_or(static_cast<uint8>(1u << Index), std::memory_order_release);
+
+// Every successful exchange is a distinct step, so only one caller sees this transition
+const bool bCrossedMinimum = OldValue > MinValue && NewValue <= MinValue;
+
+if (bCrossedMinimum && AttributeType == EPrimaryAttributeType::Health)
+{
+bAtomicDeathPending.store(true, std::memory_order_release);
+}
+
+if (bOutCrossedMinimum)
+{
+*bOutCrossedMinimum = bCrossedMinimum;
+}
+
+return NewValue;
+}
+
+void UCharacterManager::RefreshAtomicAttributes()
+{
+if (!bUseAtomicAttributes)
+{
+return;
+}
+
+for (const EPrimaryAttributeType AttributeType : { EPrimaryAttributeType::Health, EPrimaryAttributeType::Stamina, EPrimaryAttributeType::Energy, EPrimaryAttributeType::Shield })
+{
+const ECharacterAttributeType CharacterAttributeType = ToCharacterAttributeType(AttributeType);
+
+StoreAtomicAttribute(AttributeType,
+GetMinimumAttributeValueByType(CharacterAttributeType),
+GetMaximumAttributeValueByType(CharacterAttributeType),
+ReadStoredCurrentValue(CharacterAttributeType));
+}
+}
+
+void UCharacterManager::StoreAtomicAttribute(EPrimaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+FAtomicPrimaryAttribute& Attribute = AtomicAttributes[static_cast<uint8>(AttributeType) - 1];
+
+Attribute.MinimumValue.store(MinValue, std::memory_order_relaxed);
+Attribute.MaximumValue.store(MaxValue, std::memory_order_relaxed);
+Attribute.CurrentValue.store(CurrentValue, std::memory_order_release);
+}
+
+void UCharacterManager::CommitAtomicAttributes()
+{
+CHARACTER_MANAGER_SCOPE(CommitAtomicAttributes);
+
+const uint8 DirtyMask = AtomicDirtyMask.exchange(0, std::memory_order_acq_rel);
+
+for (uint8 Index = 0; Index < FCharacterPublishedState::NumPrimaryAttributes; ++Index)
+{
+if (!(DirtyMask & (1u << Index)))
+{
+continue;
+}
+
+const ECharacterAttributeType AttributeType = static_cast<ECharacterAttributeType>(Index + 1);
+const float CurrentValue = AtomicAttributes[Index].CurrentValue.load(std::memory_order_acquire);
+
+if (CurrentValue == ReadStoredCurrentValue(AttributeType))
+{
+continue;
+}
+
+const float MinValue = GetMinimumAttributeValueByType(AttributeType);
+const float MaxValue = GetMaximumAttributeValueByType(AttributeType);
+
+CHARACTER_MANAGER_COUNT(AttributeWrites);
+MarkReplicationDirty(GetAttributeReplicationFlags(AttributeType, MinValue, MaxValue, CurrentValue));
+JournalMutation(ECharacterJournalEvent::AttributeSet, static_cast<uint8>(AttributeType), MinValue, MaxValue, CurrentValue);
+
+if (bUseCompactAttributes)
+{
+WriteCompactAttributeValue(AttributeType, MinValue, MaxValue, CurrentValue);
+}
+else
+{
+WriteCharacterData(ECharacterDataSection::Attribute).GetAttributeData().FindAttributeModuleByType(AttributeType)->SetValue(MinValue, MaxValue, CurrentValue);
+}
+
+BroadcastAttributeChanged(AttributeType, MinValue, MaxValue, CurrentValue);
+}
+
+if (bAtomicDeathPending.exchange(false, std::memory_order_acq_rel) && GetStoredCharacterState() != ECharacterState::Death)
+{
+SetCharacterState(ECharacterState::Death);
+}
+}
+
+float UCharacterManager::ReadStoredCurrentValue(ECharacterAttributeType AttributeType)
+{
+if (bUseCompactAttributes)
+{
+return CompactAttributeData.GetCurrentValue(AttributeType);
+}
+
+if (const FAttributeModule* AttributeModule = ReadCharacterData(ECharacterDataSection::Attribute).GetAttributeData().FindAttributeModuleByType(AttributeType))
+{
+return AttributeModule->GetCurrentValue();
+}
+
+return 0.f;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterAtomicAttributeBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkAtomicAttributes"),
+TEXT("Stress tests atomic health deltas for a single death and measures contention for 1 to 16 threads. Usage: CharacterManager.BenchmarkAtomicAttributes [OpsPerThread]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 OpsPerThread = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+const int32 MaxThreads = 16;
+
+TArray<UCharacterManager*> Managers;
+
+for (int32 Index = 0; Index < MaxThreads; ++Index)
+{
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
+
+// Drop the manager's own logging handlers so only the mutation itself is measured
+Manager->AttributeChangedEvents.UnsubscribeAll(Manager);
+Manager->EnableAtomicAttributes();
+Managers.Add(Manager);
+}
+
+// Stress: every thread drains health of one manager well past its minimum
+UCharacterManager* Target = Managers[0];
+const float MinValue = Target->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+const float MaxValue = Target->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health);
+const float Damage = FMath::Max(1.f, (MaxValue - MinValue) * 2.f / (MaxThreads * OpsPerThread));
+
+for (int32 Round = 0; Round < 10; ++Round)
+{
+Target->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, MinValue, MaxValue, MaxValue);
+
+std::atomic<int32> NumDeaths = 0;
+
+ParallelFor(MaxThreads, [&](int32 ThreadIndex)
+{
+for (int32 Op = 0; Op < OpsPerThread; ++Op)
+{
+bool bCrossedMinimum = false;
+Target->ApplyPrimaryAttributeDeltaAtomic(EPrimaryAttributeType::Health, -Damage, &bCrossedMinimum);
+NumDeaths += bCrossedMinimum ? 1 : 0;
+}
+});
+
+const float FinalValue = Target->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health);
+const bool bPassed = NumDeaths.load() == 1 && FinalValue == MinValue;
+
+UE_LOG(LogTemp, Log, TEXT("Stress round %d: %s | Deaths: %d | Final health: %.2f"), Round, bPassed ? TEXT("PASS") : TEXT("FAIL"), NumDeaths.load(), FinalValue);
+}
+
+// Contention: one shared manager against one manager per thread, with deltas that never clamp
+for (int32 NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+{
+double Seconds[2];
+
+for (int32 bShared = 0; bShared < 2; ++bShared)
+{
+const double StartTime = FPlatformTime::Seconds();
+
+ParallelFor(NumThreads, [&](int32 ThreadIndex)
+{
+UCharacterManager* Manager = Managers[bShared ? 0 : ThreadIndex];
+
+for (int32 Op = 0; Op < OpsPerThread; ++Op)
+{
+Manager->ApplyPrimaryAttributeDeltaAtomic(EPrimaryAttributeType::Energy, (Op & 1) ? 0.5f : -0.5f);
+}
+});
+
+Seconds[bShared] = FPlatformTime::Seconds() - StartTime;
+}
+
+const double TotalOps = static_cast<double>(NumThreads) * OpsPerThread;
+UE_LOG(LogTemp, Log, TEXT("Threads: %2d | Separate: %.1f Mops/s | Shared: %.1f Mops/s"), NumThreads, TotalOps / Seconds[0] / 1e6, TotalOps / Seconds[1] / 1e6);
+}
+
+// Pending deaths are never committed, the managers have no owner
+for (UCharacterManager* Manager : Managers)
+{
+Manager->MarkAsGarbage();
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region AbilityScoring
+
+// Everything the scoring reads, copied on the game thread so workers never touch a manager
+struct FCharacterAbilityScoringAbility
+{
+ECharacterAbilityType AbilityType = ECharacterAbilityType::Null;
+EAbilityEffectType EffectType = EAbilityEffectType::Null;
+EAbilityCostType CostType = EAbilityCostType::Null;
+float MaxCost = 0.f;
+float MeanPower = 0.f;
+float MeanCooldownTime = 0.f;
+float Range = 0.f;
+float CooldownTimer = 0.f;
+};
+
+struct FCharacterAbilityScoringCaster
+{
+FCharacterAbilityScoringAbility Abilities[FCharacterAbilityChoice::NumAbilities];
+
+// Current value of each cost pool, indexed by EAbilityCostType
+float CostPools[static_cast<uint8>(EAbilityCostType::Max)] = {};
+float MissingHealth = 0.f;
+FVector Location = FVector::ZeroVector;
+};
+
+struct FCharacterAbilityScoringTarget
+{
+float RemainingHealth = 0.f;
+FVector Location = FVector::ZeroVector;
+};
+
+struct FCharacterAbilityScoringPair
+{
+int32 CasterIndex = INDEX_NONE;
+int32 TargetIndex = INDEX_NONE;
+float Protection = 0.f;
+};
+
+struct FCharacterAbilityScoringInput
+{
+TArray<FCharacterAbilityScoringCaster> Casters;
+TArray<FCharacterAbilityScoringTarget> Targets;
+TArray<FCharacterAbilityScoringPair> Pairs;
+};
+
+static FCharacterAbilityChoice ScoreAbilityPair(const FCharacterAbilityScoringInput& Input, int32 PairIndex)
+{
+FCharacterAbilityChoice Choice;
+const FCharacterAbilityScoringPair& Pair = Input.Pairs[PairIndex];
+
+if (Pair.CasterIndex == INDEX_NONE)
+{
+return Choice;
+}
+
+const FCharacterAbilityScoringCaster& Caster = Input.Casters[Pair.CasterIndex];
+const FCharacterAbilityScoringTarget& Target = Input.Targets[Pair.TargetIndex];
+const float DistanceSquared = FVector::DistSquared(Caster.Location, Target.Location);
+
+for (int32 Index = 0; Index < FCharacterAbilityChoice::NumAbilities; ++Index)
+{
+const FCharacterAbilityScoringAbility& Ability = Caster.Abilities[Index];
+FCharacterAbilityScore& Score = Choice.Abilities[Index];
+
+Score.AbilityType = Ability.AbilityType;
+
+// Worst case cost, an AI should not start an ability it may not be able to pay
+Score.bAffordable = Ability.CostType == EAbilityCostType::Null || Caster.CostPools[static_cast<uint8>(Ability.CostType)] >= Ability.MaxCost;
+
+// Abilities without range are cast on self
+Score.bInRange = Ability.Range <= 0.f || DistanceSquared <= FMath::Square(Ability.Range);
+Score.bReady = Ability.CooldownTimer <= 0.f;
+
+if (!Score.IsUsable())
+{
+continue;
+}
 
-default:
-return 0.0f;
+const float CooldownTime = FMath::Max(Ability.MeanCooldownTime, 0.1f);
+
+if (Ability.EffectType == EAbilityEffectType::Damage)
+{
+Score.ExpectedDamage = FMath::Min(FMath::Max(Ability.MeanPower - Pair.Protection, 0.f), Target.RemainingHealth);
+Score.Score = Score.ExpectedDamage / CooldownTime;
+}
+else if (Ability.EffectType == EAbilityEffectType::Defense)
+{
+// Worth more the more the caster is hurt, overtakes strikes once the missing health exceeds their damage
+Score.Score = Caster.MissingHealth / CooldownTime;
 }
 }
 
-float UCharacterManager::GetMinimumAttributeValueByType(ECharacterAttributeType AttributeType)
+// Insertion sort, three entries
+for (int32 Index = 1; Index < FCharacterAbilityChoice::NumAbilities; ++Index)
 {
-switch (AttributeType)
+const FCharacterAbilityScore Score = Choice.Abilities[Index];
+int32 Insert = Index;
+
+while (Insert > 0 && Choice.Abilities[Insert - 1].Score < Score.Score)
 {
-case ECharacterAttributeType::Health:
-return CharacterData.GetAttributeData().GetHealthAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Energy:
-return CharacterData.GetAttributeData().GetEnergyAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Shield:
-return CharacterData.GetAttributeData().GetShieldAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Stamina:
-return CharacterData.GetAttributeData().GetStaminaAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetMinimumValue();
-case ECharacterAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetMinimumAttributeValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
-default:
-return 0.0f;
+Choice.Abilities[Insert] = Choice.Abilities[Insert - 1];
+--Insert;
 }
+
+Choice.Abilities[Insert] = Score;
 }
 
-float UCharacterManager::GetMaximumAttributeValueByType(ECharacterAttributeType AttributeType)
+return Choice;
+}
+
+void UCharacterManager::GatherAbilityScoringInput(FCharacterAbilityScoringInput& Input, TArrayView<const FCharacterAbilityQuery> Queries)
 {
-switch (AttributeType)
+check(IsInGameThread());
+
+const auto GatherCaster = [](UCharacterManager* Manager, FCharacterAbilityScoringCaster& Caster)
 {
-case ECharacterAttributeType::Health:
-return CharacterData.GetAttributeData().GetHealthAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Energy:
-return CharacterData.GetAttributeData().GetEnergyAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Shield:
-return CharacterData.GetAttributeData().GetShieldAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Stamina:
-return CharacterData.GetAttributeData().GetStaminaAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetMaximumValue();
-case ECharacterAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetMaximumAttributeByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
-default:
-return 0.0f;
+// Each ability is resolved once per caster instead of once per getter call
+const FCharacterAbilityData& AbilityData = Manager->ReadCharacterData(ECharacterDataSection::Ability).GetAbilityData();
+const ECharacterAbilityType AbilityTypes[] = { ECharacterAbilityType::CombatStrike, ECharacterAbilityType::LaserPulse, ECharacterAbilityType::PlasmaShield };
+
+for (int32 Index = 0; Index < FCharacterAbilityChoice::NumAbilities; ++Index)
+{
+const FCharacterAbilityModule* AbilityModule = AbilityData.FindCharacterAbilityByTypePtr(AbilityTypes[Index]);
+
+if (!AbilityModule)
+{
+continue;
 }
+
+FCharacterAbilityScoringAbility& Ability = Caster.Abilities[Index];
+Ability.AbilityType = AbilityTypes[Index];
+Ability.EffectType = AbilityModule->GetEffectType();
+Ability.CostType = AbilityModule->GetCostType();
+Ability.MaxCost = AbilityModule->GetCostRange().Y;
+Ability.MeanPower = (AbilityModule->GetPowerRange().X + AbilityModule->GetPowerRange().Y) * 0.5f;
+Ability.MeanCooldownTime = (AbilityModule->GetCooldownTimeRange().X + AbilityModule->GetCooldownTimeRange().Y) * 0.5f;
+Ability.Range = AbilityModule->GetRange();
+Ability.CooldownTimer = AbilityModule->GetCooldownTimer();
 }
 
-FAttributeModule UCharacterManager::GetPrimaryAttributeModuleByType(EPrimaryAttributeType AttributeType)
+// EAbilityCostType and EPrimaryAttributeType share their order
+for (uint8 Index = static_cast<uint8>(EAbilityCostType::Health); Index < static_cast<uint8>(EAbilityCostType::Max); ++Index)
 {
-switch (AttributeType)
+Caster.CostPools[Index] = Manager->GetPrimaryAttributeCurrentValueByType(static_cast<EPrimaryAttributeType>(Index));
+}
+
+Caster.MissingHealth = Manager->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health) - Caster.CostPools[static_cast<uint8>(EAbilityCostType::Health)];
+Caster.Location = Manager->GetOwner() ? Manager->GetOwner()->GetActorLocation() : FVector::ZeroVector;
+};
+
+const auto GatherTarget = [](UCharacterManager* Manager, FCharacterAbilityScoringTarget& Target)
+{
+Target.RemainingHealth = Manager->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health) - Manager->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+Target.Location = Manager->GetOwner() ? Manager->GetOwner()->GetActorLocation() : FVector::ZeroVector;
+};
+
+// A manager is gathered once no matter how many queries use it
+TMap<UCharacterManager*, int32> CasterIndices;
+TMap<UCharacterManager*, int32> TargetIndices;
+
+Input.Pairs.SetNum(Queries.Num());
+
+for (int32 Index = 0; Index < Queries.Num(); ++Index)
+{
+const FCharacterAbilityQuery& Query = Queries[Index];
+
+if (!Query.Caster || !Query.Target)
+{
+continue;
+}
+
+FCharacterAbilityScoringPair& Pair = Input.Pairs[Index];
+
+if (const int32* Found = CasterIndices.Find(Query.Caster))
+{
+Pair.CasterIndex = *Found;
+}
+else
+{
+Pair.CasterIndex = CasterIndices.Add(Query.Caster, Input.Casters.AddDefaulted());
+GatherCaster(Query.Caster, Input.Casters[Pair.CasterIndex]);
+}
+
+if (const int32* Found = TargetIndices.Find(Query.Target))
+{
+Pair.TargetIndex = *Found;
+}
+else
+{
+Pair.TargetIndex = TargetIndices.Add(Query.Target, Input.Targets.AddDefaulted());
+GatherTarget(Query.Target, Input.Targets[Pair.TargetIndex]);
+}
+
+// Mean of the protection roll range
+const FProtectionData& ProtectionData = Query.Target->ReadCharacterData(ECharacterDataSection::Protection).GetProtectionData();
+const float BaseProtection = ProtectionData.GetValueByType(Query.TargetProtectionType) * ProtectionData.GetMultiplierByType(Query.TargetProtectionType);
+Pair.Protection = BaseProtection * (1.f + ProtectionData.GetAmplifierByType(Query.TargetProtectionType)) * 0.5f;
+}
+}
+
+static void ScoreAbilityPairs(const FCharacterAbilityScoringInput& Input, TArray<FCharacterAbilityChoice>& OutChoices)
+{
+OutChoices.SetNum(Input.Pairs.Num());
+
+// Scoring a pair is a few dozen flops, batch them so a task is worth scheduling
+const int32 BatchSize = 64;
+const int32 NumBatches = FMath::DivideAndRoundUp(Input.Pairs.Num(), BatchSize);
+
+ParallelFor(NumBatches, [&Input, &OutChoices, BatchSize](int32 BatchIndex)
+{
+const int32 End = FMath::Min((BatchIndex + 1) * BatchSize, Input.Pairs.Num());
+
+for (int32 Index = BatchIndex * BatchSize; Index < End; ++Index)
+{
+OutChoices[Index] = ScoreAbilityPair(Input, Index);
+}
+});
+}
+
+void UCharacterManager::EvaluateAbilities(TArrayView<const FCharacterAbilityQuery> Queries, TArray<FCharacterAbilityChoice>& OutChoices)
+{
+CHARACTER_MANAGER_SCOPE(EvaluateAbilities);
+
+FCharacterAbilityScoringInput Input;
+GatherAbilityScoringInput(Input, Queries);
+ScoreAbilityPairs(Input, OutChoices);
+}
+
+void UCharacterManager::EvaluateAbilitiesAsync(TArrayView<const FCharacterAbilityQuery> Queries, TFunction<void(TArray<FCharacterAbilityChoice>&&)> OnComplete)
+{
+TSharedRef<FCharacterAbilityScoringInput> Input = MakeShared<FCharacterAbilityScoringInput>();
+GatherAbilityScoringInput(*Input, Queries);
+
+AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Input, OnComplete = MoveTemp(OnComplete)]() mutable
+{
+TArray<FCharacterAbilityChoice> Choices;
+ScoreAbilityPairs(*Input, Choices);
+
+AsyncTask(ENamedThreads::GameThread, [Choices = MoveTemp(Choices), OnComplete = MoveTemp(OnComplete)]() mutable
+{
+OnComplete(MoveTemp(Choices));
+});
+});
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterAbilityScoringBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkAbilityScoring"),
+TEXT("Compares per-getter ability selection on the game thread with batched scoring. Usage: CharacterManager.BenchmarkAbilityScoring [Characters] [Iterations]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 2000;
+const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 20;
+
+TArray<UCharacterManager*> Managers;
+TArray<FCharacterAbilityQuery> Queries;
+
+for (int32 Index = 0; Index < NumCharacters; ++Index)
+{
+Managers.Add(NewObject<UCharacterManager>(GetTransientPackage()));
+}
+
+// Everyone evaluates the next character
+for (int32 Index = 0; Index < NumCharacters; ++Index)
+{
+FCharacterAbilityQuery& Query = Queries.AddDefaulted_GetRef();
+Query.Caster = Managers[Index];
+Query.Target = Managers[(Index + 1) % NumCharacters];
+}
+
+const ECharacterAbilityType AbilityTypes[] = { ECharacterAbilityType::CombatStrike, ECharacterAbilityType::LaserPulse, ECharacterAbilityType::PlasmaShield };
+
+// Sum of the best ability type per query, equal for both paths when they agree
+uint64 GetterChecksum = 0;
+uint64 BatchChecksum = 0;
+
+double StartTime = FPlatformTime::Seconds();
+
+// Same rules and arithmetic as ScoreAbilityPair, but every value comes from a getter call
+for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+{
+for (const FCharacterAbilityQuery& Query : Queries)
+{
+UCharacterManager* Caster = Query.Caster;
+UCharacterManager* Target = Query.Target;
+
+const FVector CasterLocation = Caster->GetOwner() ? Caster->GetOwner()->GetActorLocation() : FVector::ZeroVector;
+const FVector TargetLocation = Target->GetOwner() ? Target->GetOwner()->GetActorLocation() : FVector::ZeroVector;
+const float DistanceSquared = FVector::DistSquared(CasterLocation, TargetLocation);
+
+const float BaseProtection = Target->GetValueByType(Query.TargetProtectionType) * Target->GetMultiplierByType(Query.TargetProtectionType);
+const float Protection = BaseProtection * (1.f + Target->GetAmplifierByType(Query.TargetProtectionType)) * 0.5f;
+const float RemainingHealth = Target->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health) - Target->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+const float MissingHealth = Caster->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health) - Caster->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health);
+
+int32 BestIndex = 0;
+float BestScore = 0.f;
+
+for (int32 Index = 0; Index < FCharacterAbilityChoice::NumAbilities; ++Index)
+{
+const ECharacterAbilityType AbilityType = AbilityTypes[Index];
+
+// Effect type and cooldown timer have no getters of their own
+const FCharacterAbilityModule AbilityModule = Caster->GetCharacterAbilityModuleByType(AbilityType);
+
+const EAbilityCostType CostType = Caster->GetAbilityCostTypeByType(AbilityType);
+const bool bAffordable = CostType == EAbilityCostType::Null || Caster->GetPrimaryAttributeCurrentValueByType(static_cast<EPrimaryAttributeType>(CostType)) >= Caster->GetAbilityCostRangeByType(AbilityType).Y;
+const float Range = Caster->GetAbilityRangeByType(AbilityType);
+const bool bInRange = Range <= 0.f || DistanceSquared <= FMath::Square(Range);
+const bool bReady = AbilityModule.GetCooldownTimer() <= 0.f;
+
+float Score = 0.f;
+
+if (bAffordable && bInRange && bReady)
+{
+const FVector2D PowerRange = Caster->GetAbilityPowerRangeByType(AbilityType);
+const FVector2D CooldownRange = Caster->GetAbilityCooldownTimeRangeByType(AbilityType);
+const float CooldownTime = FMath::Max((CooldownRange.X + CooldownRange.Y) * 0.5f, 0.1f);
+
+if (AbilityModule.GetEffectType() == EAbilityEffectType::Damage)
+{
+Score = FMath::Min(FMath::Max((PowerRange.X + PowerRange.Y) * 0.5f - Protection, 0.f), RemainingHealth) / CooldownTime;
+}
+else if (AbilityModule.GetEffectType() == EAbilityEffectType::Defense)
+{
+Score = MissingHealth / CooldownTime;
+}
+}
+
+// The first of equal scores wins, as in the stable sort of the batched path
+if (Index == 0 || Score > BestScore)
+{
+BestScore = Score;
+BestIndex = Index;
+}
+}
+
+GetterChecksum += static_cast<uint64>(AbilityTypes[BestIndex]);
+}
+}
+
+const double GetterSeconds = FPlatformTime::Seconds() - StartTime;
+TArray<FCharacterAbilityChoice> Choices;
+
+StartTime = FPlatformTime::Seconds();
+
+for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+{
+UCharacterManager::EvaluateAbilities(Queries, Choices);
+
+for (const FCharacterAbilityChoice& Choice : Choices)
+{
+BatchChecksum += static_cast<uint64>(Choice.GetBest().AbilityType);
+}
+}
+
+const double BatchSeconds = FPlatformTime::Seconds() - StartTime;
+
+UE_LOG(LogTemp, Log, TEXT("%d pairs | Getters: %.3f ms | Batched: %.3f ms | Speedup: %.2fx (checksums %llu / %llu)"),
+NumCharacters, GetterSeconds * 1000.0 / Iterations, BatchSeconds * 1000.0 / Iterations, GetterSeconds / BatchSeconds, GetterChecksum, BatchChecksum);
+
+if (GetterChecksum != BatchChecksum)
+{
+UE_LOG(LogTemp, Error, TEXT("BenchmarkAbilityScoring: The getter and batched paths chose different abilities."));
+}
+
+for (UCharacterManager* Manager : Managers)
+{
+Manager->MarkAsGarbage();
+}
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Threshold
+
+FCharacterEventHandle UCharacterManager::SubscribeAttributeThresholds(ECharacterAttributeType AttributeType, TArrayView<const float> Boundaries, bool bNormalized, void* Context, FThresholdHandler Handler)
+{
+FCharacterEventHandle Handle;
+
+if (AttributeType == ECharacterAttributeType::Null || AttributeType == ECharacterAttributeType::Max || Boundaries.Num() == 0 || !Handler)
 {
-case EPrimaryAttributeType::Health:
-return CharacterData.GetAttributeData().GetPrimaryAttributeModuleByType(EPrimaryAttributeType::Health);
-case EPrimaryAttributeType::Energy:
-return CharacterData.GetAttributeData().GetPrimaryAttributeModuleByType(EPrimaryAttributeType::Energy);
-case EPrimaryAttributeType::Shield:
-return CharacterData.GetAttributeData().GetPrimaryAttributeModuleByType(EPrimaryAttributeType::Shield);
-case EPrimaryAttributeType::Stamina:
-return CharacterData.GetAttributeData().GetPrimaryAttributeModuleByType(EPrimaryAttributeType::Stamina);
-case EPrimaryAttributeType::Null:
 #if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetPrimaryAttributeModuleByType: Selected AttributeType is Null."));
+UE_LOG(LogTemp, Error, TEXT("SubscribeAttributeThresholds: Invalid attribute type, boundaries or handler."));
 #endif
-return FAttributeModule();
-default:
-return FAttributeModule();
+return Handle;
 }
+
+FThresholdSubscription& Subscription = ThresholdSubscriptions.AddDefaulted_GetRef();
+Subscription.Boundaries.Append(Boundaries.GetData(), Boundaries.Num());
+Subscription.AttributeType = AttributeType;
+Subscription.bNormalized = bNormalized;
+Subscription.Context = Context;
+Subscription.Handler = Handler;
+Subscription.Id = ++LastThresholdId;
+Subscription.Band = FindThresholdBand(Subscription, GetMinimumAttributeValueByType(AttributeType), GetMaximumAttributeValueByType(AttributeType), GetCurrentAttributeValueByType(AttributeType));
+
+ThresholdAttributeMask |= 1u << static_cast<uint8>(AttributeType);
+
+Handle.Id = Subscription.Id;
+return Handle;
 }
 
-float UCharacterManager::GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType AttributeType)
+FCharacterEventHandle UCharacterManager::SubscribeAttributeThresholds(ECharacterAttributeType AttributeType, TArrayView<const float> Boundaries, bool bNormalized, UObject* Object, FThresholdHandler Handler)
 {
-switch (AttributeType)
+// Subscriptions of destroyed objects are only pruned here, evaluation merely skips them
+RemoveThresholdSubscriptions([](const FThresholdSubscription& Subscription) { return Subscription.bTracked && !Subscription.Object.IsValid(); });
+
+const FCharacterEventHandle Handle = SubscribeAttributeThresholds(AttributeType, Boundaries, bNormalized, static_cast<void*>(Object), Handler);
+
+if (Handle.IsValid())
 {
-case EPrimaryAttributeType::Health:
+FThresholdSubscription& Subscription = ThresholdSubscriptions.Last();
+Subscription.Object = Object;
+Subscription.bTracked = true;
+}
+
+return Handle;
+}
+
+void UCharacterManager::UnsubscribeAttributeThresholds(FCharacterEventHandle& Handle)
 {
-auto& Health = CharacterData.GetAttributeData().GetHealthAttributeModule();
-return Health.GetCurrentValue();
+const uint32 Id = Handle.Id;
+RemoveThresholdSubscriptions([Id](const FThresholdSubscription& Subscription) { return Subscription.Id == Id; });
+Handle.Id = 0;
 }
-case EPrimaryAttributeType::Energy:
+
+void UCharacterManager::RemoveThresholdSubscriptions(TFunctionRef<bool(const FThresholdSubscription& Subscription)> Predicate)
 {
-auto& Energy = CharacterData.GetAttributeData().GetEnergyAttributeModule();
-return Energy.GetCurrentValue();
+if (bEvaluatingThresholds)
+{
+// A handler is running inside the evaluation loop, so the entries are only disabled here and dropped once the
+// outermost evaluation returns
+for (FThresholdSubscription& Subscription : ThresholdSubscriptions)
+{
+if (Subscription.Handler && Predicate(Subscription))
+{
+Subscription.Handler = nullptr;
+bThresholdRemovalPending = true;
+}
+}
+}
+else
+{
+ThresholdSubscriptions.RemoveAll([&Predicate](const FThresholdSubscription& Subscription) { return !Subscription.Handler || Predicate(Subscription); });
 }
 
-case EPrimaryAttributeType::Shield:
+ThresholdAttributeMask = 0;
+
+for (const FThresholdSubscription& Subscription : ThresholdSubscriptions)
 {
-auto& Shield = CharacterData.GetAttributeData().GetShieldAttributeModule();
-return Shield.GetCurrentValue();
+if (Subscription.Handler)
+{
+ThresholdAttributeMask |= 1u << static_cast<uint8>(Subscription.AttributeType);
+}
+}
+}
+
+void UCharacterManager::EvaluateAttributeThresholds(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
+{
+const float Range = MaxValue - MinValue;
+const float NormalizedValue = Range > 0.f ? (CurrentValue - MinValue) / Range : 0.f;
+
+// Handlers may write attributes, which evaluates again, or subscribe and unsubscribe. Only the outermost
+// evaluation drops the disabled entries.
+const bool bOutermost = !bEvaluatingThresholds;
+TGuardValue<bool> EvaluationGuard(bEvaluatingThresholds, true);
+
+// Indexed, a handler that subscribes can grow the array. New subscriptions start in the current band, so they
+// are first evaluated on the next change.
+const int32 NumSubscriptions = ThresholdSubscriptions.Num();
+
+for (int32 Index = 0; Index < NumSubscriptions; ++Index)
+{
+FThresholdSubscription& Subscription = ThresholdSubscriptions[Index];
+
+if (Subscription.AttributeType != AttributeType || !Subscription.Handler)
+{
+continue;
+}
+
+// Still inside the current band: two comparisons and no callback
+const float Value = Subscription.bNormalized ? NormalizedValue : CurrentValue;
+const int32 Band = Subscription.Band;
+
+if ((Band == 0 || Value >= Subscription.Boundaries[Band - 1]) && (Band == Subscription.Boundaries.Num() || Value < Subscription.Boundaries[Band]))
+{
+continue;
+}
+
+const int32 NewBand = FindThresholdBand(Subscription, MinValue, MaxValue, CurrentValue);
+Subscription.Band = NewBand;
+
+if (Subscription.bTracked && !Subscription.Object.IsValid())
+{
+continue;
+}
+
+// Subscription may dangle once the handler returns
+Subscription.Handler(Subscription.Context, { this, AttributeType, Band, NewBand, CurrentValue });
+}
+
+if (bOutermost && bThresholdRemovalPending)
+{
+bThresholdRemovalPending = false;
+ThresholdSubscriptions.RemoveAll([](const FThresholdSubscription& Subscription) { return !Subscription.Handler; });
+}
+}
+
+int32 UCharacterManager::FindThresholdBand(const FThresholdSubscription& Subscription, float MinValue, float MaxValue, float CurrentValue)
+{
+const float Range = MaxValue - MinValue;
+const float Value = !Subscription.bNormalized ? CurrentValue : (Range > 0.f ? (CurrentValue - MinValue) / Range : 0.f);
+
+int32 Band = 0;
+
+while (Band < Subscription.Boundaries.Num() && Value >= Subscription.Boundaries[Band])
+{
+++Band;
+}
+
+return Band;
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CharacterThresholdBenchmarkCommand(
+TEXT("CharacterManager.BenchmarkThresholds"),
+TEXT("Counts attribute callbacks vs threshold callbacks while health regenerates. Usage: CharacterManager.BenchmarkThresholds [Seconds] [UpdateRateHz]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+{
+const int32 NumSeconds = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 60;
+const int32 UpdateRate = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 60;
+
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
+
+// Drop the manager's own logging handlers so only the measured listeners run
+Manager->AttributeChangedEvents.UnsubscribeAll(Manager);
+
+int64 NumAttributeCalls = 0;
+int64 NumThresholdCalls = 0;
+
+Manager->AttributeChangedEvents.Subscribe(&NumAttributeCalls, [](void* Context, const FCharacterAttributeChangedEvent& Event)
+{
+++*static_cast<int64*>(Context);
+});
+
+const float Boundaries[] = { 0.25f, 0.5f, 0.75f };
+Manager->SubscribeAttributeThresholds(ECharacterAttributeType::Health, Boundaries, true, &NumThresholdCalls, [](void* Context, const FCharacterThresholdCrossedEvent& Event)
+{
+++*static_cast<int64*>(Context);
+});
+
+const float MinHealth = Manager->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+const float MaxHealth = Manager->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health);
+const int32 NumUpdates = NumSeconds * UpdateRate;
+
+// Regenerate from near empty to full, then take a hit and repeat
+for (int32 Update = 0; Update < NumUpdates; ++Update)
+{
+const float Alpha = static_cast<float>(Update % (UpdateRate * 10)) / (UpdateRate * 10);
+const float Health = FMath::Lerp(MinHealth + 1.f, MaxHealth, Alpha);
+Manager->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, MinHealth, MaxHealth, Health);
+}
+
+UE_LOG(LogTemp, Log, TEXT("Updates: %d | Attribute callbacks: %lld | Threshold callbacks: %lld"), NumUpdates, NumAttributeCalls, NumThresholdCalls);
+
+Manager->MarkAsGarbage();
+})
+);
+#endif
+
+#pragma endregion
+
+#pragma region Journal
+
+void UCharacterManager::JournalStoredAttribute(ECharacterAttributeType AttributeType)
+{
+if (!FCharacterJournal::IsRecording())
+{
+return;
+}
+
+// Read back, so clamping and compact quantization are recorded as replay will see them
+JournalMutation(ECharacterJournalEvent::AttributeSet, static_cast<uint8>(AttributeType),
+GetMinimumAttributeValueByType(AttributeType), GetMaximumAttributeValueByType(AttributeType), GetCurrentAttributeValueByType(AttributeType));
 }
 
-case EPrimaryAttributeType::Stamina:
+void UCharacterManager::JournalMutation(ECharacterJournalEvent Event, uint8 SubType, float Value0, float Value1, float Value2, const UCharacterManager* Instigator)
 {
-auto& Stamina = CharacterData.GetAttributeData().GetStaminaAttributeModule();
-return Stamina.GetCurrentValue();
+if (!FCharacterJournal::IsRecording())
+{
+return;
 }
 
-case EPrimaryAttributeType::Null:
+// Names are written once per session so records only carry ids
+const uint32 CurrentSession = FCharacterJournal::GetSession();
+
+if (JournalSession != CurrentSession)
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetPrimaryAttributeCurrentValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
+JournalSession = CurrentSession;
+FCharacterJournal::RecordIdentity(GetUniqueID(), GetOwner() ? GetOwner()->GetName() : GetName());
 }
 
-default:
-return 0.0f;
-}
+FCharacterJournal::Record(Event, GetUniqueID(), Instigator ? Instigator->GetUniqueID() : 0, SubType, Value0, Value1, Value2);
 }
 
-float UCharacterManager::GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType AttributeType)
+// Per-thread block of journal records
+struct FCharacterJournalChunk
 {
-switch (AttributeType)
+static constexpr int32 Capacity = 64 * 1024;
+
+uint32 Session = 0;
+int32 Size = 0;
+uint8 Data[Capacity];
+};
+
+// Submitted chunks and recycled chunks. Both outlive any journal session, so late submissions are safe.
+static TQueue<FCharacterJournalChunk*, EQueueMode::Mpsc> JournalSubmittedChunks;
+static TLockFreePointerListUnordered<FCharacterJournalChunk, PLATFORM_CACHE_LINE_SIZE> JournalFreeChunks;
+
+static void SubmitJournalChunk(FCharacterJournalChunk* Chunk)
 {
-case EPrimaryAttributeType::Health:
+if (Chunk->Size > 0)
 {
-auto& Health = CharacterData.GetAttributeData().GetHealthAttributeModule();
-return Health.GetMinimumValue();
+JournalSubmittedChunks.Enqueue(Chunk);
 }
-
-case EPrimaryAttributeType::Energy:
+else
 {
-auto& Energy = CharacterData.GetAttributeData().GetEnergyAttributeModule();
-return Energy.GetMinimumValue();
+JournalFreeChunks.Push(Chunk);
+}
 }
 
-case EPrimaryAttributeType::Shield:
+// Holds the chunk a thread appends to. Every slot is registered, so Flush and Stop can take the chunks of all
+// threads. The owning thread checks its chunk out for the duration of an Append; a flush in that window leaves it
+// for the next one.
+struct FCharacterJournalThreadSlot
 {
-auto& Shield = CharacterData.GetAttributeData().GetShieldAttributeModule();
-return Shield.GetMinimumValue();
-}
+FCharacterJournalThreadSlot();
+~FCharacterJournalThreadSlot();
 
-case EPrimaryAttributeType::Stamina:
+std::atomic<FCharacterJournalChunk*> Chunk = nullptr;
+};
+
+static FCriticalSection JournalThreadSlotsLock;
+static TArray<FCharacterJournalThreadSlot*> JournalThreadSlots;
+static thread_local FCharacterJournalThreadSlot JournalThreadSlot;
+
+FCharacterJournalThreadSlot::FCharacterJournalThreadSlot()
 {
-auto& Stamina = CharacterData.GetAttributeData().GetStaminaAttributeModule();
-return Stamina.GetMinimumValue();
+FScopeLock Lock(&JournalThreadSlotsLock);
+JournalThreadSlots.Add(this);
 }
 
-case EPrimaryAttributeType::Null:
+FCharacterJournalThreadSlot::~FCharacterJournalThreadSlot()
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetPrimaryAttributeMinimumValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
+{
+FScopeLock Lock(&JournalThreadSlotsLock);
+JournalThreadSlots.RemoveSwap(this);
 }
 
-default:
-return 0.0f;
+// The thread is exiting, its records go to the writer and the chunk is recycled from there
+if (FCharacterJournalChunk* LastChunk = Chunk.exchange(nullptr))
+{
+SubmitJournalChunk(LastChunk);
 }
 }
 
-float UCharacterManager::GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType AttributeType)
+// Drains submitted chunks to disk
+class FCharacterJournalWriter : public FRunnable
 {
-switch (AttributeType)
+public:
+FCharacterJournalWriter(IFileHandle* InFile, uint32 InSession)
+: File(InFile)
+, Session(InSession)
+{}
+
+virtual uint32 Run() override
 {
-case EPrimaryAttributeType::Health:
+while (!bStopRequested)
 {
-auto& Health = CharacterData.GetAttributeData().GetHealthAttributeModule();
-return Health.GetMaximumValue();
+Drain();
+FPlatformProcess::Sleep(0.05f);
 }
 
-case EPrimaryAttributeType::Energy:
-{
-auto& Energy = CharacterData.GetAttributeData().GetEnergyAttributeModule();
-return Energy.GetMaximumValue();
+Drain();
+return 0;
 }
 
-case EPrimaryAttributeType::Shield:
+virtual void Stop() override
 {
-auto& Shield = CharacterData.GetAttributeData().GetShieldAttributeModule();
-return Shield.GetMaximumValue();
+bStopRequested = true;
 }
 
-case EPrimaryAttributeType::Stamina:
+private:
+void Drain()
 {
-auto& Stamina = CharacterData.GetAttributeData().GetStaminaAttributeModule();
-return Stamina.GetMaximumValue();
-}
+FCharacterJournalChunk* Chunk = nullptr;
+bool bWritten = false;
 
-case EPrimaryAttributeType::Null:
+while (JournalSubmittedChunks.Dequeue(Chunk))
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetPrimaryAttributeMaximumValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
+// Chunks left over from an earlier session are dropped
+if (Chunk->Session == Session)
+{
+File->Write(Chunk->Data, Chunk->Size);
+bWritten = true;
 }
 
-default:
-return 0.0f;
-}
+Chunk->Size = 0;
+JournalFreeChunks.Push(Chunk);
 }
 
-FAttributeModule UCharacterManager::GetSecondaryAttributeModuleByType(ESecondaryAttributeType AttributeType)
-{
-switch (AttributeType)
+if (bWritten)
 {
-case ESecondaryAttributeType::Output:
-return CharacterData.GetAttributeData().GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Output);
-case ESecondaryAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Actuation);
-case ESecondaryAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Integrity);
-case ESecondaryAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Capacity);
-case ESecondaryAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Regeneration);
-case ESecondaryAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetSecondaryAttributeModuleByType: Selected AttributeType is Null."));
-#endif
-return FAttributeModule();
-default:
-return FAttributeModule();
+File->Flush();
 }
 }
 
-float UCharacterManager::GetSecondaryAttributeCurrentValueByType(ESecondaryAttributeType AttributeType)
+TUniquePtr<IFileHandle> File;
+uint32 Session;
+std::atomic<bool> bStopRequested = false;
+};
+
+static FCharacterJournalWriter* JournalWriter = nullptr;
+static FRunnableThread* JournalWriterThread = nullptr;
+static FDelegateHandle JournalEndFrameHandle;
+
+std::atomic<bool> FCharacterJournal::bRecording = false;
+std::atomic<uint32> FCharacterJournal::Session = 0;
+
+bool FCharacterJournal::Start(const FString& Filename)
 {
-switch (AttributeType)
+// Logged in every configuration, a journal that silently fails to start loses the audit trail
+if (IsRecording())
 {
-case ESecondaryAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetCurrentValue();
-case ESecondaryAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetCurrentValue();
-case ESecondaryAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue();
-case ESecondaryAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetCurrentValue();
-case ESecondaryAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue();
-case ESecondaryAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetSecondaryAttributeCurrentValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
-default:
-return 0.0f;
-}
+UE_LOG(LogTemp, Error, TEXT("FCharacterJournal::Start: Journal is already recording."));
+return false;
 }
 
-float UCharacterManager::GetSecondaryAttributeMinimumValueByType(ESecondaryAttributeType AttributeType)
-{
-switch (AttributeType)
+IFileHandle* File = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename);
+
+if (!File)
 {
-case ESecondaryAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetMinimumValue();
-case ESecondaryAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetMinimumValue();
-case ESecondaryAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetMinimumValue();
-case ESecondaryAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetMinimumValue();
-case ESecondaryAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetMinimumValue();
-case ESecondaryAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetSecondaryAttributeMinimumValueByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
-default:
-return 0.0f;
+UE_LOG(LogTemp, Error, TEXT("FCharacterJournal::Start: Failed to open %s."), *Filename);
+return false;
 }
+
+const uint32 FileHeader[2] = { Magic, Version };
+File->Write(reinterpret_cast<const uint8*>(FileHeader), sizeof(FileHeader));
+
+const uint32 NewSession = Session.fetch_add(1) + 1;
+
+JournalWriter = new FCharacterJournalWriter(File, NewSession);
+JournalWriterThread = FRunnableThread::Create(JournalWriter, TEXT("CharacterJournalWriter"), 0, TPri_BelowNormal);
+JournalEndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FCharacterJournal::Flush);
+
+bRecording = true;
+return true;
 }
 
-float UCharacterManager::GetSecondaryAttributeMaximumByType(ESecondaryAttributeType AttributeType)
+void FCharacterJournal::Stop()
 {
-switch (AttributeType)
+if (!IsRecording())
 {
-case ESecondaryAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetMaximumValue();
-case ESecondaryAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetMaximumValue();
-case ESecondaryAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetMaximumValue();
-case ESecondaryAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetMaximumValue();
-case ESecondaryAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetMaximumValue();
-case ESecondaryAttributeType::Null:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("GetSecondaryAttributeMaximumByType: Selected AttributeType is Null."));
-#endif
-return 0.0f;
-default:
-return 0.0f;
+return;
 }
+
+bRecording = false;
+
+FCoreDelegates::OnEndFrame.Remove(JournalEndFrameHandle);
+Flush();
+
+JournalWriter->Stop();
+JournalWriterThread->WaitForCompletion();
+
+delete JournalWriterThread;
+delete JournalWriter;
+JournalWriterThread = nullptr;
+JournalWriter = nullptr;
 }
 
-float UCharacterManager::GetMaximumAttributeByType(ECharacterAttributeType AttributeType)
+void FCharacterJournal::Record(ECharacterJournalEvent Event, uint32 CharacterId, uint32 InstigatorId, uint8 SubType, float Value0, float Value1, float Value2)
 {
-return GetMaximumAttributeValueByType(AttributeType);
+FCharacterJournalRecord NewRecord;
+NewRecord.UtcTicks = FDateTime::UtcNow().GetTicks();
+NewRecord.CharacterId = CharacterId;
+NewRecord.InstigatorId = InstigatorId;
+NewRecord.Event = Event;
+NewRecord.SubType = SubType;
+NewRecord.Values[0] = Value0;
+NewRecord.Values[1] = Value1;
+NewRecord.Values[2] = Value2;
+
+Append(&NewRecord, sizeof(NewRecord));
 }
 
-void UCharacterManager::SetPrimaryAttributeValueByType(EPrimaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
-{
-switch (AttributeType)
-{
-case EPrimaryAttributeType::Health:
+void FCharacterJournal::RecordIdentity(uint32 CharacterId, const FString& Name)
 {
-auto& Health = CharacterData.GetAttributeData().GetHealthAttributeModule();
-Health.SetValue(MinValue, MaxValue, CurrentValue);
-OnHealthAttributeChanged.Broadcast(Health.GetMinimumValue(), Health.GetMaximumValue(), Health.GetCurrentValue());
+const FTCHARToUTF8 NameUtf8(*Name);
 
-if(Health.GetCurrentValue() <= 0.0f)
-{
-SetCharacterState(ECharacterState::Death);
-}	
+alignas(FCharacterJournalRecord) uint8 Buffer[sizeof(FCharacterJournalRecord) + 256];
+FCharacterJournalRecord& NewRecord = *new (Buffer) FCharacterJournalRecord();
+NewRecord.UtcTicks = FDateTime::UtcNow().GetTicks();
+NewRecord.CharacterId = CharacterId;
+NewRecord.Event = ECharacterJournalEvent::Identity;
+NewRecord.PayloadSize = static_cast<uint16>(FMath::Min(NameUtf8.Length(), 256));
 
-break;
+FMemory::Memcpy(Buffer + sizeof(FCharacterJournalRecord), NameUtf8.Get(), NewRecord.PayloadSize);
+Append(Buffer, sizeof(FCharacterJournalRecord) + NewRecord.PayloadSize);
 }
-case EPrimaryAttributeType::Energy:
+
+void FCharacterJournal::Append(const void* Data, int32 Size)
 {
-auto& Energy = CharacterData.GetAttributeData().GetEnergyAttributeModule();
-Energy.SetValue(MinValue, MaxValue, CurrentValue);
-OnEnergyAttributeChanged.Broadcast(Energy.GetMinimumValue(), Energy.GetMaximumValue(), Energy.GetCurrentValue());
-break;
-}
-case EPrimaryAttributeType::Shield:
+FCharacterJournalThreadSlot& Slot = JournalThreadSlot;
+FCharacterJournalChunk* Chunk = Slot.Chunk.exchange(nullptr, std::memory_order_acquire);
+const uint32 CurrentSession = GetSession();
+
+if (Chunk && Chunk->Session != CurrentSession)
 {
-auto& Shield = CharacterData.GetAttributeData().GetShieldAttributeModule();
-Shield.SetValue(MinValue, MaxValue, CurrentValue);
-OnShieldAttributeChanged.Broadcast(Shield.GetMinimumValue(), Shield.GetMaximumValue(), Shield.GetCurrentValue());
-break;
+Chunk->Size = 0;
+Chunk->Session = CurrentSession;
 }
-case EPrimaryAttributeType::Stamina:
+
+if (Chunk && Chunk->Size + Size > FCharacterJournalChunk::Capacity)
 {
-auto& Stamina = CharacterData.GetAttributeData().GetStaminaAttributeModule();
-Stamina.SetValue(MinValue, MaxValue, CurrentValue);
-OnStaminaAttributeChanged.Broadcast(Stamina.GetMinimumValue(), Stamina.GetMaximumValue(), Stamina.GetCurrentValue());
-break;
-}
-default:
-break;
-}
+JournalSubmittedChunks.Enqueue(Chunk);
+Chunk = nullptr;
 }
 
-void UCharacterManager::SetSecondaryAttributeValueByType(ESecondaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue)
-{
-switch (AttributeType)
-{
-case ESecondaryAttributeType::Output:
+if (!Chunk)
 {
-auto& Output = CharacterData.GetAttributeData().GetOutputAttributeModule();
-Output.SetValue(MinValue, MaxValue, CurrentValue);
-OnOutputAttributeChanged.Broadcast(Output.GetMinimumValue(), Output.GetMaximumValue(), Output.GetCurrentValue());
-break;
-}
+Chunk = JournalFreeChunks.Pop();
 
-case ESecondaryAttributeType::Actuation:
+if (!Chunk)
 {
-auto& Actuation = CharacterData.GetAttributeData().GetActuationAttributeModule();
-Actuation.SetValue(MinValue, MaxValue, CurrentValue);
-OnActuationAttributeChanged.Broadcast(Actuation.GetMinimumValue(), Actuation.GetMaximumValue(), Actuation.GetCurrentValue());
-break;
+Chunk = new FCharacterJournalChunk();
 }
 
-case ESecondaryAttributeType::Integrity:
-{
-auto& Integrity = CharacterData.GetAttributeData().GetIntegrityAttributeModule();
-Integrity.SetValue(MinValue, MaxValue, CurrentValue);
-OnIntegrityAttributeChanged.Broadcast(Integrity.GetMinimumValue(), Integrity.GetMaximumValue(), Integrity.GetCurrentValue());
-break;
+Chunk->Session = CurrentSession;
 }
 
-case ESecondaryAttributeType::Capacity:
-{
-auto& Capacity = CharacterData.GetAttributeData().GetCapacityAttributeModule();
-Capacity.SetValue(MinValue, MaxValue, CurrentValue);
-OnCapacityAttributeChanged.Broadcast(Capacity.GetMinimumValue(), Capacity.GetMaximumValue(), Capacity.GetCurrentValue());
-break;
+FMemory::Memcpy(Chunk->Data + Chunk->Size, Data, Size);
+Chunk->Size += Size;
+
+Slot.Chunk.store(Chunk, std::memory_order_release);
 }
 
-case ESecondaryAttributeType::Regeneration:
+void FCharacterJournal::Flush()
 {
-auto& Regeneration = CharacterData.GetAttributeData().GetRegenerationAttributeModule();
-Regeneration.SetValue(MinValue, MaxValue, CurrentValue);
-OnRegenerationAttributeChanged.Broadcast(Regeneration.GetMinimumValue(), Regeneration.GetMaximumValue(), Regeneration.GetCurrentValue());
-break;
-}
+FScopeLock Lock(&JournalThreadSlotsLock);
 
-case ESecondaryAttributeType::Null:
+for (FCharacterJournalThreadSlot* Slot : JournalThreadSlots)
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("SetSecondaryAttributeCurrentValueByType: Selected AttributeType is Null."));
-#endif
-break;
+if (FCharacterJournalChunk* Chunk = Slot->Chunk.exchange(nullptr, std::memory_order_acquire))
+{
+SubmitJournalChunk(Chunk);
 }
 }
 }
 
-bool UCharacterManager::HasPrimaryAttributeValue(EPrimaryAttributeType AttributeType)
+bool FCharacterJournal::Read(const FString& Filename, TFunctionRef<void(const FCharacterJournalRecord& Record, const FString& Name)> Visitor)
 {
-switch (AttributeType)
-{
-case EPrimaryAttributeType::Health:
-return CharacterData.GetAttributeData().GetHealthAttributeModule().GetCurrentValue() > 0.0f;
-
-case EPrimaryAttributeType::Energy:
-return CharacterData.GetAttributeData().GetEnergyAttributeModule().GetCurrentValue() > 0.0f;
-
-case EPrimaryAttributeType::Shield:
-return CharacterData.GetAttributeData().GetShieldAttributeModule().GetCurrentValue() > 0.0f;
-
-case EPrimaryAttributeType::Stamina:
-return CharacterData.GetAttributeData().GetStaminaAttributeModule().GetCurrentValue() > 0.0f;
+TArray<uint8> Bytes;
 
-case EPrimaryAttributeType::Null:
-default:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("HasPrimaryAttributeValue: Invalid AttributeType."));
-#endif
+if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+{
 return false;
 }
-}
-
-bool UCharacterManager::HasSecondaryAttributeValue(ESecondaryAttributeType AttributeType)
-{
-switch (AttributeType)
-{
-case ESecondaryAttributeType::Output:
-return CharacterData.GetAttributeData().GetOutputAttributeModule().GetCurrentValue() > 0.0f;
-
-case ESecondaryAttributeType::Actuation:
-return CharacterData.GetAttributeData().GetActuationAttributeModule().GetCurrentValue() > 0.0f;
 
-case ESecondaryAttributeType::Integrity:
-return CharacterData.GetAttributeData().GetIntegrityAttributeModule().GetCurrentValue() > 0.0f;
+uint32 FileHeader[2] = {};
 
-case ESecondaryAttributeType::Capacity:
-return CharacterData.GetAttributeData().GetCapacityAttributeModule().GetCurrentValue() > 0.0f;
+if (Bytes.Num() < sizeof(FileHeader))
+{
+return false;
+}
 
-case ESecondaryAttributeType::Regeneration:
-return CharacterData.GetAttributeData().GetRegenerationAttributeModule().GetCurrentValue() > 0.0f;
+FMemory::Memcpy(FileHeader, Bytes.GetData(), sizeof(FileHeader));
 
-case ESecondaryAttributeType::Null:
-default:
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("HasSecondaryAttributeValue: Invalid AttributeType."));
-#endif
+if (FileHeader[0] != Magic || FileHeader[1] != Version)
+{
 return false;
 }
-}
 
-void UCharacterManager::UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType AttributeType, float DeltaValue, float Amount)
-{
-switch (AttributeType)
-{
-case EPrimaryAttributeType::Health:
+TMap<uint32, FString> Names;
+int64 Offset = sizeof(FileHeader);
+
+while (Offset + static_cast<int64>(sizeof(FCharacterJournalRecord)) <= Bytes.Num())
 {
-// Update Health
-auto& Health = CharacterData.GetAttributeData().GetHealthAttributeModule();
+FCharacterJournalRecord Record;
+FMemory::Memcpy(&Record, Bytes.GetData() + Offset, sizeof(FCharacterJournalRecord));
+Offset += sizeof(FCharacterJournalRecord);
 
-// Store current health before update
-float CurrentHealth = Health.GetCurrentValue();
-float MaxHealth = Health.GetMaximumValue();
+// A crash can leave the last record incomplete
+if (Offset + Record.PayloadSize > Bytes.Num())
+{
+break;
+}
 
-if(CurrentHealth >= MaxHealth)
+if (Record.Event == ECharacterJournalEvent::Identity)
 {
-// No need to update if health is already at maximum
-return; 
+const FUTF8ToTCHAR Name(reinterpret_cast<const ANSICHAR*>(Bytes.GetData() + Offset), Record.PayloadSize);
+Names.Add(Record.CharacterId, FString(Name.Length(), Name.Get()));
 }
 
-float NewHealth = CurrentHealth + (DeltaValue * Amount);
+Offset += Record.PayloadSize;
 
-// Clamp new health value within min and max bounds
-SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, Health.GetMinimumValue(), Health.GetMaximumValue(), NewHealth);
-break;
+const FString* Name = Names.Find(Record.CharacterId);
+Visitor(Record, Name ? *Name : FString());
 }
 
-case EPrimaryAttributeType::Energy:
+return true;
+}
+
+static FAutoConsoleCommand CharacterJournalStartCommand(
+TEXT("CharacterManager.Journal.Start"),
+TEXT("Starts journaling character mutations. Usage: CharacterManager.Journal.Start [Filename]"),
+FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
 {
-// Update Energy
-auto& Energy = CharacterData.GetAttributeData().GetEnergyAttributeModule();
+const FString Filename = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / FString::Printf(TEXT("CharacterJournal-%s.bin"), *FDateTime::UtcNow().ToString());
+FCharacterJournal::Start(Filename);
+})
+);
 
-// Store current energy before update
-float CurrentEnergy = Energy.GetCurrentValue();
-float MaxEnergy = Energy.GetMaximumValue();
+static FAutoConsoleCommand CharacterJournalStopCommand(
+TEXT("CharacterManager.Journal.Stop"),
+TEXT("Stops journaling character mutations and closes the file."),
+FConsoleCommandDelegate::CreateStatic(&FCharacterJournal::Stop)
+);
 
-if (CurrentEnergy >= MaxEnergy)
+int32 UCharacterJournalCommandlet::Main(const FString& Params)
 {
-return;
-}
+FString Filename;
+FString CharacterFilter;
+FString FromText;
+FString ToText;
 
-float NewEnergy = CurrentEnergy + (DeltaValue * Amount);
-
-SetPrimaryAttributeValueByType(EPrimaryAttributeType::Energy, Energy.GetMinimumValue(), Energy.GetMaximumValue(), NewEnergy);
-break;
+if (!FParse::Value(*Params, TEXT("File="), Filename))
+{
+UE_LOG(LogTemp, Error, TEXT("CharacterJournal: Missing -File=<path>."));
+return 1;
 }
 
-case EPrimaryAttributeType::Shield:
-{
-// Update Shield
-auto& Shield = CharacterData.GetAttributeData().GetShieldAttributeModule();
+FParse::Value(*Params, TEXT("Character="), CharacterFilter);
 
-// Store current shield before update
-float CurrentShield = Shield.GetCurrentValue();
+FDateTime From = FDateTime::MinValue();
+FDateTime To = FDateTime::MaxValue();
 
-if(CurrentShield >= Shield.GetMaximumValue())
+if ((FParse::Value(*Params, TEXT("From="), FromText) && !FDateTime::Parse(FromText, From))
+|| (FParse::Value(*Params, TEXT("To="), ToText) && !FDateTime::Parse(ToText, To)))
 {
-// No need to update if shield is already at maximum
-return; 
+UE_LOG(LogTemp, Error, TEXT("CharacterJournal: Times must use the format 2026.01.31-18.30.00."));
+return 1;
 }
 
-float NewShield = CurrentShield + (DeltaValue * Amount);
+const UEnum* AttributeEnum = StaticEnum<ECharacterAttributeType>();
+const UEnum* StateEnum = StaticEnum<ECharacterState>();
 
-OnShieldAttributeChanged.Broadcast(Shield.GetMinimumValue(), Shield.GetMaximumValue(), NewShield);
-break;
-}
+TMap<uint32, FString> Names;
+int32 NumMatched = 0;
 
-case EPrimaryAttributeType::Stamina:
+const bool bRead = FCharacterJournal::Read(Filename, [&](const FCharacterJournalRecord& Record, const FString& Name)
 {
-// Update Stamina
-auto& Stamina = CharacterData.GetAttributeData().GetStaminaAttributeModule();
+if (Record.Event == ECharacterJournalEvent::Identity)
+{
+Names.Add(Record.CharacterId, Name);
+return;
+}
 
-// Store current stamina before update
-float CurrentStamina = Stamina.GetCurrentValue();
-float MaxStamina = Stamina.GetMaximumValue();
+const FDateTime Time(Record.UtcTicks);
 
-if (CurrentStamina >= MaxStamina)
+if (Time < From || Time > To || (!CharacterFilter.IsEmpty() && !Name.Contains(CharacterFilter)))
 {
-// No need to update if stamina is already at maximum
-return; 
+return;
 }
 
-float NewStamina = CurrentStamina + (DeltaValue * Amount);
+FString Details;
 
-OnStaminaAttributeChanged.Broadcast(Stamina.GetMinimumValue(), Stamina.GetMaximumValue(), NewStamina);
+switch (Record.Event)
+{
+case ECharacterJournalEvent::AttributeSet:
+Details = FString::Printf(TEXT("AttributeSet %s Min: %.2f Max: %.2f Current: %.2f"), *AttributeEnum->GetNameStringByValue(Record.SubType), Record.Values[0], Record.Values[1], Record.Values[2]);
+break;
+case ECharacterJournalEvent::Damage:
+{
+const FString* InstigatorName = Names.Find(Record.InstigatorId);
+Details = FString::Printf(TEXT("Damage by %s Incoming: %.2f Protection: %.2f Final: %.2f"), InstigatorName ? **InstigatorName : TEXT("Unknown"), Record.Values[0], Record.Values[1], Record.Values[2]);
 break;
 }
-
+case ECharacterJournalEvent::StateChange:
+Details = FString::Printf(TEXT("StateChange %s -> %s"), *StateEnum->GetNameStringByValue(static_cast<int64>(Record.Values[0])), *StateEnum->GetNameStringByValue(Record.SubType));
+break;
+case ECharacterJournalEvent::Experience:
+Details = FString::Printf(TEXT("Experience +%.2f"), Record.Values[0]);
+break;
+case ECharacterJournalEvent::LevelUp:
+Details = FString::Printf(TEXT("LevelUp %d"), static_cast<int32>(Record.Values[0]));
+break;
 default:
 break;
 }
 
-UE_LOG(LogTemp, Warning, TEXT("Updated %s Attribute: %f"), *UEnum::GetValueAsString(AttributeType), DeltaValue * Amount);
+UE_LOG(LogTemp, Display, TEXT("%s [%s] %s"), *Time.ToString(TEXT("%Y.%m.%d-%H.%M.%S.%s")), Name.IsEmpty() ? *FString::FromInt(Record.CharacterId) : *Name, *Details);
+++NumMatched;
+});
+
+if (!bRead)
+{
+UE_LOG(LogTemp, Error, TEXT("CharacterJournal: Failed to read %s."), *Filename);
+return 1;
+}
+
+UE_LOG(LogTemp, Display, TEXT("CharacterJournal: %d records matched."), NumMatched);
+return 0;
 }
 
-void UCharacterManager::UpdatePrimaryAttributes(float DeltaTime)
+#pragma endregion
+
+#pragma region BenchmarkSuite
+
+#if !UE_BUILD_SHIPPING
+// Forwards to the real allocator and counts what the benchmark thread allocates
+class FCharacterBenchmarkMalloc final : public FMalloc
 {
-// Attribute Data Reference
-FCharacterAttribute& AttributeData = CharacterData.GetAttributeData();
-auto& HealthModule	= AttributeData.GetHealthAttributeModule();
-auto& EnergyModule	= AttributeData.GetEnergyAttributeModule();
-auto& ShieldModule	= AttributeData.GetShieldAttributeModule();
-auto& StaminaModule = AttributeData.GetStaminaAttributeModule();
+public:
+FMalloc* Inner = nullptr;
+std::atomic<uint32> CountedThreadId = 0;
+uint64 NumAllocations = 0;
+uint64 NumBytes = 0;
 
-// Regenerate Health
-if (HealthModule.IsUpdateEnabled())
+void* Malloc(SIZE_T Count, uint32 Alignment) override
 {
-UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health,DeltaTime, HealthModule.GetRegenerateValue());
+CountAllocation(Count);
+return Inner->Malloc(Count, Alignment);
 }
 
-// Regenerate Energy
-if(EnergyModule.IsUpdateEnabled())
+void* TryMalloc(SIZE_T Count, uint32 Alignment) override
 {
-UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Energy, DeltaTime, EnergyModule.GetRegenerateValue());
+CountAllocation(Count);
+return Inner->TryMalloc(Count, Alignment);
 }
 
-// Regenerate Shield
-if(ShieldModule.IsUpdateEnabled())
+void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
 {
-UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Shield, DeltaTime, ShieldModule.GetRegenerateValue());
+CountAllocation(Count);
+return Inner->Realloc(Original, Count, Alignment);
 }
 
-// Regenerate Stamina
-if(StaminaModule.IsUpdateEnabled())
+void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
 {
-UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Stamina, DeltaTime, StaminaModule.GetRegenerateValue());
+CountAllocation(Count);
+return Inner->TryRealloc(Original, Count, Alignment);
 }
-}
-
-#pragma endregion
 
-#pragma region Ability
+void Free(void* Original) override { Inner->Free(Original); }
+SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+const TCHAR* GetDescriptiveName() override { return TEXT("CharacterBenchmarkMalloc"); }
 
-FCharacterAbilityModule UCharacterManager::GetCharacterAbilityModuleByType(ECharacterAbilityType AbilityType)
+// GMalloc is a plain global that every thread reads without synchronization, so like the engine's malloc
+// wrappers the proxy is only swapped in and out while no other thread allocates: installed at the start of
+// engine pre-init with -CharacterBenchmarkMalloc, and the original allocator restored before engine exit.
+// Start and Stop only switch the counted thread.
+void Install()
+{
+if (FTaskGraphInterface::IsRunning())
 {
-return CharacterData.GetAbilityData().FindCharacterAbilityByType(AbilityType);
+UE_LOG(LogTemp, Error, TEXT("CharacterBenchmarkMalloc: Other threads are already running, allocations are not counted."));
+return;
 }
 
-FString UCharacterManager::GetCharacterAbilityTitleByType(ECharacterAbilityType AbilityType)
-{
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+Inner = GMalloc;
+GMalloc = this;
 
-return AbilityModule->GetTitle();
+FCoreDelegates::OnEnginePreExit.AddLambda([this]()
+{
+// Inner stays set, memory allocated through the proxy can still be freed through it
+GMalloc = Inner;
+});
 }
 
-FString UCharacterManager::GetCharacterAbilityDescriptionByType(ECharacterAbilityType AbilityType)
+bool IsInstalled() const { return GMalloc == this; }
+
+// Counts the calling thread's allocations until Stop
+void Start()
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-return AbilityModule->GetDescription();
+NumAllocations = 0;
+NumBytes = 0;
+CountedThreadId.store(FPlatformTLS::GetCurrentThreadId(), std::memory_order_relaxed);
 }
 
-ECharacterAbilityType UCharacterManager::GetAbilityTypeByType(ECharacterAbilityType AbilityType)
+void Stop()
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-return AbilityModule->GetAbilityType();
+CountedThreadId.store(0, std::memory_order_relaxed);
 }
 
-FVector2D UCharacterManager::GetAbilityPowerRangeByType(ECharacterAbilityType AbilityType)
+private:
+void CountAllocation(SIZE_T Count)
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-return AbilityModule->GetPowerRange();
+if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId.load(std::memory_order_relaxed))
+{
+++NumAllocations;
+NumBytes += Count;
+}
 }
+};
 
-FVector2D UCharacterManager::GetAbilityDurationRangeByType(ECharacterAbilityType AbilityType)
+// The proxy only forwards, so memory allocated before the swap is freed correctly through it
+static FCharacterBenchmarkMalloc CharacterBenchmarkMalloc;
+
+static FDelayedAutoRegisterHelper CharacterBenchmarkMallocRegistration(EDelayedRegisterRunPhase::StartOfEnginePreInit, []()
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-return AbilityModule->GetDurationRange();
+if (FParse::Param(FCommandLine::Get(), TEXT("CharacterBenchmarkMalloc")))
+{
+CharacterBenchmarkMalloc.Install();
 }
+});
 
-FVector2D UCharacterManager::GetAbilityCooldownTimeRangeByType(ECharacterAbilityType AbilityType)
+struct FCharacterBenchmarkResult
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+FString Name;
+double NanosecondsPerOp = 0.0;
+double AllocationsPerOp = 0.0;
+double BytesPerOp = 0.0;
+};
 
-return AbilityModule->GetCooldownTimeRange();
-}
-
-EAbilityCostType UCharacterManager::GetAbilityCostTypeByType(ECharacterAbilityType AbilityType)
+struct FCharacterBenchmarkCase
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+const TCHAR* Name;
+TFunction<float()> Operation;
+};
 
-return AbilityModule->GetCostType();
+// Every op includes one indirect call; results feed a checksum so nothing is optimized away
+static FCharacterBenchmarkResult RunCharacterBenchmarkCase(const FCharacterBenchmarkCase& Case, int32 Iterations, float& Checksum)
+{
+for (int32 Index = 0; Index < FMath::Max(1, Iterations / 10); ++Index)
+{
+Checksum += Case.Operation();
 }
 
-FVector2D UCharacterManager::GetAbilityCostRangeByType(ECharacterAbilityType AbilityType)
-{
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+CharacterBenchmarkMalloc.Start();
 
-return AbilityModule->GetCostRange();
-}
+const uint64 StartCycles = FPlatformTime::Cycles64();
 
-float UCharacterManager::GetAbilityRangeByType(ECharacterAbilityType AbilityType)
+for (int32 Index = 0; Index < Iterations; ++Index)
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-
-return AbilityModule->GetRange();
+Checksum += Case.Operation();
 }
 
-float UCharacterManager::GetAbilityAreaRadiusByType(ECharacterAbilityType AbilityType)
-{
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
 
-return AbilityModule->GetRadius();
+CharacterBenchmarkMalloc.Stop();
+
+FCharacterBenchmarkResult Result;
+Result.Name = Case.Name;
+Result.NanosecondsPerOp = FPlatformTime::ToSeconds64(Cycles) * 1.0e9 / Iterations;
+Result.AllocationsPerOp = static_cast<double>(CharacterBenchmarkMalloc.NumAllocations) / Iterations;
+Result.BytesPerOp = static_cast<double>(CharacterBenchmarkMalloc.NumBytes) / Iterations;
+return Result;
 }
 
-float UCharacterManager::GetAbilityRandomPowerByType(ECharacterAbilityType AbilityType)
+static FString GetCharacterBenchmarkBaselinePath()
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-
-return AbilityModule->GetRandomPower();
+return FPaths::ProfilingDir() / TEXT("CharacterManagerBenchmarkBaseline.csv");
 }
 
-float UCharacterManager::GetAbilityRandomDurationByType(ECharacterAbilityType AbilityType)
+static FAutoConsoleCommandWithWorldAndArgs CharacterBenchmarkSuiteCommand(
+TEXT("CharacterManager.BenchmarkSuite"),
+TEXT("Microbenchmarks of manager accessors and mutators in ns/op, allocations/op and bytes/op (allocations need -CharacterBenchmarkMalloc). ")
+TEXT("Usage: CharacterManager.BenchmarkSuite [Filter] [Iterations] [save|compare]"),
+FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-
-return AbilityModule->GetRandomDuration();
+if (!CharacterBenchmarkMalloc.IsInstalled())
+{
+UE_LOG(LogTemp, Warning, TEXT("BenchmarkSuite: Start with -CharacterBenchmarkMalloc to count allocations, allocs/op and bytes/op read 0."));
 }
 
-float UCharacterManager::GetAbilityRandomCooldownTimeByType(ECharacterAbilityType AbilityType)
-{
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
+FString Filter;
+int32 Iterations = 100000;
+bool bSaveBaseline = false;
+bool bCompareBaseline = false;
 
-return AbilityModule->GetRandomCooldownTime();
+for (const FString& Arg : Args)
+{
+if (Arg == TEXT("save"))
+{
+bSaveBaseline = true;
 }
-
-float UCharacterManager::GetAbilityRandomCostByType(ECharacterAbilityType AbilityType)
+else if (Arg == TEXT("compare"))
 {
-const FCharacterAbilityModule* AbilityModule = CharacterData.GetAbilityData().FindCharacterAbilityByTypePtr(AbilityType);
-
-return AbilityModule->GetRandomCost();
+bCompareBaseline = true;
 }
-
-void UCharacterManager::SetCharacterAbilityTitleByType(ECharacterAbilityType AbilityType, const FString& NewTitle)
+else if (Arg.IsNumeric())
 {
-
+Iterations = FMath::Max(1, FCString::Atoi(*Arg));
 }
-
-void UCharacterManager::SetCharacterAbilityDescriptionByType(ECharacterAbilityType AbilityType, const FString& NewDescription)
+else
 {
-
+Filter = Arg;
+}
 }
 
-void UCharacterManager::SetAbilityPowerRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewPowerRange)
-{
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
 
-}
+// Drop the manager's own logging handlers so only the accessors are measured
+Manager->AttributeChangedEvents.UnsubscribeAll(Manager);
 
-void UCharacterManager::SetAbilityDurationRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewDurationRange)
-{
+const FCharacterData SourceData;
+uint32 Counter = 0;
 
-}
+// Rotates through the valid values of each enum so switch-heavy accessors see every branch
+const auto NextAttribute = [&Counter]() { return static_cast<ECharacterAttributeType>(1 + Counter++ % (static_cast<uint32>(ECharacterAttributeType::Max) - 1)); };
+const auto NextPrimary = [&Counter]() { return static_cast<EPrimaryAttributeType>(1 + Counter++ % (static_cast<uint32>(EPrimaryAttributeType::Max) - 1)); };
+const auto NextSecondary = [&Counter]() { return static_cast<ESecondaryAttributeType>(1 + Counter++ % 5); };
+const auto NextAbility = [&Counter]() { return static_cast<ECharacterAbilityType>(1 + Counter++ % 3); };
 
-void UCharacterManager::SetAbilityCooldownTimeRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewCooldownTimeRange)
+TArray<FCharacterBenchmarkCase> Cases =
 {
+{ TEXT("State.GetCharacterState"), [&]() { return static_cast<float>(Manager->GetCharacterState()); } },
+{ TEXT("Type.GetCharacterType"), [&]() { return static_cast<float>(Manager->GetCharacterType()); } },
+{ TEXT("Information.GetTitle"), [&]() { return static_cast<float>(Manager->GetTitle().Len()); } },
+{ TEXT("Information.SetTitle"), [&]() { Manager->SetTitle(TEXT("Benchmark")); return 0.f; } },
+{ TEXT("Attribute.GetCurrentAttributeValueByType"), [&]() { return Manager->GetCurrentAttributeValueByType(NextAttribute()); } },
+{ TEXT("Attribute.GetMaximumAttributeValueByType"), [&]() { return Manager->GetMaximumAttributeValueByType(NextAttribute()); } },
+{ TEXT("Attribute.GetPrimaryAttributeModuleByType"), [&]() { return Manager->GetPrimaryAttributeModuleByType(NextPrimary()).GetCurrentValue(); } },
+{ TEXT("Attribute.GetPrimaryAttributeCurrentValueByType"), [&]() { return Manager->GetPrimaryAttributeCurrentValueByType(NextPrimary()); } },
+{ TEXT("Attribute.GetSecondaryAttributeModuleByType"), [&]() { return Manager->GetSecondaryAttributeModuleByType(NextSecondary()).GetCurrentValue(); } },
+{ TEXT("Attribute.GetSecondaryAttributeCurrentValueByType"), [&]() { return Manager->GetSecondaryAttributeCurrentValueByType(NextSecondary()); } },
+{ TEXT("Attribute.SetPrimaryAttributeValueByType"), [&]() { Manager->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Energy, 0.f, 100.f, static_cast<float>(Counter++ % 100)); return 0.f; } },
+{ TEXT("Attribute.SetSecondaryAttributeValueByType"), [&]() { Manager->SetSecondaryAttributeValueByType(ESecondaryAttributeType::Output, 0.f, 100.f, static_cast<float>(Counter++ % 100)); return 0.f; } },
+{ TEXT("Attribute.UpdatePrimaryAttributes"), [&]() { Manager->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Stamina, 0.f, 100.f, 50.f); Manager->UpdatePrimaryAttributes(1.f / 60.f); return 0.f; } },
+{ TEXT("Ability.GetCharacterAbilityModuleByType"), [&]() { return Manager->GetCharacterAbilityModuleByType(NextAbility()).GetRange(); } },
+{ TEXT("Ability.GetAbilityRangeByType"), [&]() { return Manager->GetAbilityRangeByType(NextAbility()); } },
+{ TEXT("Ability.GetAbilityCostRangeByType"), [&]() { return Manager->GetAbilityCostRangeByType(NextAbility()).Y; } },
+{ TEXT("Ability.GetAbilityRandomPowerByType"), [&]() { return Manager->GetAbilityRandomPowerByType(NextAbility()); } },
+{ TEXT("Protection.GetValueByType"), [&]() { return Manager->GetValueByType(EProtectionType()); } },
+{ TEXT("Protection.GetRandomFinalProtectionByType"), [&]() { return Manager->GetRandomFinalProtectionByType(EProtectionType()); } },
+{ TEXT("Level.GetLevel"), [&]() { return static_cast<float>(Manager->GetLevel()); } },
+{ TEXT("Level.GetNextLevelExperienceThreshold"), [&]() { return Manager->GetNextLevelExperienceThreshold(); } },
+{ TEXT("Level.AddExperienceToMaxLevel"), [&]() { Manager->GetLevelData().SetLevel(0); Manager->AddExperience(1.0e7f); return static_cast<float>(Manager->GetLevel()); } },
+{ TEXT("Movement.GetWalkSpeed"), [&]() { return Manager->GetWalkSpeed(); } },
+{ TEXT("Movement.GetMaxJumpCount"), [&]() { return static_cast<float>(Manager->GetMaxJumpCount()); } },
+{ TEXT("CharacterData.Construct"), [&]() { FCharacterData Data; return static_cast<float>(Data.GetLevelData().GetLevel()); } },
+{ TEXT("CharacterData.Copy"), [&]() { FCharacterData Data = SourceData; return static_cast<float>(Data.GetLevelData().GetLevel()); } },
+};
 
-}
+// The damage path needs a target character in a world
+ACharacterModule* Target = nullptr;
 
-void UCharacterManager::SetAbilityCostRangeByType(ECharacterAbilityType AbilityType, const FVector2D& NewCostRange)
+if (World)
 {
-
+FActorSpawnParameters SpawnParameters;
+SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+Target = World->SpawnActor<ACharacterModule>(SpawnParameters);
 }
 
-void UCharacterManager::SetAbilityRangeByType(ECharacterAbilityType AbilityType, float NewRange)
+if (Target && Target->GetCharacterManager())
 {
-
+// Protection above the damage keeps the target alive at full health
+Target->GetCharacterManager()->AttributeChangedEvents.UnsubscribeAll(Target->GetCharacterManager());
+Cases.Add({ TEXT("Damage.ExecuteDamage"), [&]() { Manager->ExecuteDamage(Target, 10.f, 20.f); return 0.f; } });
+}
+else
+{
+UE_LOG(LogTemp, Warning, TEXT("BenchmarkSuite: No game world, skipping Damage.ExecuteDamage."));
 }
 
-void UCharacterManager::SetAbilityAreaRadiusByType(ECharacterAbilityType AbilityType, float NewRadius)
+// Name -> results of the saved baseline
+TMap<FString, FCharacterBenchmarkResult> Baseline;
+
+if (bCompareBaseline)
 {
+TArray<FString> Lines;
 
+if (!FFileHelper::LoadFileToStringArray(Lines, *GetCharacterBenchmarkBaselinePath()))
+{
+UE_LOG(LogTemp, Error, TEXT("BenchmarkSuite: No baseline at %s, run with 'save' first."), *GetCharacterBenchmarkBaselinePath());
+bCompareBaseline = false;
 }
 
-void UCharacterManager::SetCharacterAbilityModuleByType(ECharacterAbilityType AbilityType, const FCharacterAbilityModule& NewAbilityModule)
+for (const FString& Line : Lines)
 {
+TArray<FString> Fields;
 
+if (Line.ParseIntoArray(Fields, TEXT(",")) == 4)
+{
+FCharacterBenchmarkResult& BaselineResult = Baseline.Add(Fields[0]);
+BaselineResult.Name = Fields[0];
+BaselineResult.NanosecondsPerOp = FCString::Atod(*Fields[1]);
+BaselineResult.AllocationsPerOp = FCString::Atod(*Fields[2]);
+BaselineResult.BytesPerOp = FCString::Atod(*Fields[3]);
+}
+}
 }
 
-#pragma endregion
-
-#pragma region Protection
+TArray<FString> Lines;
+float Checksum = 0.f;
 
-EProtectionType UCharacterManager::GetProtectionTypeByType(EProtectionType Type)
+for (const FCharacterBenchmarkCase& Case : Cases)
+{
+if (!Filter.IsEmpty() && !FCString::Stristr(Case.Name, *Filter))
 {
-return CharacterData.GetProtectionData().GetProtectionTypeByType(Type);
+continue;
 }
 
-FString UCharacterManager::GetTitleByType(EProtectionType Type)
+const FCharacterBenchmarkResult Result = RunCharacterBenchmarkCase(Case, Iterations, Checksum);
+FString Comparison;
+
+if (const FCharacterBenchmarkResult* BaselineResult = bCompareBaseline ? Baseline.Find(Result.Name) : nullptr)
 {
-return CharacterData.GetProtectionData().GetTitleByType(Type);
-}
+const double Change = (Result.NanosecondsPerOp / FMath::Max(BaselineResult->NanosecondsPerOp, 0.001) - 1.0) * 100.0;
+Comparison = FString::Printf(TEXT(" | %+6.1f%%%s"), Change, Change > 10.0 ? TEXT(" REGRESSION") : TEXT(""));
 
-FString UCharacterManager::GetDescriptionByType(EProtectionType Type)
+// Allocation counts are deterministic, so any new allocation is flagged; bytes get a little room for allocator rounding
+if (Result.AllocationsPerOp > BaselineResult->AllocationsPerOp + 0.005)
 {
-return CharacterData.GetProtectionData().GetDescriptionByType(Type);
+Comparison += FString::Printf(TEXT(" | allocs/op %.2f -> %.2f ALLOC REGRESSION"), BaselineResult->AllocationsPerOp, Result.AllocationsPerOp);
 }
 
-float UCharacterManager::GetValueByType(EProtectionType Type)
+if (Result.BytesPerOp > BaselineResult->BytesPerOp * 1.1 + 1.0)
 {
-return CharacterData.GetProtectionData().GetValueByType(Type);
+Comparison += FString::Printf(TEXT(" | bytes/op %.1f -> %.1f BYTES REGRESSION"), BaselineResult->BytesPerOp, Result.BytesPerOp);
+}
 }
 
-float UCharacterManager::GetMultiplierByType(EProtectionType Type)
-{
-return CharacterData.GetProtectionData().GetMultiplierByType(Type);
+UE_LOG(LogTemp, Log, TEXT("%-48s %10.1f ns/op %8.2f allocs/op %10.1f bytes/op%s"),
+*Result.Name, Result.NanosecondsPerOp, Result.AllocationsPerOp, Result.BytesPerOp, *Comparison);
+
+Lines.Add(FString::Printf(TEXT("%s,%.3f,%.3f,%.3f"), *Result.Name, Result.NanosecondsPerOp, Result.AllocationsPerOp, Result.BytesPerOp));
 }
 
-float UCharacterManager::GetAmplifierByType(EProtectionType Type)
+if (bSaveBaseline)
 {
-return CharacterData.GetProtectionData().GetAmplifierByType(Type);
+FFileHelper::SaveStringArrayToFile(Lines, *GetCharacterBenchmarkBaselinePath());
+UE_LOG(LogTemp, Log, TEXT("BenchmarkSuite: Baseline saved to %s."), *GetCharacterBenchmarkBaselinePath());
 }
 
-float UCharacterManager::GetRandomFinalProtectionByType(EProtectionType Type)
+UE_LOG(LogTemp, Log, TEXT("BenchmarkSuite: Checksum %f"), Checksum);
+
+// Drop the deltas queued by the setters before the manager goes away
+UCharacterManager::FlushReplicationDeltas(nullptr, [](UCharacterManager* DirtyManager, TArrayView<const uint8> Delta) {});
+UCharacterManager::FlushReplicationDeltas(World, [](UCharacterManager* DirtyManager, TArrayView<const uint8> Delta) {});
+
+if (Target)
 {
-return CharacterData.GetProtectionData().GetNetValueByType(Type);
+Target->Destroy();
 }
 
+Manager->MarkAsGarbage();
+})
+);
+#endif
 
 #pragma endregion
 
-#pragma region Level 
+#pragma region AllocationCheck
 
-FCharacterLevelData& UCharacterManager::GetLevelData()
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CharacterAllocationCheckCommand(
+TEXT("CharacterManager.AllocationCheck"),
+TEXT("Plays a scripted combat between spawned characters and fails if any frame allocates on the game thread. Needs -CharacterBenchmarkMalloc. ")
+TEXT("Usage: CharacterManager.AllocationCheck [Characters] [Frames]"),
+FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
 {
-
-return CharacterData.GetLevelData();
+if (!World)
+{
+UE_LOG(LogTemp, Error, TEXT("AllocationCheck: No game world."));
+return;
 }
 
-float UCharacterManager::GetCurrentExperience()
+if (!CharacterBenchmarkMalloc.IsInstalled())
 {
-return CharacterData.GetLevelData().GetExperience();
+UE_LOG(LogTemp, Error, TEXT("AllocationCheck: Start with -CharacterBenchmarkMalloc to count allocations."));
+return;
 }
 
-float UCharacterManager::GetNextLevelExperienceThreshold()
+const int32 NumCharacters = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 8;
+const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 600;
+const int32 NumWarmupFrames = 60;
+const float DeltaTime = 1.f / 60.f;
+
+TArray<ACharacterModule*> Characters;
+FActorSpawnParameters SpawnParameters;
+SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+for (int32 Index = 0; Index < NumCharacters; ++Index)
 {
-int32 CurrentLevel = CharacterData.GetLevelData().GetLevel();
+ACharacterModule* Character = World->SpawnActor<ACharacterModule>(SpawnParameters);
 
-return CharacterData.GetLevelData().GetExperienceThreshold()[CurrentLevel];
+if (Character && Character->GetCharacterManager())
+{
+Characters.Add(Character);
+}
 }
 
-int32 UCharacterManager::GetLevel()
+if (Characters.Num() < 2)
 {
-return CharacterData.GetLevelData().GetLevel();
+UE_LOG(LogTemp, Error, TEXT("AllocationCheck: Could not spawn characters."));
+return;
 }
 
-int32 UCharacterManager::GetMaxLevel()
+float Checksum = 0.f;
+
+// Each character regenerates every frame and attacks its neighbour every 10 frames, staggered.
+// Ability types cycle through Null so the invalid-type fallbacks run as well.
+const auto PlayFrame = [&Characters, &Checksum, DeltaTime](int32 Frame)
 {
-return CharacterData.GetLevelData().GetMaxLevel();
-}
+for (int32 Index = 0; Index < Characters.Num(); ++Index)
+{
+UCharacterManager* Manager = Characters[Index]->GetCharacterManager();
+ACharacterModule* Target = Characters[(Index + 1) % Characters.Num()];
+UCharacterManager* TargetManager = Target->GetCharacterManager();
 
-float UCharacterManager::GetExperienceRewardBonus()
+Manager->UpdatePrimaryAttributes(DeltaTime);
+
+if ((Frame + Index) % 10 != 0)
 {
-return CharacterData.GetLevelData().GetExperienceRewardBonus();
+continue;
 }
 
-void UCharacterManager::AddExperience(float Amount)
-{
-if(Amount <= 0.f)
+const ECharacterAbilityType AbilityType = static_cast<ECharacterAbilityType>((Frame / 10 + Index) % 4);
+const float Energy = Manager->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Energy);
+const float Cost = Manager->GetAbilityRandomCostByType(AbilityType);
+
+if (Energy >= Cost)
 {
-return;
+Manager->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Energy, Manager->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Energy),
+Manager->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Energy), Energy - Cost);
+Manager->ExecuteDamage(Target, Manager->GetAbilityRandomPowerByType(AbilityType), TargetManager->GetRandomFinalProtectionByType(EProtectionType()));
+Manager->AddExperience(25.f);
 }
 
-// Current level and max level
-int32 CurrentLevel = CharacterData.GetLevelData().GetLevel();
-const int32 MaxLevel = CharacterData.GetLevelData().GetMaxLevel();
+Checksum += Manager->GetPrimaryAttributeModuleByType(EPrimaryAttributeType::Null).GetCurrentValue();
+Checksum += Manager->GetSecondaryAttributeModuleByType(ESecondaryAttributeType::Null).GetCurrentValue();
+Checksum += Manager->GetCharacterAbilityModuleByType(ECharacterAbilityType::Null).GetRange();
+Checksum += Manager->GetCurrentAttributeValueByType(ECharacterAttributeType::Null);
+Checksum += Manager->GetNextLevelExperienceThreshold();
 
-// Current experience and experience thresholds
-float CurrentExperience = CharacterData.GetLevelData().GetExperience();
-const TArray<float>& ExperienceThresholds = CharacterData.GetLevelData().GetExperienceThreshold();
+// Heals instead of letting the target die, so the scenario runs unchanged to the end
+const float TargetMinHealth = TargetManager->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
+const float TargetMaxHealth = TargetManager->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health);
 
-// Validate experience thresholds
-if(!ExperienceThresholds.IsValidIndex(CurrentLevel))
+if (TargetManager->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health) < TargetMaxHealth * 0.5f)
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Error, TEXT("AddExperience: Experience thresholds not properly configured."));
-#endif
-return;
+TargetManager->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, TargetMinHealth, TargetMaxHealth, TargetMaxHealth);
+}
 }
 
-// Remaining experience to process
-float RemainingExperience = Amount;
+UCharacterManager::FlushReplicationDeltas(World, [&Checksum](UCharacterManager* DirtyManager, TArrayView<const uint8> Delta) { Checksum += Delta.Num(); });
+};
 
-// Loop to handle multiple level-ups if enough experience is provided
-while (RemainingExperience > 0.0f && CurrentLevel < MaxLevel)
-{
-const float RequiredXP = ExperienceThresholds[CurrentLevel];
-const float ExperienceToLevelUp = RequiredXP - CurrentExperience;	
+// The on-screen damage message allocates by design and is not part of the check.
+// Fallbacks log once per call site, normally during the warmup; a first log after it is reported like any other allocation.
+const int32 PreviousDamageMessages = CVarCharacterDamageMessages.GetValueOnGameThread();
+CVarCharacterDamageMessages->Set(0, ECVF_SetByCode);
 
-// Enough XP to level up 
-if (RemainingExperience >= ExperienceToLevelUp)
+// Lets containers reach their steady-state capacity
+for (int32 Frame = 0; Frame < NumWarmupFrames; ++Frame)
 {
-RemainingExperience -= ExperienceToLevelUp;
-CurrentExperience = 0.0f;
+PlayFrame(Frame);
+}
 
-LevelUp(); // single level increment
-CurrentLevel = CharacterData.GetLevelData().GetLevel();
+// Frame, allocations, bytes
+TArray<TTuple<int32, uint64, uint64>> AllocatingFrames;
+AllocatingFrames.Reserve(NumFrames);
 
-// Max level reached after level up 
-if (CurrentLevel >= MaxLevel)
+for (int32 Frame = NumWarmupFrames; Frame < NumWarmupFrames + NumFrames; ++Frame)
 {
-CurrentExperience = 0.0f;
-RemainingExperience = 0.0f;
-break;
-}
-}
-else
+CharacterBenchmarkMalloc.Start();
+PlayFrame(Frame);
+CharacterBenchmarkMalloc.Stop();
+
+if (CharacterBenchmarkMalloc.NumAllocations > 0)
 {
-// Not enough XP to level up, just add the remaining experience
-CurrentExperience += RemainingExperience;
-RemainingExperience = 0.0f;
+AllocatingFrames.Add(MakeTuple(Frame, CharacterBenchmarkMalloc.NumAllocations, CharacterBenchmarkMalloc.NumBytes));
 }
 }
+
+CVarCharacterDamageMessages->Set(PreviousDamageMessages, ECVF_SetByCode);
+
+for (ACharacterModule* Character : Characters)
+{
+Character->Destroy();
 }
 
-void UCharacterManager::LevelUp()
+for (int32 Index = 0; Index < FMath::Min(AllocatingFrames.Num(), 10); ++Index)
 {
-// Increment level by 1 if not at max level
-// Get current and max level
-int32 CurrentLevel = CharacterData.GetLevelData().GetLevel();
-int32 MaxLevel = CharacterData.GetLevelData().GetMaxLevel();
+UE_LOG(LogTemp, Warning, TEXT("AllocationCheck: Frame %d made %llu allocations, %llu bytes."),
+AllocatingFrames[Index].Get<0>(), AllocatingFrames[Index].Get<1>(), AllocatingFrames[Index].Get<2>());
+}
 
-// Level up if not at max level
-if (CurrentLevel < MaxLevel)
+if (AllocatingFrames.Num() > 0)
 {
-CharacterData.GetLevelData().SetLevel(CurrentLevel + 1);
+UE_LOG(LogTemp, Error, TEXT("AllocationCheck: FAILED, %d of %d frames allocated with %d characters."), AllocatingFrames.Num(), NumFrames, Characters.Num());
 }
 else
 {
-#if WITH_EDITOR
-UE_LOG(LogTemp, Warning, TEXT("LevelUp: Character has reached maximum level already."));
-#endif
-}
+UE_LOG(LogTemp, Log, TEXT("AllocationCheck: PASSED, %d frames with %d characters without allocations. Checksum %f"), NumFrames, Characters.Num(), Checksum);
 }
+})
+);
+#endif
 
 #pragma endregion
 
-#pragma region Movement 
+#pragma region BattleSimulator
 
-float UCharacterManager::GetWalkSpeed()
+int32 UCharacterBattleSimulatorCommandlet::Main(const FString& Params)
 {
-return CharacterData.GetMovementData().GetWalkSpeed();
-}
+int64 NumFights = 1000000;
+int32 TeamSizes[2] = { 1, 1 };
+int32 NumThreads = 0;
+int64 Seed = 1;
+FString ProtectionName;
 
-float UCharacterManager::GetDefaultSpeed()
-{
-return CharacterData.GetMovementData().GetDefaultSpeed();
-}
+CharacterSimulation::FBattleConfig Config;
 
-float UCharacterManager::GetMaximumSpeed()
-{
-return CharacterData.GetMovementData().GetMaxSpeed();
-}
+FParse::Value(*Params, TEXT("Fights="), NumFights);
+FParse::Value(*Params, TEXT("Team0="), TeamSizes[0]);
+FParse::Value(*Params, TEXT("Team1="), TeamSizes[1]);
+FParse::Value(*Params, TEXT("Threads="), NumThreads);
+FParse::Value(*Params, TEXT("Seed="), Seed);
+FParse::Value(*Params, TEXT("Duration="), Config.MaxDuration);
+FParse::Value(*Params, TEXT("Step="), Config.TimeStep);
+FParse::Value(*Params, TEXT("Protection="), ProtectionName);
 
-bool UCharacterManager::IsSprintEnabled()
+if (NumFights <= 0 || TeamSizes[0] <= 0 || TeamSizes[1] <= 0 || Config.TimeStep <= 0.f)
 {
-return CharacterData.GetMovementData().IsSprintEnabled();
+UE_LOG(LogTemp, Error, TEXT("CharacterBattleSimulator: Fights, team sizes and step must be positive."));
+return 1;
 }
 
-bool UCharacterManager::IsJumpEnabled()
-{
-return CharacterData.GetMovementData().IsJumpEnabled();
-}
+EProtectionType ProtectionType = EProtectionType();
 
-bool UCharacterManager::IsDoubleJumpEnabled()
+if (!ProtectionName.IsEmpty())
 {
-return CharacterData.GetMovementData().IsDoubleJumpEnabled();
-}
+const int64 ProtectionValue = StaticEnum<EProtectionType>()->GetValueByNameString(ProtectionName);
 
-int32 UCharacterManager::GetMaxJumpCount()
+if (ProtectionValue == INDEX_NONE)
 {
-return CharacterData.GetMovementData().GetMaxJumpCount();
+UE_LOG(LogTemp, Error, TEXT("CharacterBattleSimulator: Unknown protection type %s."), *ProtectionName);
+return 1;
 }
 
-float UCharacterManager::GetJumpHeight()
-{
-return CharacterData.GetMovementData().GetJumpHeight();
+ProtectionType = static_cast<EProtectionType>(ProtectionValue);
 }
 
-#pragma endregion
+// The defaults are what InitializeCombatStrikeAbility and friends produce
+UCharacterManager* Manager = NewObject<UCharacterManager>(GetTransientPackage());
 
-#pragma region Damage
+CharacterSimulation::FBattleFighter DefaultFighter;
+Manager->ExportSimulationCharacter(DefaultFighter.Character);
+DefaultFighter.Protection = Manager->ExportSimulationProtection(ProtectionType);
 
-void UCharacterManager::ExecuteDamage(ACharacterModule* TargetCharacter, float InstigatorDamage, float TargetProtection)
-{
-// Calculate final damage after applying protection
-float DamageAmount = InstigatorDamage;
-float ProtectionAmount = TargetProtection;
-float FinalDamage = FMath::Max(DamageAmount - ProtectionAmount, 0.0f);
+// Experience plays no part in a fight
+DefaultFighter.Character.Level.ExperienceThreshold.clear();
 
-// Get target's current health attributes
-float TargetHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeCurrentValueByType(EPrimaryAttributeType::Health);
-float TargetMinHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeMinimumValueByType(EPrimaryAttributeType::Health);
-float TargetMaxHealth = TargetCharacter->GetCharacterManager()->GetPrimaryAttributeMaximumValueByType(EPrimaryAttributeType::Health);
+// Same order as CharacterSimulation::EAbility
+const TCHAR* const AbilityNames[] = { TEXT("CombatStrike"), TEXT("LaserPulse"), TEXT("PlasmaShield") };
 
-// Apply damage to target's health
-float NewHealth = FMath::Clamp(TargetHealth - FinalDamage, TargetMinHealth, TargetMaxHealth);
-TargetCharacter->GetCharacterManager()->SetPrimaryAttributeValueByType(EPrimaryAttributeType::Health, TargetMinHealth, TargetMaxHealth, NewHealth);
+// Parses -TeamN.<Ability>.<Field>=Min,Max, keeps the range when the switch is absent
+const auto ParseRange = [&Params](const FString& Switch, float& InOutMin, float& InOutMax)
+{
+FString Value;
 
-if (GEngine)
+if (!FParse::Value(*Params, *Switch, Value, false))
 {
-// Debug message to show damage applied
-FString DebugMessage = FString::Printf(TEXT("Damage Applied: %.2f | Target Health: %.2f"), FinalDamage, NewHealth);
-GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, DebugMessage);
-}
+return true;
 }
 
-#pragma endregion
-
-#pragma region PrimaryAttribute
+FString MinText;
+FString MaxText;
 
-void UCharacterManager::ExecutePrimaryAttributeRegeneration(ACharacterModule* TargetCharacter, EPrimaryAttributeType Type, float Amount)
-{
-if (!TargetCharacter || Amount <= 0.f)
+if (!Value.Split(TEXT(","), &MinText, &MaxText) || !MinText.IsNumeric() || !MaxText.IsNumeric() || FCString::Atof(*MinText) > FCString::Atof(*MaxText))
 {
-return;
+UE_LOG(LogTemp, Error, TEXT("CharacterBattleSimulator: %s expects Min,Max with Min <= Max, got %s."), *Switch, *Value);
+return false;
 }
 
-RegenTarget = TargetCharacter;
-RegenType = Type;
-RemainingRegenAmount = Amount;
+InOutMin = FCString::Atof(*MinText);
+InOutMax = FCString::Atof(*MaxText);
+return true;
+};
 
-GetWorld()->GetTimerManager().SetTimer
-(
-PrimaryAttributeRegenerationTimerHandle,
-this,
-&UCharacterManager::HandleExecutePrimaryAttributeRegenerationHandler,
-0.1f,	// tick interval
-true    // looping
-);
-}
+for (int32 Team = 0; Team < 2; ++Team)
+{
+CharacterSimulation::FBattleFighter Fighter = DefaultFighter;
+Fighter.Team = Team;
 
-void UCharacterManager::HandleExecutePrimaryAttributeRegenerationHandler()
+for (int32 Index = 0; Index < UE_ARRAY_COUNT(AbilityNames); ++Index)
 {
-if (!RegenTarget || !RegenTarget->GetCharacterManager())
+CharacterSimulation::FAbility& Ability = Fighter.Character.GetAbility(static_cast<CharacterSimulation::EAbility>(Index));
+const FString Prefix = FString::Printf(TEXT("Team%d.%s."), Team, AbilityNames[Index]);
+
+// Only damage abilities are cast in a simulated fight, tuning any other one would silently change nothing
+if (!Ability.bDealsDamage)
 {
-GetWorld()->GetTimerManager().ClearTimer(PrimaryAttributeRegenerationTimerHandle);
-return;
-}
+FString Value;
 
-UCharacterManager* TargetManager = RegenTarget->GetCharacterManager();
+for (const TCHAR* Field : { TEXT("Power="), TEXT("Cost="), TEXT("Cooldown=") })
+{
+if (FParse::Value(*Params, *(Prefix + Field), Value, false))
+{
+UE_LOG(LogTemp, Error, TEXT("CharacterBattleSimulator: %s deals no damage and is not simulated, %s%s is not supported."), AbilityNames[Index], *Prefix, Field);
+Manager->MarkAsGarbage();
+return 1;
+}
+}
 
-float CurrentValue = TargetManager->GetPrimaryAttributeCurrentValueByType(RegenType);
-float MinValue = TargetManager->GetPrimaryAttributeMinimumValueByType(RegenType);
-float MaxValue = TargetManager->GetPrimaryAttributeMaximumValueByType(RegenType);
+continue;
+}
 
-if (RemainingRegenAmount <= 0.f || CurrentValue >= MaxValue)
+if (!ParseRange(Prefix + TEXT("Power="), Ability.PowerMin, Ability.PowerMax) ||
+!ParseRange(Prefix + TEXT("Cost="), Ability.CostMin, Ability.CostMax) ||
+!ParseRange(Prefix + TEXT("Cooldown="), Ability.CooldownTimeMin, Ability.CooldownTimeMax))
 {
-GetWorld()->GetTimerManager().ClearTimer(PrimaryAttributeRegenerationTimerHandle);
-return;
+Manager->MarkAsGarbage();
+return 1;
+}
 }
 
-float RegenPerTick = 1.f;
-
-// 
-float AppliedAmount = FMath::Min(RegenPerTick, FMath::Min(RemainingRegenAmount, MaxValue - CurrentValue));
-TargetManager->SetPrimaryAttributeValueByType(RegenType, MinValue, MaxValue, CurrentValue + AppliedAmount);
+Config.Fighters.insert(Config.Fighters.end(), TeamSizes[Team], Fighter);
+}
 
-RemainingRegenAmount -= AppliedAmount;
+Config.Seed = static_cast<uint64>(Seed);
 
+const CharacterSimulation::FBattleReport Report = CharacterSimulation::RunBattles(Config, static_cast<uint64>(NumFights), static_cast<uint32>(FMath::Max(0, NumThreads)));
 
-if (RemainingRegenAmount <= 0.f)
+const auto LogDistribution = [](const TCHAR* Name, const CharacterSimulation::FBattleDistribution& Distribution)
 {
-GetWorld()->GetTimerManager().ClearTimer(PrimaryAttributeRegenerationTimerHandle);
-return;
-}
+UE_LOG(LogTemp, Display, TEXT("%-10s mean %8.2f | min %8.2f | p5 %8.2f | p50 %8.2f | p95 %8.2f | max %8.2f"),
+Name, Distribution.Mean, Distribution.Min, Distribution.P5, Distribution.P50, Distribution.P95, Distribution.Max);
+};
+
+UE_LOG(LogTemp, Display, TEXT("CharacterBattleSimulator: %dv%d, %llu fights in %.2f s (%.0f fights/s)"),
+TeamSizes[0], TeamSizes[1], Report.NumFights, Report.Seconds, Report.FightsPerSecond);
+UE_LOG(LogTemp, Display, TEXT("Win rate   team 0 %.2f%% | team 1 %.2f%% | draws %.2f%%"),
+100.0 * Report.Wins[0] / Report.NumFights, 100.0 * Report.Wins[1] / Report.NumFights, 100.0 * Report.Draws / Report.NumFights);
+LogDistribution(TEXT("TTK (s)"), Report.TimeToKill);
+LogDistribution(TEXT("DPS team 0"), Report.TeamDps[0]);
+LogDistribution(TEXT("DPS team 1"), Report.TeamDps[1]);
+
+Manager->MarkAsGarbage();
+return 0;
 }
 
 #pragma endregion
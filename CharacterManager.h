@@ -23,7 +23,618 @@
 // Link: 
 // ============================================================================
 
+class FCharacterArchetypeArchive;
+class UCharacterManager;
+class UCharacterManagerRegistrySubsystem;
+struct FCharacterAbilityScoringInput;
 
+namespace CharacterSimulation
+{
+struct FCharacter;
+struct FProtection;
+}
+enum class ECharacterJournalEvent : uint8;
+
+#pragma region EventBus
+
+// Native event payloads. Subscribers receive them by const reference without parameter marshalling.
+struct FCharacterStateChangedEvent
+{
+UCharacterManager* Manager;
+ECharacterState NewState;
+};
+
+struct FCharacterTypeChangedEvent
+{
+UCharacterManager* Manager;
+ECharacterType NewType;
+};
+
+struct FCharacterTextChangedEvent
+{
+UCharacterManager* Manager;
+const FString& NewText;
+};
+
+struct FCharacterAttributeChangedEvent
+{
+UCharacterManager* Manager;
+ECharacterAttributeType AttributeType;
+float MinValue;
+float MaxValue;
+float CurrentValue;
+};
+
+struct FCharacterThresholdCrossedEvent
+{
+UCharacterManager* Manager;
+ECharacterAttributeType AttributeType;
+// Bands are numbered from 0 (below the first boundary) to the number of boundaries
+int32 PreviousBand;
+int32 NewBand;
+float CurrentValue;
+};
+
+// Identifies a subscription so it can be removed again
+struct FCharacterEventHandle
+{
+uint32 Id = 0;
+
+bool IsValid() const { return Id != 0; }
+};
+
+// Typed, allocation-free event channel for native listeners.
+// Handlers are plain function pointers with a context, so a broadcast is one indirect call per subscriber.
+// UObject subscribers are held weakly: a destroyed object is skipped by broadcasts and dropped on the next Subscribe.
+// Subscribing and unsubscribing from inside a handler is not supported.
+template <typename TEvent>
+class TCharacterEventChannel
+{
+public:
+typedef void (*FHandler)(void* Context, const TEvent& Event);
+typedef bool (*FFilter)(void* Context, const TEvent& Event);
+
+// Filter is an optional predicate that is evaluated before the handler
+FCharacterEventHandle Subscribe(void* Context, FHandler Handler, FFilter Filter = nullptr)
+{
+check(Handler && !bBroadcasting);
+
+// Subscriptions of destroyed objects are only pruned here, broadcasts merely skip them
+Subscribers.RemoveAll([](const FSubscriber& Subscriber) { return Subscriber.bTracked && !Subscriber.Object.IsValid(); });
+
+FCharacterEventHandle Handle;
+Handle.Id = ++LastId;
+
+Subscribers.Add({ Context, Handler, Filter, Handle.Id });
+return Handle;
+}
+
+// Preferred over the void* overload for UObject contexts, which it tracks weakly
+FCharacterEventHandle Subscribe(UObject* Object, FHandler Handler, FFilter Filter = nullptr)
+{
+const FCharacterEventHandle Handle = Subscribe(static_cast<void*>(Object), Handler, Filter);
+
+FSubscriber& Subscriber = Subscribers.Last();
+Subscriber.Object = Object;
+Subscriber.bTracked = true;
+return Handle;
+}
+
+// Subscribes a member function: Channel.Subscribe<UMyWidget, &UMyWidget::HandleEvent>(Widget)
+template <typename TObject, void (TObject::*Method)(const TEvent&)>
+FCharacterEventHandle Subscribe(TObject* Object, FFilter Filter = nullptr)
+{
+return Subscribe(Object, [](void* Context, const TEvent& Event) { (static_cast<TObject*>(Context)->*Method)(Event); }, Filter);
+}
+
+void Unsubscribe(FCharacterEventHandle& Handle)
+{
+check(!bBroadcasting);
+
+Subscribers.RemoveAll([&Handle](const FSubscriber& Subscriber) { return Subscriber.Id == Handle.Id; });
+Handle.Id = 0;
+}
+
+// Removes every subscription made with the given context
+void UnsubscribeAll(const void* Context)
+{
+check(!bBroadcasting);
+
+Subscribers.RemoveAll([Context](const FSubscriber& Subscriber) { return Subscriber.Context == Context; });
+}
+
+// Removes every subscription not made with the given context, e.g. all external listeners of a pooled manager
+void UnsubscribeAllExcept(const void* Context)
+{
+check(!bBroadcasting);
+
+Subscribers.RemoveAll([Context](const FSubscriber& Subscriber) { return Subscriber.Context != Context; });
+}
+
+void Broadcast(const TEvent& Event) const
+{
+TGuardValue<bool> BroadcastGuard(bBroadcasting, true);
+
+for (const FSubscriber& Subscriber : Subscribers)
+{
+if (Subscriber.bTracked && !Subscriber.Object.IsValid())
+{
+continue;
+}
+
+if (!Subscriber.Filter || Subscriber.Filter(Subscriber.Context, Event))
+{
+Subscriber.Handler(Subscriber.Context, Event);
+}
+}
+}
+
+int32 Num() const { return Subscribers.Num(); }
+
+// Heap bytes of the subscriber list
+SIZE_T GetAllocatedSize() const { return Subscribers.GetAllocatedSize(); }
+
+private:
+struct FSubscriber
+{
+void* Context;
+FHandler Handler;
+FFilter Filter;
+uint32 Id;
+
+// Set for UObject contexts
+FWeakObjectPtr Object;
+bool bTracked = false;
+};
+
+TArray<FSubscriber, TInlineAllocator<4>> Subscribers;
+uint32 LastId = 0;
+mutable bool bBroadcasting = false;
+};
+
+#pragma endregion
+
+#pragma region DebugLog
+
+// Rate-limited, sampled debug log into an in-memory ring buffer.
+// Use through CHARACTER_DEBUG_LOG; arguments are only evaluated and formatted for messages that are kept.
+class NERBY_API FCharacterDebugLog
+{
+public:
+static constexpr int32 MaxMessageLength = 128;
+
+// Token bucket shared by every call site with the same context
+struct FBucket
+{
+FName Context;
+
+// Cycle at which the bucket is full again (GCRA form of a token bucket)
+std::atomic<uint64> TheoreticalArrival = 0;
+std::atomic<uint32> NumDropped = 0;
+};
+
+// Per call site, resolves its bucket once
+struct FSite
+{
+explicit FSite(const TCHAR* Context) : Bucket(FindOrAddBucket(Context)) {}
+
+FBucket& Bucket;
+};
+
+// Enabled, character sampled and a token available
+static bool ShouldEmit(FSite& Site, uint32 CharacterId);
+
+// Stores a formatted message and echoes it to the log when CharacterManager.DebugLog.Echo is set
+static void Emit(const FSite& Site, uint32 CharacterId, const TCHAR* Message);
+
+// Writes the newest messages, oldest first, and the number of dropped messages per context
+static void Dump(FOutputDevice& Output, int32 MaxEntries = TNumericLimits<int32>::Max());
+
+private:
+static FBucket& FindOrAddBucket(const TCHAR* Context);
+};
+
+#define CHARACTER_DEBUG_LOG(CharacterId, Context, Format, ...) \
+do \
+{ \
+static FCharacterDebugLog::FSite CharacterDebugLogSite(TEXT(Context)); \
+const uint32 CharacterDebugLogId = (CharacterId); \
+if (FCharacterDebugLog::ShouldEmit(CharacterDebugLogSite, CharacterDebugLogId)) \
+{ \
+TCHAR CharacterDebugLogMessage[FCharacterDebugLog::MaxMessageLength]; \
+FCString::Snprintf(CharacterDebugLogMessage, FCharacterDebugLog::MaxMessageLength, Format, ##__VA_ARGS__); \
+FCharacterDebugLog::Emit(CharacterDebugLogSite, CharacterDebugLogId, CharacterDebugLogMessage); \
+} \
+} \
+while (0)
+
+// Logs only the first time the call site is reached, for fallbacks on hot paths such as invalid-type getters
+#define CHARACTER_LOG_ONCE(Verbosity, Format, ...) \
+do \
+{ \
+static std::atomic<bool> bCharacterLogOnceDone(false); \
+if (!bCharacterLogOnceDone.load(std::memory_order_relaxed) && !bCharacterLogOnceDone.exchange(true, std::memory_order_relaxed)) \
+{ \
+UE_LOG(LogTemp, Verbosity, Format, ##__VA_ARGS__); \
+} \
+} \
+while (0)
+
+#pragma endregion
+
+#pragma region PublishedState
+
+// Hot state of a character as seen by other threads, published once per frame
+struct FCharacterPublishedState
+{
+static constexpr int32 NumPrimaryAttributes = static_cast<int32>(EPrimaryAttributeType::Max) - 1;
+
+// GFrameCounter at publish time, 0 if nothing was published yet
+uint64 Frame = 0;
+
+ECharacterState State = ECharacterState::Idle;
+ECharacterType Type = ECharacterType::Null;
+int32 Level = 0;
+
+float CurrentValues[NumPrimaryAttributes] = {};
+float MaximumValues[NumPrimaryAttributes] = {};
+
+float GetCurrentValue(EPrimaryAttributeType AttributeType) const
+{
+const int32 Index = static_cast<int32>(AttributeType) - 1;
+return Index >= 0 && Index < NumPrimaryAttributes ? CurrentValues[Index] : 0.f;
+}
+
+float GetMaximumValue(EPrimaryAttributeType AttributeType) const
+{
+const int32 Index = static_cast<int32>(AttributeType) - 1;
+return Index >= 0 && Index < NumPrimaryAttributes ? MaximumValues[Index] : 0.f;
+}
+
+bool IsDead() const { return State == ECharacterState::Death; }
+};
+
+// Single-writer sequence lock for small trivially copyable values.
+// The writer never blocks; readers copy the value and retry if a write overlapped the copy.
+// The value is stored as relaxed atomic words, so concurrent reads are free of data races.
+template <typename T>
+class TCharacterSeqLock
+{
+static_assert(std::is_trivially_copyable_v<T>, "TCharacterSeqLock requires a trivially copyable type");
+
+static constexpr int32 NumWords = (sizeof(T) + sizeof(uint32) - 1) / sizeof(uint32);
+
+public:
+TCharacterSeqLock()
+{
+for (std::atomic<uint32>& Word : Words)
+{
+Word.store(0, std::memory_order_relaxed);
+}
+}
+
+// Only one thread may write
+void Write(const T& Value)
+{
+uint32 Buffer[NumWords] = {};
+FMemory::Memcpy(Buffer, &Value, sizeof(T));
+
+const uint32 Start = Sequence.load(std::memory_order_relaxed);
+Sequence.store(Start + 1, std::memory_order_relaxed);
+std::atomic_thread_fence(std::memory_order_release);
+
+for (int32 Index = 0; Index < NumWords; ++Index)
+{
+Words[Index].store(Buffer[Index], std::memory_order_relaxed);
+}
+
+Sequence.store(Start + 2, std::memory_order_release);
+}
+
+// Safe from any thread
+T Read() const
+{
+uint32 Buffer[NumWords];
+uint32 Start = 0;
+
+do
+{
+Start = Sequence.load(std::memory_order_acquire);
+
+for (int32 Index = 0; Index < NumWords; ++Index)
+{
+Buffer[Index] = Words[Index].load(std::memory_order_relaxed);
+}
+
+std::atomic_thread_fence(std::memory_order_acquire);
+}
+while ((Start & 1) != 0 || Start != Sequence.load(std::memory_order_relaxed));
+
+T Value;
+FMemory::Memcpy(&Value, Buffer, sizeof(T));
+return Value;
+}
+
+private:
+std::atomic<uint32> Sequence = 0;
+std::atomic<uint32> Words[NumWords];
+};
+
+#pragma endregion
+
+#pragma region HudSnapshot
+
+USTRUCT(BlueprintType)
+struct FCharacterHudAttribute
+{
+GENERATED_BODY()
+
+UPROPERTY(BlueprintReadOnly, Category = "Attribute")
+float MinValue = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Attribute")
+float MaxValue = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Attribute")
+float CurrentValue = 0.f;
+
+bool operator==(const FCharacterHudAttribute& Other) const
+{
+return MinValue == Other.MinValue && MaxValue == Other.MaxValue && CurrentValue == Other.CurrentValue;
+}
+
+bool operator!=(const FCharacterHudAttribute& Other) const
+{
+return !(*this == Other);
+}
+};
+
+// Everything a character HUD draws, published once per frame.
+// Widgets poll it and skip the redraw while Version is unchanged.
+USTRUCT(BlueprintType)
+struct FCharacterHudSnapshot
+{
+GENERATED_BODY()
+
+// Incremented whenever any other field changes
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+int32 Version = 0;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+ECharacterState State = ECharacterState::Idle;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+int32 Level = 0;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+float Experience = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Health;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Stamina;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Energy;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Shield;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Output;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Actuation;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Integrity;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Capacity;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+FCharacterHudAttribute Regeneration;
+
+// Remaining cooldown time in seconds
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+float CombatStrikeCooldown = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+float LaserPulseCooldown = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "HUD")
+float PlasmaShieldCooldown = 0.f;
+
+FCharacterHudAttribute* FindAttribute(ECharacterAttributeType AttributeType)
+{
+switch (AttributeType)
+{
+case ECharacterAttributeType::Health:
+return &Health;
+case ECharacterAttributeType::Stamina:
+return &Stamina;
+case ECharacterAttributeType::Energy:
+return &Energy;
+case ECharacterAttributeType::Shield:
+return &Shield;
+case ECharacterAttributeType::Output:
+return &Output;
+case ECharacterAttributeType::Actuation:
+return &Actuation;
+case ECharacterAttributeType::Integrity:
+return &Integrity;
+case ECharacterAttributeType::Capacity:
+return &Capacity;
+case ECharacterAttributeType::Regeneration:
+return &Regeneration;
+default:
+return nullptr;
+}
+}
+
+const FCharacterHudAttribute* FindAttribute(ECharacterAttributeType AttributeType) const
+{
+return const_cast<FCharacterHudSnapshot*>(this)->FindAttribute(AttributeType);
+}
+
+// Compares every field except Version
+bool HasSameContent(const FCharacterHudSnapshot& Other) const
+{
+return
+State == Other.State &&
+Level == Other.Level &&
+Experience == Other.Experience &&
+Health == Other.Health &&
+Stamina == Other.Stamina &&
+Energy == Other.Energy &&
+Shield == Other.Shield &&
+Output == Other.Output &&
+Actuation == Other.Actuation &&
+Integrity == Other.Integrity &&
+Capacity == Other.Capacity &&
+Regeneration == Other.Regeneration &&
+CombatStrikeCooldown == Other.CombatStrikeCooldown &&
+LaserPulseCooldown == Other.LaserPulseCooldown &&
+PlasmaShieldCooldown == Other.PlasmaShieldCooldown;
+}
+};
+
+#pragma endregion
+
+#pragma region MovementParameters
+
+// Movement parameters as last pushed to the owner's movement component, speeds scaled by Actuation.
+// Consumers that poll keep the Version they applied and skip frames where it is unchanged.
+USTRUCT(BlueprintType)
+struct FCharacterMovementParameters
+{
+GENERATED_BODY()
+
+// Incremented whenever any other field changes
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+int32 Version = 0;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+float WalkSpeed = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+float DefaultSpeed = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+float MaxSpeed = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+float JumpHeight = 0.f;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+int32 MaxJumpCount = 0;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+bool bEnableSprint = false;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+bool bEnableJump = false;
+
+UPROPERTY(BlueprintReadOnly, Category = "Movement")
+bool bEnableDoubleJump = false;
+
+// Compares every field except Version
+bool HasSameContent(const FCharacterMovementParameters& Other) const
+{
+return
+WalkSpeed == Other.WalkSpeed &&
+DefaultSpeed == Other.DefaultSpeed &&
+MaxSpeed == Other.MaxSpeed &&
+JumpHeight == Other.JumpHeight &&
+MaxJumpCount == Other.MaxJumpCount &&
+bEnableSprint == Other.bEnableSprint &&
+bEnableJump == Other.bEnableJump &&
+bEnableDoubleJump == Other.bEnableDoubleJump;
+}
+};
+
+#pragma endregion
+
+#pragma region AbilityScoring
+
+// One AI decision: which ability Caster should use on Target
+struct FCharacterAbilityQuery
+{
+UCharacterManager* Caster = nullptr;
+UCharacterManager* Target = nullptr;
+
+// Protection of the target that the caster's damage is weighed against
+EProtectionType TargetProtectionType = EProtectionType();
+};
+
+struct FCharacterAbilityScore
+{
+ECharacterAbilityType AbilityType = ECharacterAbilityType::Null;
+
+// Value per second of cooldown, 0 when the ability cannot be used now.
+// Damage abilities count expected damage, defense abilities the caster's missing health.
+float Score = 0.f;
+
+// Mean power minus the target's mean protection, capped at the target's remaining health
+float ExpectedDamage = 0.f;
+
+bool bAffordable = false;
+bool bInRange = false;
+bool bReady = false;
+
+bool IsUsable() const { return bAffordable && bInRange && bReady; }
+};
+
+struct FCharacterAbilityChoice
+{
+static constexpr int32 NumAbilities = 3;
+
+// Best first
+FCharacterAbilityScore Abilities[NumAbilities];
+
+const FCharacterAbilityScore& GetBest() const { return Abilities[0]; }
+bool HasUsableAbility() const { return Abilities[0].Score > 0.f; }
+};
+
+#pragma endregion
+
+#pragma region MemoryReport
+
+// Memory of one character split by section. The character data is held out of line, so its sections are
+// heap bytes; only compact attributes and the component itself are inline. Sections served by an archetype
+// are counted in SharedHeapBytes because every character of the archetype pays them only once.
+struct FCharacterMemoryUsage
+{
+enum ESection : uint8
+{
+Information,
+Attribute,
+Ability,
+Protection,
+Level,
+Movement,
+// The component outside the character data, with rollback history and subscriptions
+Manager,
+NumSections
+};
+
+SIZE_T InlineBytes[NumSections] = {};
+SIZE_T HeapBytes[NumSections] = {};
+SIZE_T SharedHeapBytes = 0;
+
+static const TCHAR* GetSectionName(int32 Section);
+
+SIZE_T GetInlineBytes() const;
+SIZE_T GetHeapBytes() const;
+
+// Inline and owned heap bytes, without the shared bytes
+SIZE_T GetOwnedBytes() const { return GetInlineBytes() + GetHeapBytes(); }
+
+FCharacterMemoryUsage& operator+=(const FCharacterMemoryUsage& Other);
+};
+
+#pragma endregion
 
 UCLASS(BlueprintType)
 class NERBY_API UCharacterManager : public UActorComponent
@@ -101,10 +712,28 @@ FOnLaserPulseExecutedSignature OnLaserPulseExecuted;
 UPROPERTY(BlueprintAssignable, Category = "Level")
 FOnPlasmaShieldExecutedSignature OnPlasmaShieldExecuted;
 
+/*Native*/
+// Native event channels. Prefer these over the Blueprint delegates for C++ listeners on hot paths.
+TCharacterEventChannel<FCharacterStateChangedEvent> StateChangedEvents;
+TCharacterEventChannel<FCharacterTypeChangedEvent> TypeChangedEvents;
+TCharacterEventChannel<FCharacterTextChangedEvent> TitleChangedEvents;
+TCharacterEventChannel<FCharacterTextChangedEvent> DescriptionChangedEvents;
+TCharacterEventChannel<FCharacterAttributeChangedEvent> AttributeChangedEvents;
+
+// Bridges events to the Blueprint delegates above. Off by default, enable on characters bound in Blueprint.
+UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Delegate")
+bool bBroadcastBlueprintDelegates = false;
+
 private:
 // Setup delegates
 void SetupDelegates();
 
+// Send an event to the native channel and, if bridged, the Blueprint delegate
+void BroadcastStateChanged(ECharacterState NewState);
+void BroadcastTypeChanged(ECharacterType NewType);
+void BroadcastTitleChanged(const FString& NewTitle);
+void BroadcastDescriptionChanged(const FString& NewDescription);
+
 // Bind character state changed delegate
 UFUNCTION()
 void BindOnCharacterStateChanged(ECharacterState NewCharacterState);
@@ -153,6 +782,18 @@ public:
 // Constructor 
 UCharacterManager();
 
+// Sets up compact attributes over the initialized character data
+virtual void PostInitProperties() override;
+
+// Migrates inline character data of old packages and sets up compact attributes again,
+// loading may have reallocated the character data
+virtual void PostLoad() override;
+
+#if WITH_EDITOR
+// Keeps compact attributes in step with bUseCompactAttributes when it is edited
+virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 #pragma endregion
 
 #pragma region BeginPlay
@@ -163,19 +804,36 @@ virtual void BeginPlay() override;
 
 #pragma endregion
 
-#pragma region Tick 
+#pragma region Registration
+
+public:
+// Managers that are currently registered with World, empty for a null world or one without the registry
+static const TArray<UCharacterManager*>& GetRegisteredManagers(const UWorld* World);
 
 protected:
-// Called every frame
-void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+// Called when the component is registered
+virtual void OnRegister() override;
+
+// Called when the component is unregistered
+virtual void OnUnregister() override;
+
+// Called before the component is destroyed
+virtual void BeginDestroy() override;
+
+private:
+void RemoveFromRegistry();
+
+// Registry of the world this manager registered with, and the manager's index in it
+TWeakObjectPtr<UCharacterManagerRegistrySubsystem> Registry;
+int32 RegisteredIndex = INDEX_NONE;
 
 #pragma endregion
 
-#pragma region Debug
+#pragma region Tick 
 
 protected:
-// Debug Tick
-void DebugTick(FCharacterDebugData& Debug, const FString& Context, const FString& Message);
+// Called every frame
+void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 #pragma endregion
 
@@ -197,6 +855,7 @@ return OwnerCharacter;
 void SetOwnerCharacter(ACharacterModule* NewOwner)
 {
 OwnerCharacter = NewOwner;
+bMovementParametersDirty = true;
 }
 
 #pragma endregion
@@ -204,9 +863,17 @@ OwnerCharacter = NewOwner;
 #pragma region CharacterData
 
 protected:
-// Character data 
-UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Data")
-FCharacterData CharacterData;
+// Character data, held out of line. Characters spawned from an archetype leave it unallocated
+// until they override a section, see SpawnFromArchetype. Accessed through ReadCharacterData,
+// WriteCharacterData and AllocateCharacterData only.
+UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Data", meta = (ShowOnlyInnerProperties))
+TInstancedStruct<FCharacterData> CharacterDataStorage;
+
+#if WITH_EDITORONLY_DATA
+// Inline character data of packages saved before it moved out of line, copied into CharacterDataStorage on load
+UPROPERTY()
+FCharacterData CharacterData_DEPRECATED;
+#endif
 
 public:
 // Returns a COPY of the character data (read-only, safe).
@@ -214,28 +881,39 @@ public:
 UFUNCTION(BlueprintCallable, Category = "Data")
 FCharacterData& GetCharacterData()
 {
-return CharacterData;
+MaterializeArchetype();
+SyncCompactAttributesToCharacterData();
+return AllocateCharacterData();
 }
 
 // Returns a read-only reference to the character data.
 FCharacterData GetCharacterDataReadOnly() const
 {
-return CharacterData;
+return ComposeCharacterData();
 }
 
 // Returns a mutable reference to the character data.
 // WARNING: Caller must ensure CharacterData is valid.
 FCharacterData& GetMutableCharacterData()
 {
-return CharacterData;
+MaterializeArchetype();
+SyncCompactAttributesToCharacterData();
+return AllocateCharacterData();
 }
 
 // Returns the raw pointer to the character data.
-FCharacterData* GetCharacterDataPtr() const
+FCharacterData* GetCharacterDataPtr()
 {
-FCharacterData* CharacterDataPtr = const_cast<FCharacterData*>(&CharacterData);
+MaterializeArchetype();
+SyncCompactAttributesToCharacterData();
+return &AllocateCharacterData();
+}
 
-return CharacterDataPtr;
+// Returns the raw pointer to the data holding the character's sections. Characters spawned from an archetype
+// return the archetype until they are materialized, GetCharacterDataReadOnly includes their overrides.
+const FCharacterData* GetCharacterDataPtr() const
+{
+return &ReadCharacterData(ECharacterDataSection::All);
 }
 
 // Sets character data by copying into an existing pointer.
@@ -243,9 +921,107 @@ return CharacterDataPtr;
 UFUNCTION(BlueprintCallable, Category = "Data")
 void SetCharacterData(const FCharacterData& NewData)
 {
-CharacterData = NewData;
+AllocateCharacterData() = NewData;
+DetachArchetype();
+}
+
+// Writes a compact binary snapshot of the character data into OutBuffer.
+// Returns the number of bytes written.
+UFUNCTION(BlueprintCallable, Category = "Data")
+int32 SaveCharacterSnapshot(TArray<uint8>& OutBuffer);
+
+// Restores the character data in place from a binary snapshot.
+// Does not broadcast change delegates.
+UFUNCTION(BlueprintCallable, Category = "Data")
+bool LoadCharacterSnapshot(const TArray<uint8>& Buffer);
+
+// Initializes the character data by copying an archetype out of a mapped archive.
+// Does not broadcast change delegates.
+bool InitializeFromArchetype(const FCharacterArchetypeArchive& Archive, uint32 ArchetypeKey);
+
+#pragma endregion
+
+#pragma region Archetype
+
+public:
+// Shares read-mostly sections with a prototype instead of copying them.
+// Only state, type and compact attribute values are stored inline, overridden sections are
+// copied out of line on first write.
+void SpawnFromArchetype(const FCharacterArchetypePtr& InArchetype);
+
+const FCharacterArchetypePtr& GetCharacterArchetype() const { return Archetype; }
+
+// Sections that were copied out of the archetype on first write
+ECharacterDataSection GetOwnedSections() const { return OwnedSections; }
+
+// Copies every shared section and the hot state into CharacterDataStorage and detaches the archetype
+void MaterializeArchetype();
+
+private:
+// Returns the data that currently holds the given section, the class defaults while nothing is allocated
+const FCharacterData& ReadCharacterData(ECharacterDataSection Section) const
+{
+if (Archetype.IsValid() && !EnumHasAllFlags(OwnedSections, Section))
+{
+return *Archetype;
+}
+
+return CharacterDataStorage.IsValid() ? CharacterDataStorage.Get() : GetClass()->GetDefaultObject<UCharacterManager>()->CharacterDataStorage.Get();
 }
 
+// Copies the given sections out of the archetype before they are modified
+FCharacterData& WriteCharacterData(ECharacterDataSection Section);
+
+// Allocates CharacterDataStorage if an archetype spawn has not overridden anything yet
+FCharacterData& AllocateCharacterData();
+
+// Builds a full copy with shared sections and compact attributes expanded
+FCharacterData ComposeCharacterData() const;
+
+// Composes the hot state, the given sections and the compact attributes into an existing copy
+void ComposeCharacterData(FCharacterData& OutData, ECharacterDataSection Sections) const;
+
+void DetachArchetype();
+
+// State and type live in CharacterData unless the character is spawned from an archetype
+ECharacterState GetStoredCharacterState() const { return Archetype.IsValid() ? InstanceState : ReadCharacterData(ECharacterDataSection::None).GetCharacterState(); }
+ECharacterType GetStoredCharacterType() const { return Archetype.IsValid() ? InstanceType : ReadCharacterData(ECharacterDataSection::None).GetCharacterType(); }
+void SetStoredCharacterState(ECharacterState NewState);
+void SetStoredCharacterType(ECharacterType NewType);
+
+FCharacterArchetypePtr Archetype;
+ECharacterDataSection OwnedSections = ECharacterDataSection::None;
+
+// Hot state of a character spawned from an archetype
+ECharacterState InstanceState = ECharacterState::Idle;
+ECharacterType InstanceType = ECharacterType::Null;
+
+#pragma endregion
+
+#pragma region MemoryReport
+
+public:
+// Inline size and heap bytes of this character. Referenced objects such as montages are not owned and not counted.
+FCharacterMemoryUsage GetMemoryUsage() const;
+
+// Writes the usage of every manager registered with World, per archetype and in total.
+// Archetypes whose characters cost more than their budget on average are reported as warnings. ArchetypeBudgets
+// is keyed by archetype title; other archetypes use BudgetBytes, 0 disables the check.
+static void DumpMemoryReport(const UWorld* World, FOutputDevice& Output, SIZE_T BudgetBytes = 0, const TMap<FString, SIZE_T>& ArchetypeBudgets = TMap<FString, SIZE_T>());
+
+#pragma endregion
+
+#pragma region Pooling
+
+public:
+// Detaches the manager from its owner so it can be reused after death: stops regeneration, drops
+// pending deltas and external native and threshold subscribers. The character data and archetype stay
+// until Reinitialize replaces them. Delegates bound in SetupDelegates stay bound and no memory is reallocated.
+void ResetForPool();
+
+// Prepares a pooled manager for a new owner. A null archetype restores the class defaults into the existing buffers.
+void Reinitialize(ACharacterModule* NewOwner, const FCharacterArchetypePtr& InArchetype);
+
 #pragma endregion
 
 #pragma region CharacterState
@@ -376,6 +1152,13 @@ bool HasPrimaryAttributeValue(EPrimaryAttributeType AttributeType);
 UFUNCTION(BlueprintCallable, Category = "Attribute")
 bool HasSecondaryAttributeValue(ESecondaryAttributeType AttributeType);
 
+private:
+// Broadcasts the changed delegate of an attribute with its current values
+void BroadcastAttributeChanged(ECharacterAttributeType AttributeType);
+void BroadcastAttributeChanged(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+public:
+
 
 /*Update*/
 // Update Primary Attribute Current Value By Type
@@ -386,6 +1169,51 @@ void UpdatePrimaryAttributeCurrentValueByType(EPrimaryAttributeType AttributeTyp
 // Update Primary Attributes (Called every tick)
 void UpdatePrimaryAttributes(float DeltaTime);
 
+// Counts down the cooldown timers of abilities that are on cooldown
+void UpdateAbilityCooldowns(float DeltaTime);
+
+bool IsAnyAbilityOnCooldown() const;
+
+/*Compact Storage*/
+// Stores attribute current values as 16-bit fixed point. Ranges and rates are shared with the class defaults
+// while they match, otherwise they are read from the character's own attributes.
+void EnableCompactAttributes();
+
+// Stores attribute current values as 16-bit fixed point and shares ranges and rates with an archetype.
+// The archetype must outlive this component. Intended for background crowd characters.
+void EnableCompactAttributes(const FCharacterAttribute& InArchetype);
+
+// Expands the compact attributes back into the character data
+void DisableCompactAttributes();
+
+// Checks if compact attribute storage is active
+bool IsUsingCompactAttributes() const { return bUseCompactAttributes; }
+
+protected:
+// Opt-in compact attribute storage, enabled once the properties are initialized. All attribute accessors keep working transparently.
+UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attribute")
+bool bUseCompactAttributes = false;
+
+private:
+// Compact attribute storage, valid while bUseCompactAttributes is set.
+// Current values are not written back to CharacterData until it is handed out or serialized.
+FCompactCharacterAttribute CompactAttributeData;
+
+// Checks the update flag of an attribute, honouring compact storage
+bool IsAttributeUpdateEnabled(ECharacterAttributeType AttributeType);
+
+// Attributes that hold the ranges and regeneration rates, honouring compact storage
+const FCharacterAttribute& ReadAttributeData() const;
+
+// Writes an attribute in compact storage
+void WriteCompactAttributeValue(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+// Expands compact attributes into CharacterData before it is serialized
+void SyncCompactAttributesToCharacterData();
+
+// Reloads compact attributes after CharacterData was written wholesale
+void SyncCompactAttributesFromCharacterData();
+
 #pragma endregion
 
 #pragma region Ability 
@@ -448,6 +1276,31 @@ float GetAmplifierByType(EProtectionType Type);
 UFUNCTION(BlueprintCallable, Category = "Protection")
 float GetRandomFinalProtectionByType(EProtectionType Type);
 
+// Protection roll against a damage type from the resistance matrix, one lookup and one multiply-add.
+// A damage type is resisted by the protection type of the same name, types without a match are not resisted.
+UFUNCTION(BlueprintCallable, Category = "Protection")
+float GetRandomProtectionAgainst(EDamageType DamageType);
+
+// The matrix is rebuilt on the next lookup. Writes through the data accessors mark it automatically;
+// call this after changing protection through a reference kept from GetCharacterData.
+void MarkResistanceMatrixDirty() { bResistanceMatrixDirty = true; }
+
+private:
+// A roll lies in [Base, Base + Spread], that is [Value * Multiplier, Value * Multiplier * Amplifier]
+struct FResistance
+{
+float Base = 0.f;
+float Spread = 0.f;
+};
+
+static constexpr int32 MaxDamageTypes = 16;
+
+void RebuildResistanceMatrix();
+
+// Indexed by EDamageType
+FResistance ResistanceMatrix[MaxDamageTypes];
+bool bResistanceMatrixDirty = true;
+
 #pragma endregion
 
 #pragma region Level
@@ -522,6 +1375,17 @@ public:
 UFUNCTION(BlueprintCallable, Category = "Damage")
 void ExecuteDamage(ACharacterModule* TargetCharacter, float InstigatorDamage, float TargetProtection);
 
+// Resolves the target's protection against the damage type from its resistance matrix
+UFUNCTION(BlueprintCallable, Category = "Damage")
+void ExecuteDamageByType(ACharacterModule* TargetCharacter, float InstigatorDamage, EDamageType DamageType);
+
+// Protection of every target against its damage type in one pass over the targets' resistance matrices.
+// Invalid targets get 0. All views must have the same length.
+static void RollProtectionBatch(TArrayView<ACharacterModule* const> Targets, TArrayView<const EDamageType> DamageTypes, TArrayView<float> OutProtection);
+
+// One hit per target, e.g. for area damage, with protection from RollProtectionBatch
+void ExecuteDamageBatch(TArrayView<ACharacterModule* const> Targets, TArrayView<const float> Damages, TArrayView<const EDamageType> DamageTypes);
+
 #pragma endregion
 
 #pragma region PrimaryAttribute
@@ -543,6 +1407,562 @@ float RemainingRegenAmount = 0.f;
 UFUNCTION()
 void HandleExecutePrimaryAttributeRegenerationHandler();
 
+// Clears the regeneration timer and keeps the active timer count in sync
+void StopPrimaryAttributeRegeneration();
+
+#pragma endregion
+
+#pragma region Replication
+
+public:
+// Quantization used when encoding replication deltas
+UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+FCharacterDeltaQuantization DeltaQuantization;
+
+// Returns the fields changed since the last delta was written
+uint32 GetReplicationDirtyMask() const { return ReplicationDirtyMask; }
+
+// Marks every field dirty, e.g. for a new connection that needs the full state
+void MarkFullReplicationDirty();
+
+// Appends a delta of the changed fields to OutBuffer and clears the dirty mask.
+// Returns the number of bytes appended, or zero if nothing changed.
+int32 WriteReplicationDelta(TArray<uint8>& OutBuffer);
+
+// Applies a received delta and broadcasts the affected delegates
+bool ApplyReplicationDelta(TArrayView<const uint8> Buffer);
+
+// Push-model flush: visits only the managers of World that changed since the last flush.
+// A null World flushes the managers that are not part of any world.
+static void FlushReplicationDeltas(const UWorld* World, TFunctionRef<void(UCharacterManager* Manager, TArrayView<const uint8> Delta)> Visitor);
+
+private:
+// Marks fields dirty and queues this manager for the next flush
+void MarkReplicationDirty(uint32 Flags);
+
+// Marks the range and/or current value of an attribute dirty if the new values differ
+void MarkAttributeReplicationDirty(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+// Returns the dirty flags an attribute write would set, without queueing the manager
+uint32 GetAttributeReplicationFlags(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+// Drops this manager from the pending flush of its world
+void RemoveFromReplicationQueue();
+
+// Decodes a delta into scratch data and applies it only on success, copying only the archetype sections it changes
+bool ApplyDecodedReplicationDelta(TArrayView<const uint8> Buffer, uint32& OutAppliedMask);
+
+uint32 ReplicationDirtyMask = CharacterDirtyFlags::None;
+bool bQueuedForReplication = false;
+
+// World whose pending list this manager was queued in
+TObjectKey<UWorld> ReplicationQueueWorld;
+
+// Managers with a pending delta, per world
+static TMap<TObjectKey<UWorld>, TArray<UCharacterManager*>> PendingReplicationManagers;
+
+#pragma endregion
+
+#pragma region Rollback
+
+public:
+// Number of frames kept for rollback. Rounded up to a power of two, 0 disables saving.
+UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rollback")
+int32 RollbackFrames = 0;
+
+// Saves state, primary attributes, cooldowns and level progress for a frame, overwriting the oldest slot
+void SaveRollbackFrame(int32 Frame);
+
+// Restores a saved frame. Returns false if the frame was never saved or was overwritten.
+// Does not broadcast change delegates or mark replication dirty.
+bool RestoreRollbackFrame(int32 Frame);
+
+// Saves every manager registered with World in a single pass
+static void SaveRollbackFrameForAll(const UWorld* World, int32 Frame);
+
+// Restores every manager registered with World in a single pass. Returns the number of managers restored.
+static int32 RestoreRollbackFrameForAll(const UWorld* World, int32 Frame);
+
+private:
+TArray<FCharacterRollbackState> RollbackHistory;
+
+#pragma endregion
+
+#pragma region Journal
+
+private:
+// Appends a mutation to the journal if it is recording
+void JournalMutation(ECharacterJournalEvent Event, uint8 SubType, float Value0, float Value1 = 0.f, float Value2 = 0.f, const UCharacterManager* Instigator = nullptr);
+
+// Journals the stored range and current value of an attribute after a write
+void JournalStoredAttribute(ECharacterAttributeType AttributeType);
+
+// Journal session this manager last wrote its identity to
+uint32 JournalSession = 0;
+
+#pragma endregion
+
+#pragma region HudSnapshot
+
+public:
+// Returns the snapshot published at the last tick. The first call starts publishing for this character.
+UFUNCTION(BlueprintCallable, Category = "HUD")
+const FCharacterHudSnapshot& GetHudSnapshot();
+
+private:
+// Rebuilds the snapshot and bumps its version if anything changed
+void PublishHudSnapshot();
+
+FCharacterHudSnapshot HudSnapshot;
+bool bPublishHudSnapshot = false;
+
+#pragma endregion
+
+#pragma region MovementPush
+
+public:
+// Returns the parameters of the last push
+UFUNCTION(BlueprintCallable, Category = "Movement")
+const FCharacterMovementParameters& GetMovementParameters() const { return MovementParameters; }
+
+// Scales the speeds by the current Actuation relative to the Actuation the character starts with
+// (its archetype's, or the class default's), clamped to [0, 1]. Off by default.
+UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+bool bScaleSpeedByActuation = false;
+
+// Pushes the parameters at the next tick. Movement writes, Actuation changes and owner changes mark it automatically.
+void MarkMovementParametersDirty() { bMovementParametersDirty = true; }
+
+private:
+// Rebuilds the parameters and bumps the version if anything changed.
+// The manager owns MaxWalkSpeed, JumpZVelocity and NavAgentProps.bCanJump of the owner's movement component
+// and the owner's JumpMaxCount. They are written only when the parameters change or the owner is new,
+// so adjustments made by other systems in between are left alone.
+void PushMovementParameters();
+
+FCharacterMovementParameters MovementParameters;
+bool bMovementParametersDirty = true;
+
+// Owner the current parameters were last applied to
+TWeakObjectPtr<ACharacterModule> MovementParametersOwner;
+
+#pragma endregion
+
+#pragma region PublishedState
+
+public:
+// Returns the hot state published at the end of the last tick. Lock-free and safe from any thread,
+// as long as the caller keeps the manager alive (e.g. AI tasks holding a strong reference).
+FCharacterPublishedState ReadPublishedState() const { return PublishedState.Read(); }
+
+private:
+// Game thread only
+void PublishState();
+
+TCharacterSeqLock<FCharacterPublishedState> PublishedState;
+
+#pragma endregion
+
+#pragma region AtomicAttribute
+
+public:
+// Opt-in: primary attribute current values become atomics that any thread can change with
+// ApplyPrimaryAttributeDeltaAtomic. Enable before handing the manager to other threads.
+void EnableAtomicAttributes();
+void DisableAtomicAttributes();
+bool IsUsingAtomicAttributes() const { return bUseAtomicAttributes; }
+
+// Thread-safe clamped add on a primary attribute's current value. Returns the new value.
+// bOutCrossedMinimum is true for exactly one caller per crossing of the minimum value.
+// Health crossing its minimum enters the death state once, on the game thread at the next tick.
+// Game thread writes through SetPrimaryAttributeValueByType override concurrent deltas.
+float ApplyPrimaryAttributeDeltaAtomic(EPrimaryAttributeType AttributeType, float Delta, bool* bOutCrossedMinimum = nullptr);
+
+private:
+struct FAtomicPrimaryAttribute
+{
+std::atomic<float> MinimumValue = 0.f;
+std::atomic<float> MaximumValue = 0.f;
+std::atomic<float> CurrentValue = 0.f;
+};
+
+// Copies the stored values into the atomics after a write that bypassed them. Game thread only.
+void RefreshAtomicAttributes();
+
+// Game thread writes of a primary attribute
+void StoreAtomicAttribute(EPrimaryAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+// Writes concurrent deltas back to the stored values and publishes them. Game thread only.
+void CommitAtomicAttributes();
+
+// Current value in CharacterData or compact storage, bypassing the atomics
+float ReadStoredCurrentValue(ECharacterAttributeType AttributeType);
+
+bool bUseAtomicAttributes = false;
+FAtomicPrimaryAttribute AtomicAttributes[FCharacterPublishedState::NumPrimaryAttributes];
+
+// Bit per primary attribute changed by ApplyPrimaryAttributeDeltaAtomic since the last commit
+std::atomic<uint8> AtomicDirtyMask = 0;
+std::atomic<bool> bAtomicDeathPending = false;
+
+#pragma endregion
+
+#pragma region Threshold
+
+public:
+typedef void (*FThresholdHandler)(void* Context, const FCharacterThresholdCrossedEvent& Event);
+
+// Calls Handler only when the attribute moves into a different band. Boundaries must be ascending.
+// Normalized boundaries are fractions of the min/max range (0.25 = 25%), otherwise absolute values.
+// Handlers may subscribe and unsubscribe. A removed subscription is never called again, a new one is first
+// evaluated on the next change.
+FCharacterEventHandle SubscribeAttributeThresholds(ECharacterAttributeType AttributeType, TArrayView<const float> Boundaries, bool bNormalized, void* Context, FThresholdHandler Handler);
+
+// UObject contexts are tracked weakly, a destroyed object's handler is never called
+FCharacterEventHandle SubscribeAttributeThresholds(ECharacterAttributeType AttributeType, TArrayView<const float> Boundaries, bool bNormalized, UObject* Object, FThresholdHandler Handler);
+
+// Subscribes a member function: SubscribeAttributeThresholds<UMyWidget, &UMyWidget::HandleThreshold>(...)
+template <typename TObject, void (TObject::*Method)(const FCharacterThresholdCrossedEvent&)>
+FCharacterEventHandle SubscribeAttributeThresholds(ECharacterAttributeType AttributeType, TArrayView<const float> Boundaries, bool bNormalized, TObject* Object)
+{
+return SubscribeAttributeThresholds(AttributeType, Boundaries, bNormalized, Object, [](void* Context, const FCharacterThresholdCrossedEvent& Event) { (static_cast<TObject*>(Context)->*Method)(Event); });
+}
+
+void UnsubscribeAttributeThresholds(FCharacterEventHandle& Handle);
+
+private:
+struct FThresholdSubscription
+{
+TArray<float, TInlineAllocator<4>> Boundaries;
+ECharacterAttributeType AttributeType;
+bool bNormalized;
+int32 Band;
+void* Context;
+FThresholdHandler Handler;
+uint32 Id;
+
+// Set for UObject contexts
+FWeakObjectPtr Object;
+bool bTracked = false;
+};
+
+// Called from the attribute write path. Only re-evaluates bands when the value leaves the current one.
+void EvaluateAttributeThresholds(ECharacterAttributeType AttributeType, float MinValue, float MaxValue, float CurrentValue);
+
+static int32 FindThresholdBand(const FThresholdSubscription& Subscription, float MinValue, float MaxValue, float CurrentValue);
+
+// Removes the matching subscriptions, or only disables them while an evaluation is iterating the array
+void RemoveThresholdSubscriptions(TFunctionRef<bool(const FThresholdSubscription& Subscription)> Predicate);
+
+TArray<FThresholdSubscription> ThresholdSubscriptions;
+
+// Bit per ECharacterAttributeType that has at least one subscription
+uint16 ThresholdAttributeMask = 0;
+uint32 LastThresholdId = 0;
+
+// Set while EvaluateAttributeThresholds runs handlers, disabled subscriptions are removed when it returns
+bool bEvaluatingThresholds = false;
+bool bThresholdRemovalPending = false;
+
+#pragma endregion
+
+#pragma region ParallelUpdate
+
+public:
+// Updates many managers in two phases. Regeneration and cooldowns run in parallel and only touch
+// each manager's own data; delegates, replication, journaling and death run afterwards on the calling thread.
+// Sections still shared with an archetype or the class defaults are copied on the calling thread beforehand.
+// NumThreads limits the number of parallel tasks, 0 uses all worker threads.
+static void UpdateManagersParallel(TArrayView<UCharacterManager* const> Managers, float DeltaTime, int32 NumThreads = 0);
+
+private:
+// Serial phase before the parallel one. Takes ownership of the sections the parallel phase writes.
+void PrepareParallelUpdate();
+
+// Parallel phase. Must not touch other managers or any shared state.
+void SimulateParallelUpdate(float DeltaTime);
+
+// Serial phase. Publishes what the parallel phase changed.
+void CommitParallelUpdate();
+
+// Attributes and replication flags written by the parallel phase
+uint16 DeferredAttributeMask = 0;
+uint32 DeferredReplicationMask = CharacterDirtyFlags::None;
+
+#pragma endregion
+
+#pragma region AbilityScoring
+
+public:
+// Scores every ability of each query's caster against its target on worker threads.
+// OutChoices matches Queries by index. Game thread only.
+static void EvaluateAbilities(TArrayView<const FCharacterAbilityQuery> Queries, TArray<FCharacterAbilityChoice>& OutChoices);
+
+// Same without blocking. Inputs are copied now, so the choices reflect this frame.
+// OnComplete runs on the game thread.
+static void EvaluateAbilitiesAsync(TArrayView<const FCharacterAbilityQuery> Queries, TFunction<void(TArray<FCharacterAbilityChoice>&&)> OnComplete);
+
+private:
+// Copies what the scoring reads, game thread only
+static void GatherAbilityScoringInput(FCharacterAbilityScoringInput& Input, TArrayView<const FCharacterAbilityQuery> Queries);
+
 #pragma endregion
 
+#pragma region SimulationCore
+
+public:
+// Copies the state the engine-independent simulation core works on (CharacterSimulationCore.h)
+void ExportSimulationCharacter(CharacterSimulation::FCharacter& OutCharacter);
+
+CharacterSimulation::FProtection ExportSimulationProtection(EProtectionType Type);
+
+#pragma endregion
+
+};
+
+#pragma region ArchetypeArchive
+
+// Fixed-size header at the start of a cooked archetype archive
+struct FCharacterArchetypeArchiveHeader
+{
+uint32 Magic;
+uint16 Version;
+uint16 HotBlockSize; // sizeof(FCharacterArchetypeArchiveHotBlock) when cooked, archives of another layout are rejected
+uint32 ArchetypeCount;
+uint32 BucketCount;
+};
+
+// Open-addressing index entry. Size of zero marks an empty bucket.
+struct FCharacterArchetypeArchiveEntry
+{
+uint32 Key;
+uint32 Offset;
+uint32 Size;
+uint32 HotOffset;
+};
+
+// Sections without strings or arrays, stored in their in-memory layout so they are copied straight out of the mapping
+struct FCharacterArchetypeArchiveHotBlock
+{
+FCharacterAttribute AttributeData;
+FCharacterMovementData MovementData;
+ECharacterState State;
+ECharacterType Type;
 };
+
+static_assert(std::is_trivially_copyable_v<FCharacterArchetypeArchiveHotBlock>, "FCharacterArchetypeArchiveHotBlock is copied as raw bytes.");
+
+// Read-only, memory-mapped archive of cooked character archetypes.
+// The file is an index of open-addressing buckets followed by 8-byte aligned character snapshots, each with a hot block.
+// Lookups are O(1), hot sections are copied straight out of the mapped block and only strings and arrays are decoded.
+class NERBY_API FCharacterArchetypeArchive
+{
+public:
+static constexpr uint32 Magic = 0x41414D43; // 'CMAA'
+static constexpr uint16 Version = 2;
+
+FCharacterArchetypeArchive();
+~FCharacterArchetypeArchive();
+
+// Packs all archetypes into a single archive file. Intended to run offline at cook time.
+static bool Cook(const TMap<FName, FCharacterData>& Archetypes, const FString& Filename);
+
+// Returns the lookup key for an archetype id. Callers should cache the key.
+static uint32 MakeArchetypeKey(FName ArchetypeId);
+
+// Maps the archive file into memory
+bool Open(const FString& Filename);
+
+// Unmaps the archive
+void Close();
+
+bool IsOpen() const { return Header != nullptr; }
+int32 GetArchetypeCount() const { return Header ? Header->ArchetypeCount : 0; }
+
+// Returns the mapped snapshot of an archetype, or an empty view if it does not exist
+TArrayView<const uint8> FindArchetype(uint32 ArchetypeKey) const;
+
+// Copies an archetype into an existing character. State, type, attributes and movement come from the hot block,
+// the snapshot is only decoded when Information, Ability, Protection or Level are requested.
+bool InitializeCharacterData(uint32 ArchetypeKey, FCharacterData& OutData, ECharacterDataSection Sections = ECharacterDataSection::All) const;
+
+// Calls Visitor for every archetype key in the archive
+void ForEachArchetype(TFunctionRef<void(uint32 ArchetypeKey)> Visitor) const;
+
+private:
+// Returns the index entry of an archetype whose snapshot and hot block lie inside the mapping
+const FCharacterArchetypeArchiveEntry* FindEntry(uint32 ArchetypeKey) const;
+
+TUniquePtr<IMappedFileHandle> MappedHandle;
+TUniquePtr<IMappedFileRegion> MappedRegion;
+
+const uint8* MappedData = nullptr;
+int64 MappedSize = 0;
+
+const FCharacterArchetypeArchiveHeader* Header = nullptr;
+const FCharacterArchetypeArchiveEntry* Entries = nullptr;
+};
+
+#pragma endregion
+
+#pragma region Registry
+
+// Registered managers of one world, so worlds running side by side (PIE clients, editor previews)
+// never see, tick or report each other's characters
+UCLASS()
+class NERBY_API UCharacterManagerRegistrySubsystem : public UWorldSubsystem
+{
+GENERATED_BODY()
+
+public:
+const TArray<UCharacterManager*>& GetManagers() const { return Managers; }
+
+virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+virtual void Deinitialize() override;
+
+private:
+friend class UCharacterManager;
+
+// Runs the parallel update for the world's managers when CharacterManager.ParallelUpdate is set
+void HandleWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime);
+
+// Dense, managers keep their own index for swap removal
+TArray<UCharacterManager*> Managers;
+
+FDelegateHandle WorldTickStartHandle;
+};
+
+#pragma endregion
+
+#pragma region Pool
+
+// Keeps released managers alive so respawns reuse them instead of constructing new components
+UCLASS()
+class NERBY_API UCharacterManagerPoolSubsystem : public UWorldSubsystem
+{
+GENERATED_BODY()
+
+public:
+// Returns a registered manager owned by NewOwner, recycled from the pool when possible
+UCharacterManager* AcquireCharacterManager(ACharacterModule* NewOwner, const FCharacterArchetypePtr& InArchetype = nullptr);
+
+// Unregisters the manager from its owner and returns it to the pool
+void ReleaseCharacterManager(UCharacterManager* Manager);
+
+// Creates managers up front so the first deaths do not allocate
+void Prewarm(int32 Count);
+
+int32 GetPooledCount() const { return PooledManagers.Num(); }
+
+virtual void Deinitialize() override;
+
+private:
+UPROPERTY(Transient)
+TArray<TObjectPtr<UCharacterManager>> PooledManagers;
+};
+
+#pragma endregion
+
+#pragma region Journal
+
+// Kinds of records in a character journal
+enum class ECharacterJournalEvent : uint8
+{
+// Maps a character id to its owner name for the current session
+Identity,
+// SubType: ECharacterAttributeType | Values: min, max, current
+AttributeSet,
+// Instigator: attacker | Values: incoming damage, protection, final damage
+Damage,
+// SubType: new ECharacterState | Values: previous state
+StateChange,
+// Values: amount
+Experience,
+// Values: new level
+LevelUp
+};
+
+// Fixed-size part of a journal record. Identity records are followed by PayloadSize bytes of UTF-8 name.
+struct FCharacterJournalRecord
+{
+int64 UtcTicks = 0;
+uint32 CharacterId = 0;
+uint32 InstigatorId = 0;
+ECharacterJournalEvent Event = ECharacterJournalEvent::Identity;
+uint8 SubType = 0;
+uint16 PayloadSize = 0;
+float Values[3] = {};
+};
+
+static_assert(sizeof(FCharacterJournalRecord) == 32, "Journal records are written to disk as-is");
+
+// Append-only binary journal of character mutations for audits and replays.
+// Records are appended to a per-thread chunk without locking. Full chunks are handed to a
+// lock-free queue and written to disk by a background thread. Every thread's chunk is registered,
+// so partially filled chunks of worker threads are flushed too and submitted when the thread exits.
+class NERBY_API FCharacterJournal
+{
+public:
+static constexpr uint32 Magic = 0x4C4E524A; // 'JRNL'
+static constexpr uint32 Version = 1;
+
+// Opens the journal file and starts the writer thread
+static bool Start(const FString& Filename);
+
+// Flushes every thread, drains the queue and closes the file.
+// Only records appended while Stop runs may be dropped.
+static void Stop();
+
+static bool IsRecording() { return bRecording.load(std::memory_order_relaxed); }
+
+// Incremented by every Start, so characters know when to write their identity again
+static uint32 GetSession() { return Session.load(std::memory_order_relaxed); }
+
+static void Record(ECharacterJournalEvent Event, uint32 CharacterId, uint32 InstigatorId, uint8 SubType, float Value0, float Value1, float Value2);
+
+static void RecordIdentity(uint32 CharacterId, const FString& Name);
+
+// Hands every thread's chunk to the writer. Called at the end of every game thread frame.
+static void Flush();
+
+// Reads a journal file offline. Name is the identity of the record's character, if known.
+static bool Read(const FString& Filename, TFunctionRef<void(const FCharacterJournalRecord& Record, const FString& Name)> Visitor);
+
+private:
+static void Append(const void* Data, int32 Size);
+
+static std::atomic<bool> bRecording;
+static std::atomic<uint32> Session;
+};
+
+// Offline reader: -run=CharacterJournal -File=<path> [-Character=<name>] [-From=<time>] [-To=<time>]
+// Times use FDateTime::Parse format, e.g. 2026.01.31-18.30.00 (UTC).
+UCLASS()
+class NERBY_API UCharacterJournalCommandlet : public UCommandlet
+{
+GENERATED_BODY()
+
+public:
+virtual int32 Main(const FString& Params) override;
+};
+
+#pragma endregion
+
+#pragma region BattleSimulator
+
+// Headless Monte Carlo fights with the default character data (CharacterBattleSimulator.h):
+// -run=CharacterBattleSimulator [-Fights=1000000] [-Team0=1] [-Team1=1] [-Threads=0] [-Seed=1]
+// [-Duration=120] [-Step=0.1] [-Protection=<EProtectionType name>]
+// Damage abilities can be tuned per team with Min,Max ranges, e.g. -Team1.CombatStrike.Power=20,30
+// -Team0.LaserPulse.Cost=5,10 -Team0.LaserPulse.Cooldown=4,6. Fighters never cast abilities without damage such as
+// PlasmaShield, so switches for them are rejected.
+UCLASS()
+class NERBY_API UCharacterBattleSimulatorCommandlet : public UCommandlet
+{
+GENERATED_BODY()
+
+public:
+virtual int32 Main(const FString& Params) override;
+};
+
+#pragma endregion
@@ -0,0 +1,202 @@
+#include "CharacterSimulationCore.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CharacterSimulation
+{
+
+FRandom::FRandom(uint64_t Seed)
+: State(0)
+{
+NextUInt();
+State += Seed;
+NextUInt();
+}
+
+uint32_t FRandom::NextUInt()
+{
+const uint64_t OldState = State;
+State = OldState * 6364136223846793005ull + 1442695040888963407ull;
+
+const uint32_t XorShifted = static_cast<uint32_t>(((OldState >> 18u) ^ OldState) >> 27u);
+const uint32_t Rotation = static_cast<uint32_t>(OldState >> 59u);
+return (XorShifted >> Rotation) | (XorShifted << ((32u - Rotation) & 31u));
+}
+
+float FRandom::NextFloat()
+{
+// 24 random mantissa bits
+return static_cast<float>(NextUInt() >> 8) * (1.f / 16777216.f);
+}
+
+float FRandom::RandRange(float Min, float Max)
+{
+return Min + (Max - Min) * NextFloat();
+}
+
+float RegenerateAttribute(const FAttribute& Attribute, float DeltaTime)
+{
+if (Attribute.CurrentValue >= Attribute.MaximumValue)
+{
+return Attribute.CurrentValue;
+}
+
+return Attribute.CurrentValue + DeltaTime * Attribute.RegenerateValue;
+}
+
+float UpdateCooldown(float CooldownTimer, float DeltaTime)
+{
+if (CooldownTimer > 0.f)
+{
+CooldownTimer -= DeltaTime;
+
+if (CooldownTimer < 0.f)
+{
+CooldownTimer = 0.f;
+}
+}
+
+return CooldownTimer;
+}
+
+float ComputeFinalDamage(float Damage, float Protection)
+{
+return std::max(Damage - Protection, 0.0f);
+}
+
+FDamageResult ApplyDamage(const FAttribute& Health, float Damage, float Protection)
+{
+FDamageResult Result;
+Result.FinalDamage = ComputeFinalDamage(Damage, Protection);
+Result.NewHealth = std::min(std::max(Health.CurrentValue - Result.FinalDamage, Health.MinimumValue), Health.MaximumValue);
+Result.bKilled = Result.NewHealth <= 0.0f;
+return Result;
+}
+
+float RollProtection(const FProtection& Protection, FRandom& Random)
+{
+const float BaseProtection = Protection.Value * Protection.Multiplier;
+return Random.RandRange(BaseProtection, BaseProtection * Protection.Amplifier);
+}
+
+float RollAbilityPower(const FAbility& Ability, FRandom& Random)
+{
+return Random.RandRange(Ability.PowerMin, Ability.PowerMax);
+}
+
+float RollAbilityCost(const FAbility& Ability, FRandom& Random)
+{
+return Random.RandRange(Ability.CostMin, Ability.CostMax);
+}
+
+float RollAbilityCooldownTime(const FAbility& Ability, FRandom& Random)
+{
+return Random.RandRange(Ability.CooldownTimeMin, Ability.CooldownTimeMax);
+}
+
+std::vector<float> BuildExperienceThresholds(int32_t MaxLevel)
+{
+std::vector<float> ExperienceThreshold;
+
+const int32_t NumSegments = 10;
+const float BaseStep = 100.f; // Level 1 starts at 101
+const float StepMultiplier = 1.1f;
+
+ExperienceThreshold.push_back(0); // Level 0
+
+const int32_t LevelsPerSegment = MaxLevel / NumSegments;
+float CurrentThreshold = 0.f;
+float CurrentStep = BaseStep;
+
+// Rounded to the nearest 10 like FMath::RoundToInt
+const auto RoundThreshold = [](float Threshold)
+{
+return static_cast<float>(static_cast<int32_t>(std::floor(Threshold / 10.f + 0.5f)) * 10);
+};
+
+for (int32_t Segment = 0; Segment < NumSegments; ++Segment)
+{
+for (int32_t LevelInSegment = 0; LevelInSegment < LevelsPerSegment; ++LevelInSegment)
+{
+CurrentThreshold += CurrentStep;
+ExperienceThreshold.push_back(RoundThreshold(CurrentThreshold));
+}
+
+CurrentStep *= StepMultiplier;
+}
+
+// Fill remaining levels if MaxLevel not divisible by segments
+const int32_t RemainingLevels = MaxLevel - (static_cast<int32_t>(ExperienceThreshold.size()) - 1);
+
+for (int32_t Index = 0; Index < RemainingLevels; ++Index)
+{
+CurrentThreshold += CurrentStep;
+ExperienceThreshold.push_back(RoundThreshold(CurrentThreshold));
+}
+
+return ExperienceThreshold;
+}
+
+FExperienceResult AddExperience(const FLevel& Level, float Amount)
+{
+FExperienceResult Result;
+Result.Experience = Level.Experience;
+
+if (Level.Level < 0 || Level.Level >= static_cast<int32_t>(Level.ExperienceThreshold.size()))
+{
+return Result;
+}
+
+Result.bValid = true;
+
+int32_t CurrentLevel = Level.Level;
+float RemainingExperience = Amount;
+
+// Handles multiple level-ups if enough experience is provided
+while (RemainingExperience > 0.0f && CurrentLevel < Level.MaxLevel && CurrentLevel < static_cast<int32_t>(Level.ExperienceThreshold.size()))
+{
+const float ExperienceToLevelUp = Level.ExperienceThreshold[CurrentLevel] - Result.Experience;
+
+if (RemainingExperience >= ExperienceToLevelUp)
+{
+RemainingExperience -= ExperienceToLevelUp;
+Result.Experience = 0.0f;
+
+++CurrentLevel;
+++Result.LevelsGained;
+}
+else
+{
+Result.Experience += RemainingExperience;
+RemainingExperience = 0.0f;
+}
+}
+
+return Result;
+}
+
+void TickCharacter(FCharacter& Character, float DeltaTime)
+{
+for (const EAttribute Type : RegeneratedAttributes)
+{
+FAttribute& Attribute = Character.GetAttribute(Type);
+
+if (Attribute.bEnableUpdate)
+{
+Attribute.CurrentValue = RegenerateAttribute(Attribute, DeltaTime);
+}
+}
+
+for (FAbility& Ability : Character.Abilities)
+{
+Ability.CooldownTimer = UpdateCooldown(Ability.CooldownTimer, DeltaTime);
+}
+
+if (Character.GetAttribute(EAttribute::Health).CurrentValue <= 0.0f)
+{
+Character.bDead = true;
+}
+}
+
+}
@@ -0,0 +1,184 @@
+// ============================================================================
+// CharacterSimulationCore.h
+// ============================================================================
+// Engine-independent combat rules used by UCharacterManager:
+//
+// - Attribute regeneration and clamping
+// - Damage after protection and the death rule
+// - Protection and ability rolls
+// - Experience curve and level ups
+// - Ability cooldowns
+//
+// Plain C++17 with the standard library only, so headless simulators and
+// benchmarks can link it on any platform. UCharacterManager converts its data
+// with ExportSimulationCharacter and calls the same functions, which keeps the
+// results of both identical.
+// ============================================================================
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CharacterSimulation
+{
+
+// Same order as ECharacterAttributeType
+enum class EAttribute : uint8_t
+{
+Null,
+Health,
+Stamina,
+Energy,
+Shield,
+Output,
+Actuation,
+Integrity,
+Capacity,
+Regeneration,
+Max
+};
+
+// Same order as EAbilityCostType
+enum class ECostPool : uint8_t
+{
+Null,
+Health,
+Stamina,
+Energy,
+Shield,
+Max
+};
+
+// Same order as ECharacterAbilityType without Null
+enum class EAbility : uint8_t
+{
+CombatStrike,
+LaserPulse,
+PlasmaShield,
+Max
+};
+
+struct FAttribute
+{
+float MinimumValue = 0.f;
+float MaximumValue = 100.f;
+float CurrentValue = 100.f;
+float RegenerateValue = 1.f;
+bool bEnableUpdate = true;
+};
+
+struct FAbility
+{
+float PowerMin = 0.f;
+float PowerMax = 0.f;
+float CooldownTimeMin = 0.f;
+float CooldownTimeMax = 0.f;
+float CostMin = 0.f;
+float CostMax = 0.f;
+float Range = 0.f;
+ECostPool CostPool = ECostPool::Null;
+bool bDealsDamage = false;
+
+// Runtime cooldown timer
+float CooldownTimer = 0.f;
+
+bool IsOnCooldown() const { return CooldownTimer > 0.f; }
+};
+
+// A protection roll lies in [Value * Multiplier, Value * Multiplier * Amplifier]
+struct FProtection
+{
+float Value = 0.f;
+float Multiplier = 1.f;
+float Amplifier = 1.f;
+};
+
+struct FLevel
+{
+float Experience = 0.f;
+int32_t Level = 0;
+int32_t MaxLevel = 100;
+
+// Experience needed to leave each level, index 0 is level 0
+std::vector<float> ExperienceThreshold;
+};
+
+struct FCharacter
+{
+std::array<FAttribute, static_cast<std::size_t>(EAttribute::Max)> Attributes;
+std::array<FAbility, static_cast<std::size_t>(EAbility::Max)> Abilities;
+FLevel Level;
+bool bDead = false;
+
+FAttribute& GetAttribute(EAttribute Type) { return Attributes[static_cast<std::size_t>(Type)]; }
+const FAttribute& GetAttribute(EAttribute Type) const { return Attributes[static_cast<std::size_t>(Type)]; }
+FAbility& GetAbility(EAbility Type) { return Abilities[static_cast<std::size_t>(Type)]; }
+const FAbility& GetAbility(EAbility Type) const { return Abilities[static_cast<std::size_t>(Type)]; }
+};
+
+// Small deterministic generator (PCG32), so simulations can be replayed from a seed
+class FRandom
+{
+public:
+explicit FRandom(uint64_t Seed = 0x853c49e6748fea9bull);
+
+uint32_t NextUInt();
+
+// Uniform in [0, 1)
+float NextFloat();
+
+// Uniform in [Min, Max]
+float RandRange(float Min, float Max);
+
+private:
+uint64_t State;
+};
+
+// Primary attributes regenerated by the tick, in update order
+constexpr EAttribute RegeneratedAttributes[] = { EAttribute::Health, EAttribute::Energy, EAttribute::Shield, EAttribute::Stamina };
+
+// Value after regenerating for DeltaTime. A full attribute is left as is; one step may pass the maximum.
+float RegenerateAttribute(const FAttribute& Attribute, float DeltaTime);
+
+// Counts down a cooldown timer, never below zero
+float UpdateCooldown(float CooldownTimer, float DeltaTime);
+
+// Damage left after protection
+float ComputeFinalDamage(float Damage, float Protection);
+
+struct FDamageResult
+{
+float FinalDamage = 0.f;
+float NewHealth = 0.f;
+bool bKilled = false;
+};
+
+// Health after a hit, clamped to its range. Health at or below zero kills.
+FDamageResult ApplyDamage(const FAttribute& Health, float Damage, float Protection);
+
+float RollProtection(const FProtection& Protection, FRandom& Random);
+float RollAbilityPower(const FAbility& Ability, FRandom& Random);
+float RollAbilityCost(const FAbility& Ability, FRandom& Random);
+float RollAbilityCooldownTime(const FAbility& Ability, FRandom& Random);
+
+// Thresholds of the default experience curve
+std::vector<float> BuildExperienceThresholds(int32_t MaxLevel);
+
+struct FExperienceResult
+{
+// False when the thresholds do not cover the current level; nothing was applied
+bool bValid = false;
+int32_t LevelsGained = 0;
+float Experience = 0.f;
+};
+
+// Levels gained and experience left over after adding Amount
+FExperienceResult AddExperience(const FLevel& Level, float Amount);
+
+// Regenerates attributes, counts down cooldowns and applies the death rule
+void TickCharacter(FCharacter& Character, float DeltaTime);
+
+}